@@ -0,0 +1,133 @@
+#include <new>
+#include <stdlib.h>
+#include <QtGlobal>
+#include "allocationcounter.h"
+
+#ifdef __GLIBC__
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+}
+#endif
+
+namespace
+{
+
+QBasicAtomicInt allocations = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+inline void *allocate(size_t size)
+{
+    allocations.fetchAndAddRelaxed(1);
+#ifdef __GLIBC__
+    return __libc_malloc(size ? size : 1);
+#else
+    return ::malloc(size ? size : 1);
+#endif
+}
+
+}   // namespace
+
+int allocationCount()
+{
+    return allocations.load();
+}
+
+bool countsMalloc()
+{
+#ifdef __GLIBC__
+    return true;
+#else
+    return false;
+#endif
+}
+
+// operator new does not go through the malloc() below, so that nothing is
+// counted twice.
+
+void *operator new(size_t size)
+{
+    void *p = allocate(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    void *p = allocate(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) Q_DECL_NOTHROW
+{
+    return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) Q_DECL_NOTHROW
+{
+    return allocate(size);
+}
+
+void operator delete(void *p) Q_DECL_NOTHROW
+{
+    ::free(p);
+}
+
+void operator delete[](void *p) Q_DECL_NOTHROW
+{
+    ::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) Q_DECL_NOTHROW
+{
+    ::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) Q_DECL_NOTHROW
+{
+    ::free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *p, size_t) Q_DECL_NOTHROW
+{
+    ::free(p);
+}
+
+void operator delete[](void *p, size_t) Q_DECL_NOTHROW
+{
+    ::free(p);
+}
+#endif
+
+#ifdef __GLIBC__
+
+// Symbols in the executable take precedence over the C library's, for the
+// Qt libraries too. free() is left alone, as the memory comes from the C
+// library's allocator either way.
+extern "C" {
+
+void *malloc(size_t size) __THROW
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) __THROW
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) __THROW
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_realloc(p, size);
+}
+
+}   // extern "C"
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QString>
+#include <QtTest>
+
+// Heap allocations made by the process so far. allocationcounter.cpp
+// replaces the global operator new, and on glibc also interposes malloc(),
+// calloc() and realloc(), which is where Qt's own containers get their
+// memory. Elsewhere only operator new is counted, so counts are too low,
+// and countsMalloc() returns false for the tests to skip themselves.
+int allocationCount();
+bool countsMalloc();
+
+class AllocationCounter
+{
+    int start;
+
+public:
+    inline AllocationCounter() : start(allocationCount()) {}
+
+    inline int count() const { return allocationCount() - start; }
+    inline void restart() { start = allocationCount(); }
+};
+
+inline QString allocationMessage(int count, int budget, const char *expr)
+{
+    return QString("%1 allocations, budget is %2 (%3)")
+            .arg(count).arg(budget).arg(QLatin1String(expr));
+}
+
+// Fails the test if more allocations were made since the counter started
+// than the budget allows, reporting both, and restarts the counter.
+#define QVERIFY_ALLOCATIONS(counter, budget) \
+    do { \
+        const int count_ = (counter).count(); \
+        QVERIFY2(count_ <= int(budget), \
+                 qPrintable(allocationMessage(count_, int(budget), \
+                                              #budget))); \
+        (counter).restart(); \
+    } while (false)
+
+#endif  // ALLOCATIONCOUNTER_H
@@ -0,0 +1,30 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET    = qtcollectionsallocations
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TEMPLATE  = app
+
+include(../qtcollections.pri)
+
+DEFINES += QTCOLLECTIONS_STATIC
+
+INCLUDEPATH += $$PWD/../src
+
+# Link to the instantiations built into the library instead of repeating
+# them.
+LIBS += -L$$OUT_PWD/$$DESTDIR -lqtcollections
+unix:QMAKE_RPATHDIR += $$OUT_PWD/$$DESTDIR
+DEFINES += QTCOLLECTIONS_EXTERN_TEMPLATES
+
+SOURCES += \
+    allocation_main.cpp \
+    allocationcounter.cpp \
+    orderedhashallocations.cpp
+
+HEADERS += \
+    allocationcounter.h \
+    orderedhashallocations.h
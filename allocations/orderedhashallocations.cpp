@@ -0,0 +1,334 @@
+#include "orderedhashallocations.h"
+#include "allocationcounter.h"
+#include "groupprobing.h"
+#include "orderedhash.h"
+
+using qtcollections::GroupProbing;
+using qtcollections::OrderedHash;
+
+typedef OrderedHash<QString, int> NodeHash;
+typedef OrderedHash<int, int> FlatHash;
+typedef OrderedHash<QString, int, GroupProbing<> > GroupHash;
+
+namespace
+{
+
+enum Engine
+{
+    NodeEngine,
+    FlatEngine,
+    GroupEngine
+};
+
+const int Size = 4096;
+
+// Per-entry allocations of the node engine: a node in each of its two
+// QHashes, and one in its QLinkedList. The other engines make none.
+template <typename Hash>
+inline int perEntry() { return 0; }
+
+template <>
+inline int perEntry<NodeHash>() { return 3; }
+
+inline void makeKey(int i, QString *key) { *key = QString::number(i); }
+inline void makeKey(int i, int *key) { *key = i * 7919; }
+
+// Keys are made up front, so that making them is not counted.
+template <typename Hash>
+QVector<typename Hash::key_type> makeKeys(int first, int n)
+{
+    QVector<typename Hash::key_type> keys(n);
+    for (int i = 0; i < n; i++)
+        makeKey(first + i, &keys[i]);
+    return keys;
+}
+
+template <typename Hash>
+void fill(Hash &hash, const QVector<typename Hash::key_type> &keys)
+{
+    for (int i = 0; i < keys.size(); i++)
+        hash.insert(keys.at(i), i);
+}
+
+template <typename Hash>
+void lookup()
+{
+    const QVector<typename Hash::key_type> keys = makeKeys<Hash>(0, Size);
+    const QVector<typename Hash::key_type> absent =
+            makeKeys<Hash>(Size, Size);
+    Hash hash;
+    fill(hash, keys);
+    const Hash &constHash = hash;
+
+    AllocationCounter allocations;
+    int sum = 0;
+    for (int i = 0; i < Size; i++)
+    {
+        sum += hash.contains(keys.at(i));
+        sum += hash.value(keys.at(i));
+        sum += constHash[keys.at(i)];
+        sum += constHash.constFind(keys.at(i)).value();
+        sum += hash.find(keys.at(i)).value();
+        sum += hash.contains(absent.at(i));
+        sum += hash.value(absent.at(i), -1);
+    }
+    QVERIFY_ALLOCATIONS(allocations, 0);
+    QVERIFY(sum != 0);
+}
+
+template <typename Hash>
+void iteration()
+{
+    Hash hash;
+    fill(hash, makeKeys<Hash>(0, Size));
+    const Hash &constHash = hash;
+
+    AllocationCounter allocations;
+    int sum = 0;
+    for (typename Hash::const_iterator it = constHash.constBegin();
+         it != constHash.constEnd(); ++it)
+        sum += it.value();
+    for (typename Hash::key_iterator it = constHash.keyBegin();
+         it != constHash.keyEnd(); ++it)
+        sum += constHash.value(*it);
+    for (typename Hash::iterator it = hash.begin(); it != hash.end(); ++it)
+        it.value()++;
+    for (typename Hash::iterator it = hash.end(); it != hash.begin(); )
+        sum += (--it).value();
+    QVERIFY_ALLOCATIONS(allocations, 0);
+    QVERIFY(sum != 0);
+}
+
+template <typename Hash>
+void update()
+{
+    const QVector<typename Hash::key_type> keys = makeKeys<Hash>(0, Size);
+    Hash hash;
+    fill(hash, keys);
+
+    AllocationCounter allocations;
+    for (int i = 0; i < Size; i++)
+        hash.insert(keys.at(i), -i);
+    for (int i = 0; i < Size; i++)
+        hash[keys.at(i)] += i;
+    QVERIFY_ALLOCATIONS(allocations, 0);
+}
+
+// Growing the index and the entries takes O(log n) allocations in all, on
+// top of the entries' own.
+template <typename Hash>
+void insert()
+{
+    const QVector<typename Hash::key_type> keys = makeKeys<Hash>(0, Size);
+
+    AllocationCounter allocations;
+    {
+        Hash hash;
+        fill(hash, keys);
+    }
+    QVERIFY_ALLOCATIONS(allocations, perEntry<Hash>() * Size + 96);
+}
+
+template <typename Hash>
+void insertReserved()
+{
+    const QVector<typename Hash::key_type> keys = makeKeys<Hash>(0, Size);
+    Hash hash;
+    hash.reserve(Size);
+
+    AllocationCounter allocations;
+    fill(hash, keys);
+    QVERIFY_ALLOCATIONS(allocations, perEntry<Hash>() * Size);
+}
+
+// Removing a few entries neither shrinks nor compacts anything.
+template <typename Hash>
+void remove()
+{
+    const QVector<typename Hash::key_type> keys = makeKeys<Hash>(0, Size);
+    Hash hash;
+    fill(hash, keys);
+
+    AllocationCounter allocations;
+    for (int i = 0; i < Size; i += Size / 16)
+        hash.remove(keys.at(i));
+    hash.erase(hash.begin());
+    QVERIFY_ALLOCATIONS(allocations, 0);
+    QCOMPARE(hash.size(), Size - 17);
+}
+
+// The node engine rebuilds its key list and reverse index for the copy.
+// The others share their vectors with the original until either changes.
+template <typename Hash>
+void copy()
+{
+    Hash hash;
+    fill(hash, makeKeys<Hash>(0, Size));
+
+    AllocationCounter allocations;
+    int size;
+    {
+        Hash other(hash);
+        size = other.size();
+    }
+    QVERIFY_ALLOCATIONS(allocations, perEntry<Hash>() * Size + 16);
+    QCOMPARE(size, Size);
+}
+
+template <typename Hash>
+void keysAndValues()
+{
+    Hash hash;
+    fill(hash, makeKeys<Hash>(0, Size));
+
+    AllocationCounter allocations;
+    const QList<typename Hash::key_type> keys = hash.keys();
+    QVERIFY_ALLOCATIONS(allocations, 1);
+    const QList<int> values = hash.values();
+    QVERIFY_ALLOCATIONS(allocations, 1);
+    QCOMPARE(keys.size(), Size);
+    QCOMPARE(values.size(), Size);
+}
+
+// Moving every entry to the end in turn. The flat and group-probing
+// engines move each into the hole the one before left behind.
+template <typename Hash>
+void nodes()
+{
+    Hash hash;
+    fill(hash, makeKeys<Hash>(0, Size));
+    const typename Hash::key_type first = hash.firstKey();
+
+    AllocationCounter allocations;
+    for (int i = 0; i < Size; i++)
+    {
+        typename Hash::Node node = hash.extract(hash.begin());
+        hash.insert(node);
+    }
+    QVERIFY_ALLOCATIONS(allocations, perEntry<Hash>() * Size + 16);
+    QCOMPARE(hash.firstKey(), first);
+}
+
+}   // namespace
+
+// Runs function<Hash>() with the hash type of the current engine.
+#define FOR_ENGINE(function) \
+    QFETCH(int, engine); \
+    if (engine == NodeEngine) \
+        function<NodeHash>(); \
+    else if (engine == FlatEngine) \
+        function<FlatHash>(); \
+    else \
+        function<GroupHash>()
+
+// Qt's containers allocate through malloc(), so where it is not counted
+// every budget would be met whatever the engines did. Skip rather than pass.
+void OrderedHashAllocations::initTestCase()
+{
+    if (countsMalloc())
+        return;
+#if QT_VERSION >= 0x050000
+    QSKIP("malloc() is not counted on this platform, only operator new");
+#else
+    QSKIP("malloc() is not counted on this platform, only operator new",
+          SkipAll);
+#endif
+}
+
+void OrderedHashAllocations::engines()
+{
+    QTest::addColumn<int>("engine");
+    QTest::newRow("node") << int(NodeEngine);
+    QTest::newRow("flat") << int(FlatEngine);
+    QTest::newRow("group") << int(GroupEngine);
+}
+
+void OrderedHashAllocations::testLookup_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testLookup()
+{
+    FOR_ENGINE(lookup);
+}
+
+void OrderedHashAllocations::testIteration_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testIteration()
+{
+    FOR_ENGINE(iteration);
+}
+
+void OrderedHashAllocations::testUpdate_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testUpdate()
+{
+    FOR_ENGINE(update);
+}
+
+void OrderedHashAllocations::testInsert_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testInsert()
+{
+    FOR_ENGINE(insert);
+}
+
+void OrderedHashAllocations::testInsertReserved_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testInsertReserved()
+{
+    FOR_ENGINE(insertReserved);
+}
+
+void OrderedHashAllocations::testRemove_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testRemove()
+{
+    FOR_ENGINE(remove);
+}
+
+void OrderedHashAllocations::testCopy_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testCopy()
+{
+    FOR_ENGINE(copy);
+}
+
+void OrderedHashAllocations::testKeysAndValues_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testKeysAndValues()
+{
+    FOR_ENGINE(keysAndValues);
+}
+
+void OrderedHashAllocations::testNodes_data()
+{
+    engines();
+}
+
+void OrderedHashAllocations::testNodes()
+{
+    FOR_ENGINE(nodes);
+}
@@ -0,0 +1,38 @@
+#ifndef ORDEREDHASHALLOCATIONS_H
+#define ORDEREDHASHALLOCATIONS_H
+
+#include <QtTest>
+
+// Heap allocations made by OrderedHash operations, against budgets, with
+// each engine: node (QString keys), flat (int keys) and group probing.
+class OrderedHashAllocations : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testLookup_data();
+    void testLookup();
+    void testIteration_data();
+    void testIteration();
+    void testUpdate_data();
+    void testUpdate();
+    void testInsert_data();
+    void testInsert();
+    void testInsertReserved_data();
+    void testInsertReserved();
+    void testRemove_data();
+    void testRemove();
+    void testCopy_data();
+    void testCopy();
+    void testKeysAndValues_data();
+    void testKeysAndValues();
+    void testNodes_data();
+    void testNodes();
+
+private:
+    void engines();
+};
+
+#endif  // ORDEREDHASHALLOCATIONS_H
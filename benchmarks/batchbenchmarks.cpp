@@ -0,0 +1,111 @@
+#include "batchbenchmarks.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include "groupprobing.h"
+
+using qtcollections::GroupProbing;
+using qtcollections::OrderedHash;
+
+namespace
+{
+
+const int Count = 8000000;
+const int Lookups = 4000000;
+const int BatchSize = 256;
+
+template <typename Key, typename Hasher>
+void lookup(const QVector<Key> &keys, bool batched)
+{
+    OrderedHash<Key, int, Hasher> hash;
+    for (int i = 0; i < keys.size(); i++)
+        hash.insert(keys.at(i), i);
+
+    // Random keys, about one in four of them missing, split into batches
+    // up front so that only the lookups are timed.
+    QVector<QVector<Key> > batches(Lookups / BatchSize);
+    quint32 state = 12345;
+    for (int i = 0; i < batches.size(); i++)
+    {
+        batches[i].resize(BatchSize);
+        for (int j = 0; j < BatchSize; j++)
+        {
+            state = state * 1664525u + 1013904223u;
+            const int k = int(state % quint32(keys.size()));
+            batches[i][j] = (state >> 30) ? keys.at(k) : Key();
+        }
+    }
+
+    QVector<int> values(BatchSize);
+    qint64 sum = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE
+    {
+        for (int i = 0; i < batches.size(); i++)
+        {
+            const QVector<Key> &batch = batches.at(i);
+            if (batched)
+            {
+                hash.valuesFor(batch, values.begin(), -1);
+            }
+            else
+            {
+                for (int j = 0; j < BatchSize; j++)
+                    values[j] = hash.value(batch.at(j), -1);
+            }
+            for (int j = 0; j < BatchSize; j++)
+                sum += values.at(j);
+        }
+    }
+    qDebug("%.1f ns per lookup", double(timer.nsecsElapsed()) / Lookups);
+    QVERIFY(sum != 0);
+}
+
+void addRows()
+{
+    QTest::addColumn<bool>("group");
+    QTest::addColumn<bool>("batched");
+    QTest::newRow("default, value()") << false << false;
+    QTest::newRow("default, valuesFor()") << false << true;
+    QTest::newRow("group, value()") << true << false;
+    QTest::newRow("group, valuesFor()") << true << true;
+}
+
+}   // namespace
+
+void BatchBenchmarks::lookupIntKeys_data()
+{
+    addRows();
+}
+
+void BatchBenchmarks::lookupIntKeys()
+{
+    QFETCH(bool, group);
+    QFETCH(bool, batched);
+    // Keys start at one, so the default-constructed key is always a miss.
+    QVector<int> keys(Count);
+    for (int i = 0; i < Count; i++)
+        keys[i] = i * 7 + 1;
+    if (group)
+        lookup<int, GroupProbing<> >(keys, batched);
+    else
+        lookup<int, qtcollections::DefaultHashPolicy>(keys, batched);
+}
+
+void BatchBenchmarks::lookupStringKeys_data()
+{
+    addRows();
+}
+
+void BatchBenchmarks::lookupStringKeys()
+{
+    QFETCH(bool, group);
+    QFETCH(bool, batched);
+    QVector<QString> keys(Count);
+    for (int i = 0; i < Count; i++)
+        keys[i] = QString::number(i * 7 + 1);
+    if (group)
+        lookup<QString, GroupProbing<> >(keys, batched);
+    else
+        lookup<QString, qtcollections::DefaultHashPolicy>(keys, batched);
+}
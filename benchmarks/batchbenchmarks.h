@@ -0,0 +1,19 @@
+#ifndef BATCHBENCHMARKS_H
+#define BATCHBENCHMARKS_H
+
+#include <QtTest>
+
+// A loop of value() against valuesFor(), resolving batches of random keys
+// against hashes well beyond the size of the last-level cache.
+class BatchBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void lookupIntKeys_data();
+    void lookupIntKeys();
+    void lookupStringKeys_data();
+    void lookupStringKeys();
+};
+
+#endif  // BATCHBENCHMARKS_H
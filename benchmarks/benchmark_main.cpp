@@ -0,0 +1,31 @@
+#include <QCoreApplication>
+#include "batchbenchmarks.h"
+#include "growthbenchmarks.h"
+#include "hashpolicybenchmarks.h"
+#include "probingbenchmarks.h"
+#if QT_VERSION >= 0x050000
+#include "jsonbenchmarks.h"
+#endif
+
+#define RUN(klass, argc, argv) \
+    { \
+        klass *obj = new klass(); \
+        status |= QTest::qExec(obj, argc, argv); \
+        delete obj; \
+    }
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    Q_UNUSED(app);
+
+    int status = 0;
+    RUN(GrowthBenchmarks, argc, argv)
+#if QT_VERSION >= 0x050000
+    RUN(JsonBenchmarks, argc, argv)
+#endif
+    RUN(HashPolicyBenchmarks, argc, argv)
+    RUN(ProbingBenchmarks, argc, argv)
+    RUN(BatchBenchmarks, argc, argv)
+    return status;
+}
@@ -0,0 +1,39 @@
+QT       += testlib
+
+QT       -= gui
+
+TARGET    = qtcollectionsbenchmark
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TEMPLATE  = app
+
+include(../qtcollections.pri)
+
+DEFINES += QTCOLLECTIONS_STATIC
+
+INCLUDEPATH += $$PWD/../src
+
+# Link to the instantiations built into the library instead of repeating
+# them.
+LIBS += -L$$OUT_PWD/$$DESTDIR -lqtcollections
+unix:QMAKE_RPATHDIR += $$OUT_PWD/$$DESTDIR
+DEFINES += QTCOLLECTIONS_EXTERN_TEMPLATES
+
+SOURCES += \
+    benchmark_main.cpp \
+    batchbenchmarks.cpp \
+    growthbenchmarks.cpp \
+    hashpolicybenchmarks.cpp \
+    probingbenchmarks.cpp
+
+HEADERS += \
+    batchbenchmarks.h \
+    growthbenchmarks.h \
+    hashpolicybenchmarks.h \
+    probingbenchmarks.h
+
+greaterThan(QT_MAJOR_VERSION, 4) {
+    SOURCES += jsonbenchmarks.cpp
+    HEADERS += jsonbenchmarks.h
+}
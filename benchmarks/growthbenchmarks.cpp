@@ -0,0 +1,69 @@
+#include "growthbenchmarks.h"
+#include <algorithm>
+#include <QElapsedTimer>
+#include <QVector>
+#include "orderedhash.h"
+
+namespace
+{
+
+const int Count = 1000000;
+
+template <typename Key>
+void measure(const QVector<Key> &keys, bool incremental)
+{
+    qtcollections::OrderedHash<Key, int> hash;
+    hash.setIncrementalResize(incremental);
+
+    QVector<qint64> times(keys.size());
+    QElapsedTimer timer;
+    for (int i = 0; i < keys.size(); i++)
+    {
+        timer.start();
+        hash.insert(keys.at(i), i);
+        times[i] = timer.nsecsElapsed();
+    }
+
+    std::sort(times.begin(), times.end());
+    qint64 worst = times.last();
+    qint64 p99 = times.at(times.size() * 99 / 100);
+    qint64 median = times.at(times.size() / 2);
+    qDebug("%d inserts: median %lld ns, p99 %lld ns, worst %lld ns",
+           keys.size(), median, p99, worst);
+    QTest::setBenchmarkResult(worst / 1000000.0,
+                              QTest::WalltimeMilliseconds);
+}
+
+}   // namespace
+
+void GrowthBenchmarks::insertLatencyIntKeys_data()
+{
+    QTest::addColumn<bool>("incremental");
+    QTest::newRow("rehash") << false;
+    QTest::newRow("incremental") << true;
+}
+
+void GrowthBenchmarks::insertLatencyIntKeys()
+{
+    QFETCH(bool, incremental);
+    QVector<int> keys(Count);
+    for (int i = 0; i < Count; i++)
+        keys[i] = i;
+    measure(keys, incremental);
+}
+
+void GrowthBenchmarks::insertLatencyStringKeys_data()
+{
+    QTest::addColumn<bool>("incremental");
+    QTest::newRow("rehash") << false;
+    QTest::newRow("incremental") << true;
+}
+
+void GrowthBenchmarks::insertLatencyStringKeys()
+{
+    QFETCH(bool, incremental);
+    QVector<QString> keys(Count);
+    for (int i = 0; i < Count; i++)
+        keys[i] = QString::number(i);
+    measure(keys, incremental);
+}
@@ -0,0 +1,19 @@
+#ifndef GROWTHBENCHMARKS_H
+#define GROWTHBENCHMARKS_H
+
+#include <QtTest>
+
+// Per-insert latency while a hash grows from empty, with and without
+// incremental resizing. The reported result is the worst single insertion.
+class GrowthBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void insertLatencyIntKeys_data();
+    void insertLatencyIntKeys();
+    void insertLatencyStringKeys_data();
+    void insertLatencyStringKeys();
+};
+
+#endif  // GROWTHBENCHMARKS_H
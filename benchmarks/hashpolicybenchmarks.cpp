@@ -0,0 +1,169 @@
+#include "hashpolicybenchmarks.h"
+#include <QVector>
+#include "orderedhash.h"
+
+using qtcollections::DefaultHashPolicy;
+using qtcollections::FastHashPolicy;
+using qtcollections::OrderedHash;
+using qtcollections::SipHashPolicy;
+
+namespace
+{
+
+const int Count = 1000000;
+
+enum Policy { Default, Fast, SipHash };
+
+QVector<QString> stringKeys(int count, int offset)
+{
+    QVector<QString> keys(count);
+    for (int i = 0; i < count; i++)
+        keys[i] = QStringLiteral("/usr/share/item/%1").arg(i + offset);
+    return keys;
+}
+
+// Half of the lookups hit and half miss.
+template <typename Key, typename Hasher>
+void lookup(const QVector<Key> &keys, const QVector<Key> &misses)
+{
+    OrderedHash<Key, int, Hasher> hash;
+    hash.reserve(keys.size());
+    for (int i = 0; i < keys.size(); i++)
+        hash.insert(keys.at(i), i);
+
+    int found = 0;
+    QBENCHMARK
+    {
+        found = 0;
+        for (int i = 0; i < keys.size(); i++)
+        {
+            found += hash.contains(keys.at(i));
+            found += hash.contains(misses.at(i));
+        }
+    }
+    QCOMPARE(found, keys.size());
+}
+
+template <typename Key>
+void lookup(Policy policy, const QVector<Key> &keys,
+            const QVector<Key> &misses)
+{
+    switch (policy)
+    {
+    case Default:
+        lookup<Key, DefaultHashPolicy>(keys, misses);
+        break;
+    case Fast:
+        lookup<Key, FastHashPolicy>(keys, misses);
+        break;
+    case SipHash:
+        lookup<Key, SipHashPolicy>(keys, misses);
+        break;
+    }
+}
+
+// The largest number of keys sharing one of 2^16 buckets when buckets are
+// picked by the low bits of the hash, as QHash does.
+template <typename Key, typename Hasher>
+int worstBucket(const QVector<Key> &keys, const Hasher &hasher)
+{
+    QVector<int> buckets(1 << 16, 0);
+    int worst = 0;
+    for (int i = 0; i < keys.size(); i++)
+    {
+        const quint64 h = hasher(keys.at(i));
+        int &n = buckets[int(quint32(h ^ (h >> 32)) & 0xffff)];
+        worst = qMax(worst, ++n);
+    }
+    return worst;
+}
+
+template <typename Key>
+int worstBucket(Policy policy, const QVector<Key> &keys)
+{
+    switch (policy)
+    {
+    case Default:
+        return worstBucket(keys, DefaultHashPolicy());
+    case Fast:
+        return worstBucket(keys, FastHashPolicy());
+    case SipHash:
+        return worstBucket(keys, SipHashPolicy());
+    }
+    return 0;
+}
+
+void addPolicyRows()
+{
+    QTest::addColumn<int>("policy");
+    QTest::newRow("qHash") << int(Default);
+    QTest::newRow("fast") << int(Fast);
+    QTest::newRow("siphash") << int(SipHash);
+}
+
+}   // namespace
+
+void HashPolicyBenchmarks::lookupStringKeys_data()
+{
+    addPolicyRows();
+}
+
+void HashPolicyBenchmarks::lookupStringKeys()
+{
+    QFETCH(int, policy);
+    lookup(Policy(policy), stringKeys(Count, 0), stringKeys(Count, Count));
+}
+
+void HashPolicyBenchmarks::lookupIntKeys_data()
+{
+    addPolicyRows();
+}
+
+void HashPolicyBenchmarks::lookupIntKeys()
+{
+    QFETCH(int, policy);
+    QVector<int> keys(Count);
+    QVector<int> misses(Count);
+    for (int i = 0; i < Count; i++)
+    {
+        keys[i] = i * 2;
+        misses[i] = i * 2 + 1;
+    }
+    lookup(Policy(policy), keys, misses);
+}
+
+void HashPolicyBenchmarks::collisions_data()
+{
+    QTest::addColumn<int>("policy");
+    QTest::addColumn<bool>("strings");
+    QTest::newRow("qHash, strided ints") << int(Default) << false;
+    QTest::newRow("fast, strided ints") << int(Fast) << false;
+    QTest::newRow("siphash, strided ints") << int(SipHash) << false;
+    QTest::newRow("qHash, paths") << int(Default) << true;
+    QTest::newRow("fast, paths") << int(Fast) << true;
+    QTest::newRow("siphash, paths") << int(SipHash) << true;
+}
+
+// 2^16 keys, so a perfect spread puts one key in each bucket. Integer keys
+// are multiples of 2^16, which qHash(int) maps to a single bucket.
+void HashPolicyBenchmarks::collisions()
+{
+    QFETCH(int, policy);
+    QFETCH(bool, strings);
+    const int count = 1 << 16;
+
+    int worst;
+    if (strings)
+    {
+        worst = worstBucket(Policy(policy), stringKeys(count, 0));
+    }
+    else
+    {
+        QVector<int> keys(count);
+        for (int i = 0; i < count; i++)
+            keys[i] = i << 16;
+        worst = worstBucket(Policy(policy), keys);
+    }
+    qDebug("%d keys, at most %d in one bucket", count, worst);
+    QTest::setBenchmarkResult(worst, QTest::Events);
+}
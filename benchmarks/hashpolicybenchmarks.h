@@ -0,0 +1,21 @@
+#ifndef HASHPOLICYBENCHMARKS_H
+#define HASHPOLICYBENCHMARKS_H
+
+#include <QtTest>
+
+// Lookup throughput of OrderedHash with each built-in hash policy, and how
+// evenly each policy spreads key sets that are known to be hard on qHash().
+class HashPolicyBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void lookupStringKeys_data();
+    void lookupStringKeys();
+    void lookupIntKeys_data();
+    void lookupIntKeys();
+    void collisions_data();
+    void collisions();
+};
+
+#endif  // HASHPOLICYBENCHMARKS_H
@@ -0,0 +1,119 @@
+#include "jsonbenchmarks.h"
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include "orderedjson.h"
+
+using qtcollections::OrderedJsonReader;
+using qtcollections::OrderedJsonWriter;
+using qtcollections::OrderedVariantHash;
+
+namespace
+{
+
+const int DocumentSize = 100 * 1024 * 1024;
+
+// Records with a mix of value types, keys deliberately out of sorted order.
+QByteArray record(int i)
+{
+    QByteArray id = QByteArray::number(i);
+    return "{\"zid\": " + id + ", \"name\": \"record " + id + "\", "
+           "\"score\": " + QByteArray::number(i * 0.37) + ", "
+           "\"active\": " + (i % 2 ? "true" : "false") + ", "
+           "\"tags\": [\"alpha\", \"beta\", \"gamma\"], "
+           "\"meta\": {\"owner\": \"somebody\", \"parent\": null, "
+           "\"depth\": " + QByteArray::number(i % 16) + "}}";
+}
+
+void report(const char *what, qint64 bytes, qint64 nsecs)
+{
+    double seconds = nsecs / 1e9;
+    qDebug("%s: %.1f MB in %.3f s, %.1f MB/s", what,
+           bytes / 1048576.0, seconds, bytes / 1048576.0 / seconds);
+}
+
+}   // namespace
+
+void JsonBenchmarks::initTestCase()
+{
+    document.reserve(DocumentSize + 1024);
+    document.append("[\n");
+    for (int i = 0; document.size() < DocumentSize; i++)
+    {
+        if (i)
+            document.append(",\n");
+        document.append(record(i));
+    }
+    document.append("\n]\n");
+}
+
+void JsonBenchmarks::cleanupTestCase()
+{
+    document.clear();
+}
+
+void JsonBenchmarks::readOrdered()
+{
+    QVariant value;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE
+    {
+        timer.start();
+        QBuffer device(&document);
+        device.open(QIODevice::ReadOnly);
+        QJsonParseError error;
+        value = OrderedJsonReader(&device).read(&error);
+        QCOMPARE(error.error, QJsonParseError::NoError);
+    }
+    report("OrderedJsonReader", document.size(), timer.nsecsElapsed());
+    QVERIFY(!value.toList().isEmpty());
+}
+
+void JsonBenchmarks::readJsonDocument()
+{
+    QJsonDocument json;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE
+    {
+        timer.start();
+        QJsonParseError error;
+        json = QJsonDocument::fromJson(document, &error);
+        if (error.error == QJsonParseError::DocumentTooLarge)
+            QSKIP("Document too large for QJsonDocument");
+        QCOMPARE(error.error, QJsonParseError::NoError);
+    }
+    report("QJsonDocument::fromJson", document.size(), timer.nsecsElapsed());
+    QVERIFY(json.isArray());
+}
+
+void JsonBenchmarks::writeOrdered()
+{
+    QVariant value = OrderedJsonReader::parse(document);
+    QByteArray output;
+    output.reserve(document.size());
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE
+    {
+        timer.start();
+        QBuffer device(&output);
+        device.open(QIODevice::WriteOnly);
+        QVERIFY(OrderedJsonWriter(&device).write(value));
+    }
+    report("OrderedJsonWriter", output.size(), timer.nsecsElapsed());
+}
+
+void JsonBenchmarks::writeJsonDocument()
+{
+    QJsonParseError error;
+    QJsonDocument json = QJsonDocument::fromJson(document, &error);
+    if (error.error == QJsonParseError::DocumentTooLarge)
+        QSKIP("Document too large for QJsonDocument");
+    QByteArray output;
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE
+    {
+        timer.start();
+        output = json.toJson(QJsonDocument::Indented);
+    }
+    report("QJsonDocument::toJson", output.size(), timer.nsecsElapsed());
+}
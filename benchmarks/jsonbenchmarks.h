@@ -0,0 +1,25 @@
+#ifndef JSONBENCHMARKS_H
+#define JSONBENCHMARKS_H
+
+#include <QByteArray>
+#include <QtTest>
+
+// Throughput of the ordered JSON reader and writer against QJsonDocument,
+// on a generated document of about 100 MB.
+class JsonBenchmarks : public QObject
+{
+    Q_OBJECT
+
+    QByteArray document;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void readOrdered();
+    void readJsonDocument();
+    void writeOrdered();
+    void writeJsonDocument();
+};
+
+#endif  // JSONBENCHMARKS_H
@@ -0,0 +1,103 @@
+#include "probingbenchmarks.h"
+#include <algorithm>
+#include <QElapsedTimer>
+#include <QVector>
+#include "groupprobing.h"
+
+using qtcollections::GroupProbing;
+using qtcollections::OrderedHash;
+
+namespace
+{
+
+const int Count = 4000000;
+
+// Keys inserted in one order and looked up in another, so neither the
+// index nor the entries are walked sequentially.
+template <typename Key>
+void shuffle(QVector<Key> &keys)
+{
+    quint32 state = 12345;
+    for (int i = keys.size() - 1; i > 0; i--)
+    {
+        state = state * 1664525u + 1013904223u;
+        qSwap(keys[i], keys[int(state % quint32(i + 1))]);
+    }
+}
+
+template <typename Key, typename Hasher>
+void lookup(const QVector<Key> &keys, const QVector<Key> &probes, bool hits)
+{
+    OrderedHash<Key, int, Hasher> hash;
+    for (int i = 0; i < keys.size(); i++)
+        hash.insert(keys.at(i), i);
+
+    int found = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE
+    {
+        for (int i = 0; i < probes.size(); i++)
+            found += hash.contains(probes.at(i));
+    }
+    qDebug("%.1f ns per lookup", double(timer.nsecsElapsed()) / probes.size());
+    QCOMPARE(found, hits ? probes.size() : 0);
+}
+
+void addRows()
+{
+    QTest::addColumn<bool>("group");
+    QTest::addColumn<bool>("hits");
+    QTest::newRow("default, hit") << false << true;
+    QTest::newRow("default, miss") << false << false;
+    QTest::newRow("group, hit") << true << true;
+    QTest::newRow("group, miss") << true << false;
+}
+
+}   // namespace
+
+void ProbingBenchmarks::lookupStringKeys_data()
+{
+    addRows();
+}
+
+void ProbingBenchmarks::lookupStringKeys()
+{
+    QFETCH(bool, group);
+    QFETCH(bool, hits);
+    QVector<QString> keys(Count);
+    QVector<QString> probes(Count);
+    for (int i = 0; i < Count; i++)
+    {
+        keys[i] = QString::number(i * 2);
+        probes[i] = QString::number(hits ? i * 2 : i * 2 + 1);
+    }
+    shuffle(probes);
+    if (group)
+        lookup<QString, GroupProbing<> >(keys, probes, hits);
+    else
+        lookup<QString, qtcollections::DefaultHashPolicy>(keys, probes, hits);
+}
+
+void ProbingBenchmarks::lookupIntKeys_data()
+{
+    addRows();
+}
+
+void ProbingBenchmarks::lookupIntKeys()
+{
+    QFETCH(bool, group);
+    QFETCH(bool, hits);
+    QVector<int> keys(Count);
+    QVector<int> probes(Count);
+    for (int i = 0; i < Count; i++)
+    {
+        keys[i] = i * 2;
+        probes[i] = hits ? i * 2 : i * 2 + 1;
+    }
+    shuffle(probes);
+    if (group)
+        lookup<int, GroupProbing<> >(keys, probes, hits);
+    else
+        lookup<int, qtcollections::DefaultHashPolicy>(keys, probes, hits);
+}
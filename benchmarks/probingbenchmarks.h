@@ -0,0 +1,19 @@
+#ifndef PROBINGBENCHMARKS_H
+#define PROBINGBENCHMARKS_H
+
+#include <QtTest>
+
+// Lookup cost of the default engines against the group-probing engine, on
+// a few million keys looked up in random order.
+class ProbingBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void lookupStringKeys_data();
+    void lookupStringKeys();
+    void lookupIntKeys_data();
+    void lookupIntKeys();
+};
+
+#endif  // PROBINGBENCHMARKS_H
@@ -18,6 +18,18 @@ UI_DIR = $$BUILD_DIR
 HEADERS += \
     $$PWD/src/qtcollections_global.h \
     $$PWD/src/qtcollections.h \
-    $$PWD/src/orderedhash.h
+    $$PWD/src/orderedhash.h \
+    $$PWD/src/internedstring.h \
+    $$PWD/src/orderedmultihash.h \
+    $$PWD/src/orderedset.h \
+    $$PWD/src/immutableorderedhash.h \
+    $$PWD/src/hashpolicy.h \
+    $$PWD/src/groupprobing.h \
+    $$PWD/src/ttlorderedhash.h \
+    $$PWD/src/journaledorderedhash.h
 
-SOURCES +=
+greaterThan(QT_MAJOR_VERSION, 4) {
+    HEADERS += \
+        $$PWD/src/orderedhashmodel.h \
+        $$PWD/src/orderedjson.h
+}
@@ -3,6 +3,12 @@ TEMPLATE = subdirs
 SUBDIRS = src
 
 CONFIG(debug, debug|release) {
-    SUBDIRS += tests
+    SUBDIRS += tests allocations
     tests.depends = src
+    allocations.depends = src
+}
+
+CONFIG(release, debug|release) {
+    SUBDIRS += benchmarks
+    benchmarks.depends = src
 }
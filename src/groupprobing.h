@@ -0,0 +1,649 @@
+#ifndef QTCOLLECTIONS_GROUPPROBING_H
+#define QTCOLLECTIONS_GROUPPROBING_H
+
+#include <string.h>
+#include <QBitArray>
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <QVector>
+#include "qtcollections_global.h"
+#include "hashpolicy.h"
+#include "orderedhash.h"
+
+// Group matching uses AVX2 when the compiler targets it, SSE2 on any x86
+// that has it, and portable 64-bit word arithmetic otherwise. Define
+// QTCOLLECTIONS_NO_SIMD to force the portable version.
+#if !defined(QTCOLLECTIONS_NO_SIMD)
+#   if defined(__AVX2__)
+#       include <immintrin.h>
+#       define QTCOLLECTIONS_GROUP_AVX2
+#   elif defined(__SSE2__) || defined(_M_X64) \
+        || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       include <emmintrin.h>
+#       define QTCOLLECTIONS_GROUP_SSE2
+#   endif
+#endif
+
+namespace qtcollections
+{
+
+// A group of control bytes, one per slot of the index. A full slot holds
+// the low 7 bits of its entry's hash, so comparing a whole group against
+// those bits rejects almost every non-matching slot without looking at the
+// entry. Each match function returns a mask with bit i set for byte i.
+struct OrderedHashGroup
+{
+    enum { Empty = -128, Deleted = -2 };
+    typedef quint32 Mask;
+
+#if defined(QTCOLLECTIONS_GROUP_AVX2)
+    enum { Width = 32 };
+
+    static inline __m256i load(const qint8 *ctrl)
+        { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ctrl)); }
+    static inline Mask match(const qint8 *ctrl, qint8 h2)
+    {
+        return Mask(_mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8(load(ctrl), _mm256_set1_epi8(h2))));
+    }
+    static inline Mask matchEmpty(const qint8 *ctrl)
+        { return match(ctrl, qint8(Empty)); }
+    // Empty and deleted slots are the ones with the sign bit set.
+    static inline Mask matchFree(const qint8 *ctrl)
+        { return Mask(_mm256_movemask_epi8(load(ctrl))); }
+#elif defined(QTCOLLECTIONS_GROUP_SSE2)
+    enum { Width = 16 };
+
+    static inline __m128i load(const qint8 *ctrl)
+        { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl)); }
+    static inline Mask match(const qint8 *ctrl, qint8 h2)
+    {
+        return Mask(_mm_movemask_epi8(
+                        _mm_cmpeq_epi8(load(ctrl), _mm_set1_epi8(h2))));
+    }
+    static inline Mask matchEmpty(const qint8 *ctrl)
+        { return match(ctrl, qint8(Empty)); }
+    static inline Mask matchFree(const qint8 *ctrl)
+        { return Mask(_mm_movemask_epi8(load(ctrl))); }
+#else
+    enum { Width = 16 };
+
+    static inline quint64 load(const qint8 *ctrl)
+    {
+        quint64 v;
+        ::memcpy(&v, ctrl, 8);
+        return qFromLittleEndian(v);
+    }
+
+    // Collects the top bit of each byte into the low 8 bits.
+    static inline Mask gather(quint64 v)
+    {
+        return Mask(((v >> 7) * Q_UINT64_C(0x0102040810204080)) >> 56);
+    }
+
+    static inline Mask matchWord(quint64 v, qint8 h2)
+    {
+        const quint64 low = Q_UINT64_C(0x7f7f7f7f7f7f7f7f);
+        const quint64 x = v ^ (Q_UINT64_C(0x0101010101010101) * quint8(h2));
+        return gather(~(((x & low) + low) | x | low));
+    }
+    static inline Mask match(const qint8 *ctrl, qint8 h2)
+    {
+        return matchWord(load(ctrl), h2)
+                | matchWord(load(ctrl + 8), h2) << 8;
+    }
+
+    // Empty is the only control byte with bit 7 set and bit 1 clear.
+    static inline Mask emptyWord(quint64 v)
+        { return gather(v & ~(v << 6) & Q_UINT64_C(0x8080808080808080)); }
+    static inline Mask matchEmpty(const qint8 *ctrl)
+        { return emptyWord(load(ctrl)) | emptyWord(load(ctrl + 8)) << 8; }
+
+    static inline Mask freeWord(quint64 v)
+        { return gather(v & Q_UINT64_C(0x8080808080808080)); }
+    static inline Mask matchFree(const qint8 *ctrl)
+        { return freeWord(load(ctrl)) | freeWord(load(ctrl + 8)) << 8; }
+#endif
+
+    // The position of the lowest set bit of a non-zero mask.
+    static inline int lowestBit(Mask m)
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+        return int(qCountTrailingZeroBits(m));
+#elif defined(Q_CC_GNU)
+        return __builtin_ctz(m);
+#else
+        int i = 0;
+        for (; !(m & 1); m >>= 1)
+            i++;
+        return i;
+#endif
+    }
+};
+
+// Selects the group-probing engine for an OrderedHash, hashing keys with
+// the given policy:
+//
+//   OrderedHash<QString, int, GroupProbing<> > hash;
+//   OrderedHash<QString, int, GroupProbing<SipHashPolicy> > safe;
+template <typename Hasher = DefaultHashPolicy>
+struct GroupProbing : public Hasher
+{
+    inline GroupProbing() {}
+    inline GroupProbing(const Hasher &hasher) : Hasher(hasher) {}
+};
+
+// Engine with a SwissTable-style index, for keys of any type.
+//
+// Entries are kept in a QVector in insertion order, with holes for erased
+// entries, as in the flat engine, next to the hash of each entry. The index
+// is an array of entry numbers with one control byte per slot, probed a
+// group at a time: a lookup loads the group the hash points to, compares
+// all of its control bytes at once, and only visits the entries whose
+// 7-bit fragment matches. A miss usually ends at the first group, so it
+// costs about one cache miss. Erased slots become tombstones unless their
+// group still has an empty slot; a full index is rebuilt from the stored
+// hashes, in place when it is mostly tombstones.
+//
+// Like the flat engine, inserting may compact the entries and invalidate
+// iterators. The index is always rebuilt in one go, and incremental mode
+// changes nothing: a rebuild reads the stored hashes rather than the keys,
+// but still visits every entry.
+template <typename Key, typename T, typename Hasher>
+struct OrderedHashGroupData
+{
+    typedef OrderedHashEntry<Key, T> Entry;
+    typedef OrderedHashGroup Group;
+    typedef int Cursor;
+
+    QVector<Entry> entries;
+    QVector<quint32> hashes;    // Hash of each entry.
+    QBitArray holes;
+    int holeCount;
+    int head;                   // Index of the first live entry.
+    QVector<qint8> ctrl;
+    QVector<int> indices;       // Entry index of each full slot.
+    int groupMask;
+    int growthLeft;             // Empty slots left before a rebuild.
+    bool incremental;
+    GroupProbing<Hasher> hasher;
+
+    explicit OrderedHashGroupData(const GroupProbing<Hasher> &hasher) :
+        holeCount(0), head(0), groupMask(0), growthLeft(0),
+        incremental(false), hasher(hasher) {}
+
+    inline const GroupProbing<Hasher> &hashPolicy() const { return hasher; }
+
+    inline int size() const { return entries.size() - holeCount; }
+    inline int capacity() const { return entries.capacity(); }
+
+    void reserve(int size)
+    {
+        entries.reserve(size);
+        hashes.reserve(size);
+        if (holes.size() < size)
+            holes.resize(size);
+        if (groupsFor(size) > groupCount())
+            rehash(groupsFor(size));
+    }
+
+    void squeeze()
+    {
+        if (holeCount)
+            compact();
+        entries.squeeze();
+        hashes.squeeze();
+        if (entries.isEmpty())
+            clear();
+        else if (groupsFor(entries.size()) < groupCount())
+            rehash(groupsFor(entries.size()));
+    }
+
+    void clear()
+    {
+        entries.clear();
+        hashes.clear();
+        holes.clear();
+        holeCount = 0;
+        head = 0;
+        ctrl.clear();
+        indices.clear();
+        groupMask = 0;
+        growthLeft = 0;
+    }
+
+    inline void setIncrementalResize(bool enable) { incremental = enable; }
+
+    inline Cursor begin() const { return head; }
+    inline Cursor end() const { return entries.size(); }
+
+    inline Cursor next(Cursor i) const
+    {
+        do {
+            ++i;
+        } while (i < entries.size() && holes.testBit(i));
+        return i;
+    }
+
+    inline Cursor previous(Cursor i) const
+    {
+        do {
+            --i;
+        } while (i > head && holes.testBit(i));
+        return i;
+    }
+
+    inline const Key &key(Cursor i) const { return entries.at(i).key; }
+    inline T &value(Cursor i) { return entries[i].value; }
+    inline const T &value(Cursor i) const { return entries.at(i).value; }
+
+    inline Cursor find(const Key &key) const
+    {
+        return ctrl.isEmpty() ? end() : find(key, hashOf(key));
+    }
+
+    // Resolves keys a batch at a time: first every key is hashed and its
+    // first group prefetched, then the entry of each key's first fragment
+    // match is prefetched, and only then are the keys compared.
+    template <typename Iterator, typename Sink>
+    void findMany(Iterator first, Iterator last, Sink &sink) const
+    {
+        if (ctrl.isEmpty())
+        {
+            for (; first != last; ++first)
+                sink(static_cast<const T *>(0));
+            return;
+        }
+        Iterator keys[BatchSize];
+        quint32 h[BatchSize];
+        while (first != last)
+        {
+            int n = 0;
+            for (; n < BatchSize && first != last; ++first, ++n)
+            {
+                keys[n] = first;
+                h[n] = hashOf(*first);
+                const int base = firstGroup(h[n]) * Group::Width;
+                orderedHashPrefetch(ctrl.constData() + base);
+                orderedHashPrefetch(indices.constData() + base);
+            }
+            for (int j = 0; j < n; j++)
+            {
+                const int base = firstGroup(h[j]) * Group::Width;
+                const Group::Mask m =
+                        Group::match(ctrl.constData() + base, fragment(h[j]));
+                if (m)
+                {
+                    const int i = indices.at(base + Group::lowestBit(m));
+                    orderedHashPrefetch(entries.constData() + i);
+                }
+            }
+            for (int j = 0; j < n; j++)
+            {
+                const Cursor i = find(*keys[j], h[j]);
+                sink(i != end() ? &entries.at(i).value : 0);
+            }
+        }
+    }
+
+    Cursor insert(const Key &key, const T &value)
+    {
+        const quint32 h = hashOf(key);
+        if (!ctrl.isEmpty())
+        {
+            Cursor i = find(key, h);
+            if (i != end())
+            {
+                entries[i].value = value;
+                return i;
+            }
+        }
+
+        if (holeCount && holeCount >= entries.size() / 2
+                && entries.size() == entries.capacity())
+            compact();
+        int s = ctrl.isEmpty() ? -1 : freeSlot(h);
+        if (s < 0 || (growthLeft == 0 && ctrl.at(s) == Group::Empty))
+        {
+            grow();
+            s = freeSlot(h);
+        }
+
+        const int i = entries.size();
+        entries.append(Entry(key, value));
+        hashes.append(h);
+        growHoles();
+        fill(s, h, i);
+        return i;
+    }
+
+    // As in the flat engine, an entry linked right after a hole takes its
+    // place, and one linked before a live entry goes through open(), which
+    // is O(table size) and may reallocate the vectors.
+    Cursor link(Cursor before, Key &key, T &value)
+    {
+        const quint32 h = hashOf(key);
+        int s = ctrl.isEmpty() ? -1 : freeSlot(h);
+        if (s < 0 || (growthLeft == 0 && ctrl.at(s) == Group::Empty))
+        {
+            grow();
+            s = freeSlot(h);
+        }
+        int i = before;
+        if (i > 0 && holes.testBit(i - 1))
+            fillHole(--i);
+        else
+            open(i);
+        qSwap(entries[i].key, key);
+        qSwap(entries[i].value, value);
+        hashes[i] = h;
+        fill(s, h, i);
+        return i;
+    }
+
+    // The index only needs the stored hash, so the key can go first.
+    void unlink(Cursor i, Key &key, T &value)
+    {
+        qSwap(key, entries[i].key);
+        qSwap(value, entries[i].value);
+        erase(i);
+    }
+
+    Cursor erase(Cursor i)
+    {
+        Cursor n = next(i);
+        punch(i);
+        trim();
+        return n < entries.size() ? n : entries.size();
+    }
+
+    int erase(Cursor first, Cursor last)
+    {
+        int removed = 0;
+        for (Cursor i = first; i != last; i = next(i))
+        {
+            punch(i);
+            removed++;
+        }
+        trim();
+        if (holeCount && holeCount >= entries.size() / 2)
+            compact();
+        return removed;
+    }
+
+    // Removes matching entries and squeezes out holes in a single pass,
+    // moving the stored hashes along, then rebuilds the index.
+    template <typename Predicate>
+    int removeIf(Predicate pred)
+    {
+        Entry *e = entries.data();
+        quint32 *hs = hashes.data();
+        const int n = entries.size();
+        const int count = size();
+        int w = 0;
+        for (int r = head; r < n; )
+        {
+            if (holes.testBit(r) || pred(e[r].key, e[r].value))
+            {
+                r++;
+                continue;
+            }
+            int run = r + 1;
+            while (run < n && !holes.testBit(run)
+                   && !pred(e[run].key, e[run].value))
+                run++;
+            if (w != r)
+            {
+                moveEntries(e + w, e + r, run - r);
+                ::memmove(hs + w, hs + r, (run - r) * sizeof(quint32));
+            }
+            w += run - r;
+            r = run + 1;    // entries[run], if any, is being removed.
+        }
+        entries.resize(w);
+        hashes.resize(w);
+        holes.fill(false, w);
+        holeCount = 0;
+        head = 0;
+        if (!ctrl.isEmpty())
+            rehash(groupCount());
+        return count - w;
+    }
+
+private:
+    // Keys resolved together by findMany().
+    enum { BatchSize = 16 };
+
+    // Spreads the policy's hash, which for qHash() on integers may be the
+    // key itself, over all 32 bits. The low 7 bits go to the control byte,
+    // the rest pick the first group to probe.
+    inline quint32 hashOf(const Key &key) const
+    {
+        const quint64 h = quint64(hasher(key));
+        return quint32((h * Q_UINT64_C(0x9E3779B97F4A7C15)) >> 32);
+    }
+
+    static inline qint8 fragment(quint32 h) { return qint8(h & 0x7f); }
+    inline int firstGroup(quint32 h) const { return int(h >> 7) & groupMask; }
+    inline int groupCount() const { return ctrl.size() / Group::Width; }
+
+    // Groups are probed in triangular order, which visits every group of a
+    // power-of-two sized index.
+    Cursor find(const Key &key, quint32 h) const
+    {
+        const qint8 *c = ctrl.constData();
+        const int *s = indices.constData();
+        const Entry *e = entries.constData();
+        const qint8 h2 = fragment(h);
+        int g = firstGroup(h);
+        for (int step = 1; ; step++)
+        {
+            const int base = g * Group::Width;
+            for (Group::Mask m = Group::match(c + base, h2); m; m &= m - 1)
+            {
+                const int i = s[base + Group::lowestBit(m)];
+                if (e[i].key == key)
+                    return i;
+            }
+            if (Group::matchEmpty(c + base))
+                return end();
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // The first empty or deleted slot on the probe sequence of h.
+    int freeSlot(quint32 h) const
+    {
+        const qint8 *c = ctrl.constData();
+        int g = firstGroup(h);
+        for (int step = 1; ; step++)
+        {
+            const int base = g * Group::Width;
+            const Group::Mask m = Group::matchFree(c + base);
+            if (m)
+                return base + Group::lowestBit(m);
+            g = (g + step) & groupMask;
+        }
+    }
+
+    inline void fill(int s, quint32 h, int index)
+    {
+        if (ctrl.at(s) == Group::Empty)
+            growthLeft--;
+        ctrl[s] = fragment(h);
+        indices[s] = index;
+    }
+
+    // A slot may only go back to empty if its group has an empty slot: then
+    // the group was never full, and no probe sequence has passed through it.
+    void unfill(int index)
+    {
+        const quint32 h = hashes.at(index);
+        const qint8 h2 = fragment(h);
+        qint8 *c = ctrl.data();
+        const int *s = indices.constData();
+        int g = firstGroup(h);
+        for (int step = 1; ; step++)
+        {
+            const int base = g * Group::Width;
+            for (Group::Mask m = Group::match(c + base, h2); m; m &= m - 1)
+            {
+                const int slot = base + Group::lowestBit(m);
+                if (s[slot] != index)
+                    continue;
+                if (Group::matchEmpty(c + base))
+                {
+                    c[slot] = qint8(Group::Empty);
+                    growthLeft++;
+                }
+                else
+                {
+                    c[slot] = qint8(Group::Deleted);
+                }
+                return;
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // Groups needed to hold size entries at a load factor of 7/8.
+    static int groupsFor(int size)
+    {
+        int n = 1;
+        while (n * Group::Width - n * Group::Width / 8 < size)
+            n *= 2;
+        return n;
+    }
+
+    void grow()
+    {
+        const int groups = groupCount();
+        // An index full of tombstones is cleaned up rather than doubled.
+        if (groups && size() * 16 <= groups * Group::Width * 7)
+            rehash(groups);
+        else
+            rehash(groups ? groups * 2 : 1);
+    }
+
+    void rehash(int groups)
+    {
+        const int n = groups * Group::Width;
+        ctrl.fill(qint8(Group::Empty), n);
+        indices.resize(n);
+        groupMask = groups - 1;
+        growthLeft = n - n / 8;
+        for (int i = head; i < entries.size(); i = next(i))
+            fill(freeSlot(hashes.at(i)), hashes.at(i), i);
+    }
+
+    struct KeepAll
+    {
+        inline bool operator()(const Key &, const T &) const { return false; }
+    };
+
+    inline void compact() { removeIf(KeepAll()); }
+
+    static void moveEntries(Entry *to, Entry *from, int n)
+    {
+        if (QTypeInfo<Entry>::isComplex)
+        {
+            for (int j = 0; j < n; j++)
+                to[j] = from[j];
+        }
+        else
+        {
+            ::memmove(static_cast<void *>(to), from, n * sizeof(Entry));
+        }
+    }
+
+    // As in the flat engine, holes grows with the entries' capacity.
+    inline void growHoles()
+    {
+        if (holes.size() < entries.size())
+            holes.resize(entries.capacity());
+    }
+
+    inline void fillHole(int i)
+    {
+        holes.clearBit(i);
+        holeCount--;
+        if (i < head)
+            head = i;
+    }
+
+    // Makes room for an entry at i, moving the entries after it up by one.
+    // Unless i is the end, every slot of the index is visited to renumber
+    // them.
+    void open(int i)
+    {
+        entries.insert(i, Entry());
+        hashes.insert(i, 0);
+        const int n = entries.size();
+        growHoles();
+        for (int j = n - 1; j > i; j--)
+            holes.setBit(j, holes.testBit(j - 1));
+        holes.clearBit(i);
+        if (i == n - 1)
+            return;
+        const qint8 *c = ctrl.constData();
+        int *s = indices.data();
+        for (int slot = 0; slot < ctrl.size(); slot++)
+        {
+            if (c[slot] >= 0 && s[slot] >= i)
+                s[slot]++;
+        }
+    }
+
+    // Turns a live entry into a hole.
+    void punch(int i)
+    {
+        unfill(i);
+        holes.setBit(i);
+        holeCount++;
+        if (QTypeInfo<Entry>::isComplex)
+            entries[i] = Entry();
+    }
+
+    // Drops trailing holes and moves head past leading ones, as the flat
+    // engine does.
+    void trim()
+    {
+        int n = entries.size();
+        while (n > 0 && holes.testBit(n - 1))
+        {
+            entries.removeLast();
+            hashes.removeLast();
+            holeCount--;
+            n--;
+        }
+        holes.resize(n);
+        while (head < n && holes.testBit(head))
+            head++;
+        if (head > n)
+            head = n;
+    }
+};
+
+template <typename Key, typename T, typename Hasher>
+struct QTCOLLECTIONS_SHARED_EXPORT
+OrderedHashData<Key, T, GroupProbing<Hasher>, false> :
+        public OrderedHashGroupData<Key, T, Hasher>
+{
+    explicit OrderedHashData(
+            const GroupProbing<Hasher> &hasher = GroupProbing<Hasher>()) :
+        OrderedHashGroupData<Key, T, Hasher>(hasher) {}
+};
+
+template <typename Key, typename T, typename Hasher>
+struct QTCOLLECTIONS_SHARED_EXPORT
+OrderedHashData<Key, T, GroupProbing<Hasher>, true> :
+        public OrderedHashGroupData<Key, T, Hasher>
+{
+    explicit OrderedHashData(
+            const GroupProbing<Hasher> &hasher = GroupProbing<Hasher>()) :
+        OrderedHashGroupData<Key, T, Hasher>(hasher) {}
+};
+
+}   // namespace qtcollections
+
+#endif // QTCOLLECTIONS_GROUPPROBING_H
@@ -0,0 +1,346 @@
+#ifndef QTCOLLECTIONS_HASHPOLICY_H
+#define QTCOLLECTIONS_HASHPOLICY_H
+
+#include <string.h>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#endif
+#include "qtcollections_global.h"
+
+namespace qtcollections
+{
+
+// Hash policies for OrderedHash.
+//
+// A policy is a copyable functor mapping a key to a 64-bit hash. Every hash
+// keeps its own copy, so a policy may carry a seed: the built-in seeded
+// policies draw a fresh one for each default-constructed instance, and take
+// an explicit one where reproducible hashes are wanted.
+//
+// DefaultHashPolicy is Qt's qHash() and is what OrderedHash uses unless told
+// otherwise. FastHashPolicy is a wyhash-style hash for trusted keys, and
+// SipHashPolicy is SipHash-1-3, a keyed hash for keys an attacker may pick.
+// Both hash QString and QByteArray contents and integral keys directly;
+// other key types are first reduced with their seeded qHash() overload, so
+// for those the result is only as collision resistant as qHash() itself.
+
+struct DefaultHashPolicy
+{
+    template <typename Key>
+    inline quint64 operator()(const Key &key) const { return qHash(key); }
+};
+
+namespace hashpolicy
+{
+
+// A seed that differs between instances and, where Qt can provide one,
+// between runs.
+inline quint64 randomSeed()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    return QRandomGenerator::global()->generate64();
+#else
+    static QBasicAtomicInt counter = Q_BASIC_ATOMIC_INITIALIZER(0);
+    quint64 seed = quint64(QDateTime::currentMSecsSinceEpoch());
+    seed ^= quint64(quintptr(&seed)) << 16;
+    seed += quint64(counter.fetchAndAddRelaxed(1))
+            * Q_UINT64_C(0x9E3779B97F4A7C15);
+    seed ^= seed >> 29;
+    seed *= Q_UINT64_C(0xBF58476D1CE4E5B9);
+    return seed ^ (seed >> 32);
+#endif
+}
+
+inline quint64 read64(const uchar *p)
+{
+    quint64 v;
+    ::memcpy(&v, p, 8);
+    return v;
+}
+
+inline quint64 read32(const uchar *p)
+{
+    quint32 v;
+    ::memcpy(&v, p, 4);
+    return v;
+}
+
+// Full 64 x 64 -> 128-bit multiplication; a keeps the low half and b the
+// high half.
+inline void multiply(quint64 *a, quint64 *b)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 r = *a;
+    r *= *b;
+    *a = quint64(r);
+    *b = quint64(r >> 64);
+#else
+    const quint64 ha = *a >> 32, hb = *b >> 32;
+    const quint64 la = quint32(*a), lb = quint32(*b);
+    const quint64 hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    const quint64 t = hl + (ll >> 32);
+    const quint64 m = lh + quint32(t);
+    *a = (m << 32) | quint32(ll);
+    *b = hh + (t >> 32) + (m >> 32);
+#endif
+}
+
+inline quint64 mix(quint64 a, quint64 b)
+{
+    multiply(&a, &b);
+    return a ^ b;
+}
+
+// wyhash (final version 4) over a byte range.
+inline quint64 wyhash(const void *data, int size, quint64 seed)
+{
+    static const quint64 secret[4] = {
+        Q_UINT64_C(0x2d358dccaa6c78a5), Q_UINT64_C(0x8bb84b93962eacc9),
+        Q_UINT64_C(0x4b33a62ed433d4a3), Q_UINT64_C(0x4d5a2da51de1aa47)
+    };
+    const uchar *p = static_cast<const uchar *>(data);
+    const quint64 len = quint64(size);
+    quint64 a, b;
+    seed ^= mix(seed ^ secret[0], secret[1]);
+    if (size <= 16)
+    {
+        if (size >= 4)
+        {
+            const int q = (size >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + q);
+            b = (read32(p + size - 4) << 32) | read32(p + size - 4 - q);
+        }
+        else if (size > 0)
+        {
+            a = (quint64(p[0]) << 16) | (quint64(p[size >> 1]) << 8)
+                    | p[size - 1];
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        int i = size;
+        if (i > 48)
+        {
+            quint64 see1 = seed, see2 = seed;
+            do {
+                seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+                see1 = mix(read64(p + 16) ^ secret[2], read64(p + 24) ^ see1);
+                see2 = mix(read64(p + 32) ^ secret[3], read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16)
+        {
+            seed = mix(read64(p) ^ secret[1], read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+    a ^= secret[1];
+    b ^= seed;
+    multiply(&a, &b);
+    return mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+inline quint64 rotate(quint64 x, int b)
+{
+    return (x << b) | (x >> (64 - b));
+}
+
+inline void sipRound(quint64 &v0, quint64 &v1, quint64 &v2, quint64 &v3)
+{
+    v0 += v1; v1 = rotate(v1, 13); v1 ^= v0; v0 = rotate(v0, 32);
+    v2 += v3; v3 = rotate(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotate(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotate(v1, 17); v1 ^= v2; v2 = rotate(v2, 32);
+}
+
+// SipHash-c-d with the 128-bit key (k0, k1), reading the input as little
+// endian words as the reference implementation does.
+template <int CompressionRounds, int FinalizationRounds>
+quint64 sipHash(const void *data, int size, quint64 k0, quint64 k1)
+{
+    const uchar *p = static_cast<const uchar *>(data);
+    quint64 v0 = k0 ^ Q_UINT64_C(0x736f6d6570736575);
+    quint64 v1 = k1 ^ Q_UINT64_C(0x646f72616e646f6d);
+    quint64 v2 = k0 ^ Q_UINT64_C(0x6c7967656e657261);
+    quint64 v3 = k1 ^ Q_UINT64_C(0x7465646279746573);
+
+    const uchar *end = p + (size & ~7);
+    for (; p != end; p += 8)
+    {
+        quint64 m = 0;
+        for (int j = 7; j >= 0; j--)
+            m = (m << 8) | p[j];
+        v3 ^= m;
+        for (int r = 0; r < CompressionRounds; r++)
+            sipRound(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    quint64 m = quint64(size) << 56;
+    for (int j = (size & 7) - 1; j >= 0; j--)
+        m |= quint64(p[j]) << (8 * j);
+    v3 ^= m;
+    for (int r = 0; r < CompressionRounds; r++)
+        sipRound(v0, v1, v2, v3);
+    v0 ^= m;
+
+    v2 ^= 0xff;
+    for (int r = 0; r < FinalizationRounds; r++)
+        sipRound(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// How the seeded policies see a key: integral and pointer keys as their
+// bytes, anything else through its qHash() overload.
+template <typename Key,
+          bool isPlain = IsIntegral<Key>::value
+                         || QTypeInfo<Key>::isPointer>
+struct KeyHasher
+{
+    template <typename Policy>
+    static inline quint64 hash(const Policy &policy, const Key &key)
+    {
+#if QT_VERSION >= 0x050000
+        const uint h = qHash(key, uint(policy.seed()));
+#else
+        const uint h = qHash(key);  // Qt 4's qHash() takes no seed.
+#endif
+        return policy.hash(&h, int(sizeof(h)));
+    }
+};
+
+template <typename Key>
+struct KeyHasher<Key, true>
+{
+    template <typename Policy>
+    static inline quint64 hash(const Policy &policy, const Key &key)
+        { return policy.hash(&key, int(sizeof(Key))); }
+};
+
+}   // namespace hashpolicy
+
+struct FastHashPolicy
+{
+    quint64 k;
+
+    inline FastHashPolicy() : k(hashpolicy::randomSeed()) {}
+    explicit inline FastHashPolicy(quint64 seed) : k(seed) {}
+
+    inline quint64 seed() const { return k; }
+    inline quint64 hash(const void *data, int size) const
+        { return hashpolicy::wyhash(data, size, k); }
+
+    inline quint64 operator()(const QString &key) const
+        { return hash(key.constData(), key.size() * int(sizeof(QChar))); }
+    inline quint64 operator()(const QByteArray &key) const
+        { return hash(key.constData(), key.size()); }
+    template <typename Key>
+    inline quint64 operator()(const Key &key) const
+        { return hashpolicy::KeyHasher<Key>::hash(*this, key); }
+};
+
+struct SipHashPolicy
+{
+    quint64 k0;
+    quint64 k1;
+
+    inline SipHashPolicy() :
+        k0(hashpolicy::randomSeed()), k1(hashpolicy::randomSeed()) {}
+    inline SipHashPolicy(quint64 k0, quint64 k1) : k0(k0), k1(k1) {}
+
+    inline quint64 seed() const { return k0 ^ k1; }
+    inline quint64 hash(const void *data, int size) const
+        { return hashpolicy::sipHash<1, 3>(data, size, k0, k1); }
+
+    inline quint64 operator()(const QString &key) const
+        { return hash(key.constData(), key.size() * int(sizeof(QChar))); }
+    inline quint64 operator()(const QByteArray &key) const
+        { return hash(key.constData(), key.size()); }
+    template <typename Key>
+    inline quint64 operator()(const Key &key) const
+        { return hashpolicy::KeyHasher<Key>::hash(*this, key); }
+};
+
+// How the engines store keys for a policy. With the default policy keys are
+// stored as they are and hashed by QHash through qHash(). Other policies
+// hash each key once on its way into a QHash, which then only compares the
+// stored hash.
+//
+// QHash only keeps a uint per node, so the node engine buckets keys by the
+// 64-bit hash folded to 32 bits, which is as many bits as any QHash's
+// bucket count can use. The full hash is kept here and compared before the
+// keys, so two keys are only compared when all 64 bits match; keys that
+// share just the folded bits cost a bucket chain step, not a comparison.
+template <typename Key>
+struct OrderedHashHashedKey
+{
+    Key key;
+    quint64 h;
+
+    inline OrderedHashHashedKey() : key(), h(0) {}
+    inline OrderedHashHashedKey(const Key &key, quint64 h) :
+        key(key), h(h) {}
+
+    inline bool operator==(const OrderedHashHashedKey &o) const
+        { return h == o.h && key == o.key; }
+
+    // A friend, so it is only found through the key type and does not hide
+    // the global qHash() overloads inside this namespace.
+    friend inline uint qHash(const OrderedHashHashedKey &key, uint seed = 0)
+    {
+        Q_UNUSED(seed);
+        return uint(key.h ^ (key.h >> 32));
+    }
+};
+
+template <typename Key, typename Hasher>
+struct OrderedHashKeyTraits
+{
+    typedef OrderedHashHashedKey<Key> Stored;
+
+    static inline Stored store(const Hasher &hasher, const Key &key)
+        { return Stored(key, hasher(key)); }
+
+    // Bits used by the flat engine to pick a slot, from the top down.
+    static inline quint64 spread(const Hasher &hasher, const Key &key)
+        { return hasher(key); }
+};
+
+template <typename Key>
+struct OrderedHashKeyTraits<Key, DefaultHashPolicy>
+{
+    typedef Key Stored;
+
+    static inline const Key &store(const DefaultHashPolicy &, const Key &key)
+        { return key; }
+
+    // Fibonacci hashing: cheap, and spreads sequential IDs evenly.
+    static inline quint64 spread(const DefaultHashPolicy &, const Key &key)
+        { return quint64(key) * Q_UINT64_C(0x9E3779B97F4A7C15); }
+};
+
+}   // namespace qtcollections
+
+template <typename Key>
+class QTypeInfo<qtcollections::OrderedHashHashedKey<Key> > :
+        public qtcollections::TypeInfoMerger<
+            qtcollections::OrderedHashHashedKey<Key>, Key>
+{};
+
+#endif // QTCOLLECTIONS_HASHPOLICY_H
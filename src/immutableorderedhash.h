@@ -0,0 +1,626 @@
+#ifndef QTCOLLECTIONS_IMMUTABLEORDEREDHASH_H
+#define QTCOLLECTIONS_IMMUTABLEORDEREDHASH_H
+
+#ifdef Q_COMPILER_INITIALIZER_LISTS
+#include <initializer_list>
+#endif
+#include <iterator>
+#include <QExplicitlySharedDataPointer>
+#include <QHash>
+#include <QList>
+#include <QSharedData>
+#include <QtAlgorithms>
+#include <QVector>
+#include "qtcollections_global.h"
+#include "orderedhash.h"
+
+namespace qtcollections
+{
+
+// Node of the key trie, a hash array mapped trie (in its CHAMP layout)
+// mapping each key to its sequence number. Slots set in dataMap hold an
+// entry, slots set in nodeMap hold a subnode; both arrays are compressed,
+// and a slot's position is the population count of the lower bits. Nodes
+// below the last level of hash bits hold colliding entries unsorted.
+template <typename Key>
+struct ImmutableOrderedHashKeyNode : public QSharedData
+{
+    typedef QExplicitlySharedDataPointer<ImmutableOrderedHashKeyNode> Pointer;
+    struct Entry
+    {
+        Key key;
+        qint64 seq;
+    };
+
+    quint32 dataMap;
+    quint32 nodeMap;
+    QVector<Entry> entries;
+    QVector<Pointer> nodes;
+
+    inline ImmutableOrderedHashKeyNode() : dataMap(0), nodeMap(0) {}
+};
+
+// Node of the order trie, a sparse radix trie over sequence numbers. Leaf
+// nodes (level 0) hold the entries; walking it in slot order yields the
+// entries in insertion order.
+template <typename Key, typename T>
+struct ImmutableOrderedHashOrderNode : public QSharedData
+{
+    typedef QExplicitlySharedDataPointer<ImmutableOrderedHashOrderNode>
+            Pointer;
+    struct Entry
+    {
+        Key key;
+        T value;
+    };
+
+    quint32 bitmap;
+    QVector<Pointer> children;
+    QVector<Entry> entries;
+
+    inline ImmutableOrderedHashOrderNode() : bitmap(0) {}
+};
+
+// A persistent, insertion-ordered hash.
+//
+// An ImmutableOrderedHash never changes once built. inserted(), updated()
+// and removed() return a new version in O(log n); it shares all nodes off
+// the modified paths with the version it was derived from, so keeping many
+// versions costs memory proportional to the changes between them. Copying
+// a version is O(1).
+//
+// Each key gets an increasing sequence number when first inserted. The key
+// trie maps keys to sequence numbers, and the order trie maps sequence
+// numbers to entries, which gives ordered iteration.
+template <typename Key, typename T>
+class QTCOLLECTIONS_SHARED_EXPORT ImmutableOrderedHash
+{
+    typedef ImmutableOrderedHashKeyNode<Key> KeyNode;
+    typedef ImmutableOrderedHashOrderNode<Key, T> OrderNode;
+    typedef typename KeyNode::Pointer KeyPointer;
+    typedef typename OrderNode::Pointer OrderPointer;
+    typedef typename OrderNode::Entry Entry;
+
+    enum { Bits = 5, MaxLevels = 13 };
+
+    KeyPointer keyRoot;
+    OrderPointer orderRoot;
+    int levels;
+    int entryCount;
+    qint64 nextSeq;
+
+public:
+    inline ImmutableOrderedHash() : levels(0), entryCount(0), nextSeq(0) {}
+#ifdef Q_COMPILER_INITIALIZER_LISTS
+    ImmutableOrderedHash(std::initializer_list<std::pair<Key,T> > list);
+#endif
+    explicit ImmutableOrderedHash(const OrderedHash<Key, T> &hash);
+
+    bool operator==(const ImmutableOrderedHash &other) const;
+    inline bool operator!=(const ImmutableOrderedHash &other) const
+        { return !(*this == other); }
+
+    inline int size() const { return entryCount; }
+    inline int count() const { return entryCount; }
+    inline bool isEmpty() const { return entryCount == 0; }
+
+    inline bool contains(const Key &key) const
+        { return seqOf(key) >= 0; }
+    const T value(const Key &key) const { return value(key, T()); }
+    const T value(const Key &key, const T &defaultValue) const;
+
+    // New versions. inserted() appends a new key, or replaces the value of
+    // an existing key without moving it; updated() only does the latter,
+    // and returns an unchanged copy if the key is missing.
+    ImmutableOrderedHash inserted(const Key &key, const T &value) const;
+    ImmutableOrderedHash updated(const Key &key, const T &value) const;
+    ImmutableOrderedHash removed(const Key &key) const;
+
+    QList<Key> keys() const;
+    QList<T> values() const;
+    OrderedHash<Key, T> toOrderedHash() const;
+
+    const Key &firstKey() const { return firstEntry().key; }
+    const Key &lastKey() const { return lastEntry().key; }
+    const T &first() const { return firstEntry().value; }
+    const T &last() const { return lastEntry().value; }
+
+    class const_iterator
+    {
+        friend class ImmutableOrderedHash;
+
+        // Path from the root to the current leaf; nodes[0] is the leaf,
+        // and is null at the end.
+        const OrderNode *nodes[MaxLevels];
+        int positions[MaxLevels];
+        int levels;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef T value_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        inline const_iterator() : levels(0) { nodes[0] = 0; }
+
+        inline const Key &key() const
+            { return nodes[0]->entries.at(positions[0]).key; }
+        inline const T &value() const
+            { return nodes[0]->entries.at(positions[0]).value; }
+        inline const T &operator*() const { return value(); }
+        inline const T *operator->() const { return &value(); }
+
+        inline bool operator==(const const_iterator &o) const
+        {
+            return nodes[0] == o.nodes[0]
+                    && (!nodes[0] || positions[0] == o.positions[0]);
+        }
+        inline bool operator!=(const const_iterator &o) const
+            { return !(*this == o); }
+
+        const_iterator &operator++();
+        inline const_iterator operator++(int)
+        {
+            const_iterator r = *this;
+            ++*this;
+            return r;
+        }
+
+    private:
+        void descend(int level);
+    };
+
+    // STL-style iteration.
+    const_iterator begin() const;
+    inline const_iterator cbegin() const { return begin(); }
+    inline const_iterator constBegin() const { return begin(); }
+    inline const_iterator end() const { return const_iterator(); }
+    inline const_iterator cend() const { return end(); }
+    inline const_iterator constEnd() const { return end(); }
+
+    // STL compatibility.
+    typedef T mapped_type;
+    typedef Key key_type;
+    typedef qptrdiff difference_type;
+    typedef int size_type;
+    typedef const_iterator ConstIterator;
+    inline bool empty() const { return isEmpty(); }
+
+private:
+    static inline int slot(quint32 bitmap, quint32 bit)
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
+        return qPopulationCount(bitmap & (bit - 1));
+#elif defined(Q_CC_GNU)
+        return __builtin_popcount(bitmap & (bit - 1));
+#else
+        int n = 0;
+        for (quint32 v = bitmap & (bit - 1); v; v &= v - 1)
+            n++;
+        return n;
+#endif
+    }
+
+    qint64 seqOf(const Key &key) const;
+    const Entry *entryAt(qint64 seq) const;
+    const Entry &firstEntry() const;
+    const Entry &lastEntry() const;
+
+    static KeyPointer withKey(const KeyNode *node, const Key &key, uint hash,
+                              qint64 seq, int shift);
+    static KeyPointer withoutKey(const KeyNode *node, const Key &key,
+                                 uint hash, int shift);
+    static OrderPointer withEntry(const OrderNode *node, int level,
+                                  qint64 seq, const Entry &entry);
+    static OrderPointer withoutEntry(const OrderNode *node, int level,
+                                     qint64 seq);
+};
+
+#ifdef Q_COMPILER_INITIALIZER_LISTS
+template <typename Key, typename T>
+ImmutableOrderedHash<Key, T>::ImmutableOrderedHash(
+        std::initializer_list<std::pair<Key, T> > list) :
+    levels(0), entryCount(0), nextSeq(0)
+{
+    typedef typename std::initializer_list<std::pair<Key,T> >::const_iterator
+            InitListConstIterator;
+    for (InitListConstIterator it = list.begin(); it != list.end(); ++it)
+        *this = inserted(it->first, it->second);
+}
+#endif
+
+template <typename Key, typename T>
+ImmutableOrderedHash<Key, T>::ImmutableOrderedHash(
+        const OrderedHash<Key, T> &hash) :
+    levels(0), entryCount(0), nextSeq(0)
+{
+    typedef typename OrderedHash<Key, T>::const_iterator ConstIterator;
+    for (ConstIterator it = hash.constBegin(); it != hash.constEnd(); ++it)
+        *this = inserted(it.key(), it.value());
+}
+
+template <typename Key, typename T>
+bool ImmutableOrderedHash<Key, T>::operator==(
+        const ImmutableOrderedHash &other) const
+{
+    if (orderRoot == other.orderRoot)
+        return true;
+    if (entryCount != other.entryCount)
+        return false;
+    const_iterator it = constBegin();
+    const_iterator oit = other.constBegin();
+    for (; it != constEnd(); ++it, ++oit)
+    {
+        if (!(it.key() == oit.key()) || !(it.value() == oit.value()))
+            return false;
+    }
+    return true;
+}
+
+template <typename Key, typename T>
+const T ImmutableOrderedHash<Key, T>::value(
+        const Key &key, const T &defaultValue) const
+{
+    qint64 seq = seqOf(key);
+    if (seq < 0)
+        return defaultValue;
+    return entryAt(seq)->value;
+}
+
+template <typename Key, typename T>
+ImmutableOrderedHash<Key, T> ImmutableOrderedHash<Key, T>::inserted(
+        const Key &key, const T &value) const
+{
+    qint64 seq = seqOf(key);
+    if (seq >= 0)
+        return updated(key, value);
+
+    ImmutableOrderedHash r = *this;
+    seq = r.nextSeq++;
+    r.keyRoot = withKey(keyRoot.data(), key, qHash(key), seq, 0);
+
+    // Grow the order trie upwards until it can address the new number.
+    if (!r.orderRoot)
+        r.levels = 1;
+    while (r.levels < MaxLevels && (seq >> (Bits * r.levels)))
+    {
+        if (r.orderRoot)
+        {
+            OrderPointer root(new OrderNode);
+            root->bitmap = 1;
+            root->children.append(r.orderRoot);
+            r.orderRoot = root;
+        }
+        r.levels++;
+    }
+    Entry entry = { key, value };
+    r.orderRoot = withEntry(r.orderRoot.data(), r.levels - 1, seq, entry);
+    r.entryCount++;
+    return r;
+}
+
+template <typename Key, typename T>
+ImmutableOrderedHash<Key, T> ImmutableOrderedHash<Key, T>::updated(
+        const Key &key, const T &value) const
+{
+    qint64 seq = seqOf(key);
+    if (seq < 0)
+        return *this;
+
+    ImmutableOrderedHash r = *this;
+    Entry entry = { key, value };
+    r.orderRoot = withEntry(orderRoot.data(), levels - 1, seq, entry);
+    return r;
+}
+
+template <typename Key, typename T>
+ImmutableOrderedHash<Key, T> ImmutableOrderedHash<Key, T>::removed(
+        const Key &key) const
+{
+    qint64 seq = seqOf(key);
+    if (seq < 0)
+        return *this;
+
+    ImmutableOrderedHash r = *this;
+    r.keyRoot = withoutKey(keyRoot.data(), key, qHash(key), 0);
+    r.orderRoot = withoutEntry(orderRoot.data(), levels - 1, seq);
+    r.entryCount--;
+    return r;
+}
+
+template <typename Key, typename T>
+QList<Key> ImmutableOrderedHash<Key, T>::keys() const
+{
+    QList<Key> keys;
+    keys.reserve(entryCount);
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        keys.append(it.key());
+    return keys;
+}
+
+template <typename Key, typename T>
+QList<T> ImmutableOrderedHash<Key, T>::values() const
+{
+    QList<T> values;
+    values.reserve(entryCount);
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        values.append(it.value());
+    return values;
+}
+
+template <typename Key, typename T>
+OrderedHash<Key, T> ImmutableOrderedHash<Key, T>::toOrderedHash() const
+{
+    OrderedHash<Key, T> hash;
+    hash.reserve(entryCount);
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        hash.insert(it.key(), it.value());
+    return hash;
+}
+
+template <typename Key, typename T>
+typename ImmutableOrderedHash<Key, T>::const_iterator
+ImmutableOrderedHash<Key, T>::begin() const
+{
+    const_iterator it;
+    if (!orderRoot)
+        return it;
+    it.levels = levels;
+    it.nodes[levels - 1] = orderRoot.data();
+    it.descend(levels - 1);
+    return it;
+}
+
+template <typename Key, typename T>
+void ImmutableOrderedHash<Key, T>::const_iterator::descend(int level)
+{
+    positions[level] = 0;
+    for (; level > 0; level--)
+    {
+        nodes[level - 1] = nodes[level]->children.at(0).data();
+        positions[level - 1] = 0;
+    }
+}
+
+template <typename Key, typename T>
+typename ImmutableOrderedHash<Key, T>::const_iterator &
+ImmutableOrderedHash<Key, T>::const_iterator::operator++()
+{
+    if (++positions[0] < nodes[0]->entries.size())
+        return *this;
+    for (int level = 1; level < levels; level++)
+    {
+        if (++positions[level] < nodes[level]->children.size())
+        {
+            nodes[level - 1] =
+                    nodes[level]->children.at(positions[level]).data();
+            descend(level - 1);
+            return *this;
+        }
+    }
+    nodes[0] = 0;
+    return *this;
+}
+
+template <typename Key, typename T>
+qint64 ImmutableOrderedHash<Key, T>::seqOf(const Key &key) const
+{
+    const uint hash = qHash(key);
+    const KeyNode *node = keyRoot.data();
+    for (int shift = 0; node; shift += Bits)
+    {
+        if (shift >= 32)
+        {
+            for (int i = 0; i < node->entries.size(); i++)
+            {
+                if (node->entries.at(i).key == key)
+                    return node->entries.at(i).seq;
+            }
+            return -1;
+        }
+        const quint32 bit = 1u << ((hash >> shift) & 31);
+        if (node->dataMap & bit)
+        {
+            const typename KeyNode::Entry &e =
+                    node->entries.at(slot(node->dataMap, bit));
+            return e.key == key ? e.seq : -1;
+        }
+        if (!(node->nodeMap & bit))
+            return -1;
+        node = node->nodes.at(slot(node->nodeMap, bit)).data();
+    }
+    return -1;
+}
+
+template <typename Key, typename T>
+const typename ImmutableOrderedHash<Key, T>::Entry *
+ImmutableOrderedHash<Key, T>::entryAt(qint64 seq) const
+{
+    const OrderNode *node = orderRoot.data();
+    for (int level = levels - 1; node; level--)
+    {
+        const quint32 bit = 1u << ((seq >> (Bits * level)) & 31);
+        if (!(node->bitmap & bit))
+            return 0;
+        if (level == 0)
+            return &node->entries.at(slot(node->bitmap, bit));
+        node = node->children.at(slot(node->bitmap, bit)).data();
+    }
+    return 0;
+}
+
+template <typename Key, typename T>
+const typename ImmutableOrderedHash<Key, T>::Entry &
+ImmutableOrderedHash<Key, T>::firstEntry() const
+{
+    Q_ASSERT(!isEmpty());
+    const OrderNode *node = orderRoot.data();
+    for (int level = levels - 1; level > 0; level--)
+        node = node->children.first().data();
+    return node->entries.first();
+}
+
+template <typename Key, typename T>
+const typename ImmutableOrderedHash<Key, T>::Entry &
+ImmutableOrderedHash<Key, T>::lastEntry() const
+{
+    Q_ASSERT(!isEmpty());
+    const OrderNode *node = orderRoot.data();
+    for (int level = levels - 1; level > 0; level--)
+        node = node->children.last().data();
+    return node->entries.last();
+}
+
+template <typename Key, typename T>
+typename ImmutableOrderedHash<Key, T>::KeyPointer
+ImmutableOrderedHash<Key, T>::withKey(
+        const KeyNode *node, const Key &key, uint hash, qint64 seq,
+        int shift)
+{
+    KeyPointer n(node ? new KeyNode(*node) : new KeyNode);
+    typename KeyNode::Entry entry = { key, seq };
+    if (shift >= 32)
+    {
+        n->entries.append(entry);
+        return n;
+    }
+
+    const quint32 bit = 1u << ((hash >> shift) & 31);
+    if (n->dataMap & bit)
+    {
+        // The slot is taken by another key; push both one level down.
+        const int i = slot(n->dataMap, bit);
+        typename KeyNode::Entry other = n->entries.at(i);
+        n->entries.remove(i);
+        n->dataMap &= ~bit;
+        KeyPointer child = withKey(0, other.key, qHash(other.key), other.seq,
+                                   shift + Bits);
+        child = withKey(child.data(), key, hash, seq, shift + Bits);
+        n->nodes.insert(slot(n->nodeMap, bit), child);
+        n->nodeMap |= bit;
+    }
+    else if (n->nodeMap & bit)
+    {
+        const int i = slot(n->nodeMap, bit);
+        n->nodes[i] = withKey(n->nodes.at(i).data(), key, hash, seq,
+                              shift + Bits);
+    }
+    else
+    {
+        n->entries.insert(slot(n->dataMap, bit), entry);
+        n->dataMap |= bit;
+    }
+    return n;
+}
+
+template <typename Key, typename T>
+typename ImmutableOrderedHash<Key, T>::KeyPointer
+ImmutableOrderedHash<Key, T>::withoutKey(
+        const KeyNode *node, const Key &key, uint hash, int shift)
+{
+    KeyPointer n(new KeyNode(*node));
+    if (shift >= 32)
+    {
+        for (int i = 0; i < n->entries.size(); i++)
+        {
+            if (n->entries.at(i).key == key)
+            {
+                n->entries.remove(i);
+                break;
+            }
+        }
+        return n->entries.isEmpty() ? KeyPointer() : n;
+    }
+
+    const quint32 bit = 1u << ((hash >> shift) & 31);
+    if (n->dataMap & bit)
+    {
+        n->entries.remove(slot(n->dataMap, bit));
+        n->dataMap &= ~bit;
+    }
+    else
+    {
+        const int i = slot(n->nodeMap, bit);
+        KeyPointer child = withoutKey(n->nodes.at(i).data(), key, hash,
+                                      shift + Bits);
+        if (child && (child->nodeMap || child->entries.size() > 1))
+        {
+            n->nodes[i] = child;
+            return n;
+        }
+        // Keep the trie canonical: a subnode left with a single entry is
+        // replaced by that entry.
+        n->nodes.remove(i);
+        n->nodeMap &= ~bit;
+        if (child)
+        {
+            n->entries.insert(slot(n->dataMap, bit), child->entries.first());
+            n->dataMap |= bit;
+        }
+    }
+    return n->dataMap || n->nodeMap ? n : KeyPointer();
+}
+
+template <typename Key, typename T>
+typename ImmutableOrderedHash<Key, T>::OrderPointer
+ImmutableOrderedHash<Key, T>::withEntry(
+        const OrderNode *node, int level, qint64 seq, const Entry &entry)
+{
+    OrderPointer n(node ? new OrderNode(*node) : new OrderNode);
+    const quint32 bit = 1u << ((seq >> (Bits * level)) & 31);
+    const int i = slot(n->bitmap, bit);
+    if (level == 0)
+    {
+        if (n->bitmap & bit)
+            n->entries[i] = entry;
+        else
+            n->entries.insert(i, entry);
+    }
+    else
+    {
+        const OrderNode *child =
+                (n->bitmap & bit) ? n->children.at(i).data() : 0;
+        OrderPointer updated = withEntry(child, level - 1, seq, entry);
+        if (child)
+            n->children[i] = updated;
+        else
+            n->children.insert(i, updated);
+    }
+    n->bitmap |= bit;
+    return n;
+}
+
+template <typename Key, typename T>
+typename ImmutableOrderedHash<Key, T>::OrderPointer
+ImmutableOrderedHash<Key, T>::withoutEntry(
+        const OrderNode *node, int level, qint64 seq)
+{
+    OrderPointer n(new OrderNode(*node));
+    const quint32 bit = 1u << ((seq >> (Bits * level)) & 31);
+    const int i = slot(n->bitmap, bit);
+    if (level == 0)
+    {
+        n->entries.remove(i);
+        n->bitmap &= ~bit;
+    }
+    else
+    {
+        OrderPointer child = withoutEntry(n->children.at(i).data(),
+                                          level - 1, seq);
+        if (child)
+        {
+            n->children[i] = child;
+        }
+        else
+        {
+            n->children.remove(i);
+            n->bitmap &= ~bit;
+        }
+    }
+    return n->bitmap ? n : OrderPointer();
+}
+
+}   // namespace qtcollections
+
+#endif // QTCOLLECTIONS_IMMUTABLEORDEREDHASH_H
@@ -0,0 +1,121 @@
+#ifndef QTCOLLECTIONS_INTERNEDSTRING_H
+#define QTCOLLECTIONS_INTERNEDSTRING_H
+
+#include <QHash>
+#include <QtAlgorithms>
+#include <QReadWriteLock>
+#include <QString>
+#include "qtcollections_global.h"
+#include "orderedhash.h"
+
+namespace qtcollections
+{
+
+struct InternedStringData
+{
+    QString string;
+    uint hash;
+};
+
+// Process-wide table of interned strings. Entries are never released, so
+// the pool is meant for bounded vocabularies such as field names, not for
+// arbitrary user input.
+class QTCOLLECTIONS_SHARED_EXPORT InternedStringPool
+{
+    QReadWriteLock lock;
+    QHash<QString, InternedStringData *> strings;
+
+    InternedStringPool() {}
+    ~InternedStringPool() { qDeleteAll(strings); }
+    Q_DISABLE_COPY(InternedStringPool)
+
+public:
+    static InternedStringPool *instance()
+    {
+        static InternedStringPool pool;
+        return &pool;
+    }
+
+    // The pooled copy of string, or null if it has never been interned.
+    const InternedStringData *find(const QString &string)
+    {
+        QReadLocker locker(&lock);
+        return strings.value(string);
+    }
+
+    const InternedStringData *intern(const QString &string)
+    {
+        if (const InternedStringData *data = find(string))
+            return data;
+        QWriteLocker locker(&lock);
+        InternedStringData *&data = strings[string];
+        if (!data)
+        {
+            data = new InternedStringData;
+            data->string = string;
+            data->hash = qHash(string);
+        }
+        return data;
+    }
+
+    int size()
+    {
+        QReadLocker locker(&lock);
+        return strings.size();
+    }
+};
+
+// A handle to a string in InternedStringPool. Handles are pointer-sized and
+// trivially copyable; comparing two handles is a pointer comparison, and
+// the string's hash is computed only once, when it is first interned.
+//
+// Constructing a handle from a string interns it, which takes the pool's
+// write lock the first time and keeps the string for good, so the
+// constructors are explicit. Look keys up with find() instead: it never
+// adds to the pool, and returns the null handle for a string that was never
+// interned. The null handle equals no interned string, the empty one
+// included, so such a lookup finds nothing.
+class QTCOLLECTIONS_SHARED_EXPORT InternedString
+{
+    const InternedStringData *d;
+
+    explicit inline InternedString(const InternedStringData *d) : d(d) {}
+
+public:
+    inline InternedString() : d(0) {}
+    explicit inline InternedString(const QString &string) :
+        d(InternedStringPool::instance()->intern(string)) {}
+#ifndef QT_NO_CAST_FROM_ASCII
+    explicit inline InternedString(const char *string) :
+        d(InternedStringPool::instance()->intern(
+              QString::fromUtf8(string))) {}
+#endif
+
+    static inline InternedString find(const QString &string)
+        { return InternedString(InternedStringPool::instance()->find(string)); }
+
+    inline bool isNull() const { return !d; }
+    inline bool isEmpty() const { return !d || d->string.isEmpty(); }
+    inline uint hash() const { return d ? d->hash : 0; }
+    inline QString toString() const { return d ? d->string : QString(); }
+
+    inline bool operator==(const InternedString &o) const { return d == o.d; }
+    inline bool operator!=(const InternedString &o) const { return d != o.d; }
+};
+
+inline uint qHash(const InternedString &key, uint seed = 0)
+{
+    return key.hash() ^ seed;
+}
+
+#ifdef Q_COMPILER_TEMPLATE_ALIAS
+// OrderedHash in interned-key mode.
+template <typename T>
+using InternedOrderedHash = OrderedHash<InternedString, T>;
+#endif
+
+}   // namespace qtcollections
+
+Q_DECLARE_TYPEINFO(qtcollections::InternedString, Q_PRIMITIVE_TYPE);
+
+#endif // QTCOLLECTIONS_INTERNEDSTRING_H
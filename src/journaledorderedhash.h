@@ -0,0 +1,402 @@
+#ifndef QTCOLLECTIONS_JOURNALEDORDEREDHASH_H
+#define QTCOLLECTIONS_JOURNALEDORDEREDHASH_H
+
+#include <QDataStream>
+#include <QVector>
+#include "qtcollections_global.h"
+#include "hashpolicy.h"
+#include "orderedhash.h"
+
+namespace qtcollections
+{
+
+// One change to an OrderedHash, as recorded by JournaledOrderedHash.
+// MoveBefore moves the entry of key right before the entry of before.
+template <typename Key, typename T>
+struct OrderedHashChange
+{
+    enum Type
+    {
+        Insert,
+        Update,
+        Remove,
+        MoveToEnd,
+        MoveBefore,
+        Clear
+    };
+
+    Type type;
+    Key key;
+    T value;
+    Key before;
+
+    inline OrderedHashChange() : type(Clear), key(), value(), before() {}
+    inline OrderedHashChange(Type type, const Key &key = Key(),
+                             const T &value = T(),
+                             const Key &before = Key()) :
+        type(type), key(key), value(value), before(before) {}
+};
+
+// The changes taking a hash from version `from` to version `to`. A snapshot
+// has no `from`; it starts with a Clear and inserts every entry in order,
+// and brings a hash of any version up to `to`.
+template <typename Key, typename T>
+struct OrderedHashDelta
+{
+    typedef OrderedHashChange<Key, T> Change;
+
+    qint64 from;
+    qint64 to;
+    QVector<Change> changes;
+
+    inline OrderedHashDelta() : from(0), to(0) {}
+
+    inline bool isSnapshot() const { return from < 0; }
+    inline bool isEmpty() const { return !isSnapshot() && from == to; }
+};
+
+// An OrderedHash that keeps a journal of its changes, for keeping replicas
+// of it up to date.
+//
+// Every change bumps the version by one and is appended to the journal, a
+// ring buffer holding the latest journalCapacity() changes. changesSince()
+// returns what a replica at an older version is missing: the journaled
+// changes after that version, or a snapshot of the whole hash if the
+// journal no longer reaches back that far, or if the snapshot would be
+// smaller anyway. The replica passes the delta to applyChanges(). Deltas
+// can be written to and read from a QDataStream.
+//
+// Like OrderedHashModel, this owns its hash, and changes must go through
+// its own insert(), remove() and friends to be journaled. A replica
+// journals the changes it applies too, so it can pass them on to replicas
+// of its own.
+template <typename Key, typename T, typename Hasher = DefaultHashPolicy>
+class QTCOLLECTIONS_SHARED_EXPORT JournaledOrderedHash
+{
+public:
+    typedef OrderedHash<Key, T, Hasher> Hash;
+    typedef OrderedHashChange<Key, T> Change;
+    typedef OrderedHashDelta<Key, T> Delta;
+
+    explicit JournaledOrderedHash(int journalCapacity = 1024) :
+        ver(0), first(0), count(0), capacity(qMax(0, journalCapacity)) {}
+
+    inline const Hash &hash() const { return h; }
+    inline qint64 version() const { return ver; }
+
+    // Replaces the whole hash. The journal is dropped, so replicas of any
+    // earlier version get a snapshot next.
+    void setHash(const Hash &hash);
+
+    inline int journalCapacity() const { return capacity; }
+    inline int journalSize() const { return count; }
+    void setJournalCapacity(int journalCapacity);
+
+    inline int size() const { return h.size(); }
+    inline bool isEmpty() const { return h.isEmpty(); }
+    inline bool contains(const Key &key) const { return h.contains(key); }
+    inline const T value(const Key &key) const { return h.value(key); }
+    inline const T value(const Key &key, const T &defaultValue) const
+        { return h.value(key, defaultValue); }
+
+    // Changes, journaled. Changes that leave the hash as it was are not.
+    void insert(const Key &key, const T &value);
+    int remove(const Key &key);
+    T take(const Key &key);
+    void moveToEnd(const Key &key);
+    void move(const Key &key, const Key &before);
+    void clear();
+
+    Delta changesSince(qint64 version) const;
+    Delta snapshot() const;
+
+    // Brings the hash up to delta.to. Returns false, and leaves the hash
+    // alone, if the delta does not start at this hash's version.
+    bool applyChanges(const Delta &delta);
+
+private:
+    Hash h;
+    qint64 ver;
+
+    // The latest `count` changes, oldest first, starting at `first`. The
+    // ring only wraps once it has grown to its capacity.
+    QVector<Change> ring;
+    int first;
+    int count;
+    int capacity;
+
+    void apply(const Change &change);
+    void record(const Change &change);
+    inline void commit(const Change &change)
+    {
+        ver++;
+        record(change);
+    }
+
+    inline const Change &changeAt(int i) const
+        { return ring.at((first + i) % ring.size()); }
+    inline void dropJournal()
+    {
+        first = 0;
+        count = 0;
+    }
+};
+
+template <typename Key, typename T, typename Hasher>
+void JournaledOrderedHash<Key, T, Hasher>::setHash(const Hash &hash)
+{
+    h = hash;
+    ver++;
+    dropJournal();
+}
+
+template <typename Key, typename T, typename Hasher>
+void JournaledOrderedHash<Key, T, Hasher>::setJournalCapacity(
+        int journalCapacity)
+{
+    capacity = qMax(0, journalCapacity);
+    const int kept = qMin(count, capacity);
+    QVector<Change> changes;
+    changes.reserve(kept);
+    for (int i = count - kept; i < count; i++)
+        changes.append(changeAt(i));
+    ring = changes;
+    first = 0;
+    count = kept;
+}
+
+template <typename Key, typename T, typename Hasher>
+void JournaledOrderedHash<Key, T, Hasher>::insert(const Key &key,
+                                                  const T &value)
+{
+    Change change(h.contains(key) ? Change::Update : Change::Insert,
+                  key, value);
+    apply(change);
+    commit(change);
+}
+
+template <typename Key, typename T, typename Hasher>
+int JournaledOrderedHash<Key, T, Hasher>::remove(const Key &key)
+{
+    if (!h.contains(key))
+        return 0;
+    Change change(Change::Remove, key);
+    apply(change);
+    commit(change);
+    return 1;
+}
+
+template <typename Key, typename T, typename Hasher>
+T JournaledOrderedHash<Key, T, Hasher>::take(const Key &key)
+{
+    typename Hash::Node node = h.extract(key);
+    if (node.isEmpty())
+        return T();
+    commit(Change(Change::Remove, key));
+    return node.value();
+}
+
+template <typename Key, typename T, typename Hasher>
+void JournaledOrderedHash<Key, T, Hasher>::moveToEnd(const Key &key)
+{
+    if (!h.contains(key) || h.lastKey() == key)
+        return;
+    Change change(Change::MoveToEnd, key);
+    apply(change);
+    commit(change);
+}
+
+// Without an entry for before, this is moveToEnd().
+template <typename Key, typename T, typename Hasher>
+void JournaledOrderedHash<Key, T, Hasher>::move(const Key &key,
+                                                const Key &before)
+{
+    typename Hash::const_iterator it = h.constFind(key);
+    if (it == h.constEnd() || key == before)
+        return;
+    if (!h.contains(before))
+    {
+        moveToEnd(key);
+        return;
+    }
+    if (++it != h.constEnd() && it.key() == before)
+        return;
+    Change change(Change::MoveBefore, key, T(), before);
+    apply(change);
+    commit(change);
+}
+
+template <typename Key, typename T, typename Hasher>
+void JournaledOrderedHash<Key, T, Hasher>::clear()
+{
+    if (h.isEmpty())
+        return;
+    Change change(Change::Clear);
+    apply(change);
+    commit(change);
+}
+
+template <typename Key, typename T, typename Hasher>
+typename JournaledOrderedHash<Key, T, Hasher>::Delta
+JournaledOrderedHash<Key, T, Hasher>::changesSince(qint64 version) const
+{
+    // A version ahead of this hash belongs to some other history.
+    if (version > ver || ver - version > count
+            || ver - version > h.size() + 1)
+        return snapshot();
+    const int n = int(ver - version);
+    Delta delta;
+    delta.from = version;
+    delta.to = ver;
+    delta.changes.reserve(n);
+    for (int i = count - n; i < count; i++)
+        delta.changes.append(changeAt(i));
+    return delta;
+}
+
+template <typename Key, typename T, typename Hasher>
+typename JournaledOrderedHash<Key, T, Hasher>::Delta
+JournaledOrderedHash<Key, T, Hasher>::snapshot() const
+{
+    Delta delta;
+    delta.from = -1;
+    delta.to = ver;
+    delta.changes.reserve(h.size() + 1);
+    delta.changes.append(Change(Change::Clear));
+    for (typename Hash::const_iterator it = h.constBegin();
+         it != h.constEnd(); ++it)
+        delta.changes.append(Change(Change::Insert, it.key(), it.value()));
+    return delta;
+}
+
+template <typename Key, typename T, typename Hasher>
+bool JournaledOrderedHash<Key, T, Hasher>::applyChanges(const Delta &delta)
+{
+    if (delta.isSnapshot())
+    {
+        for (int i = 0; i < delta.changes.size(); i++)
+            apply(delta.changes.at(i));
+        ver = delta.to;
+        dropJournal();
+        return true;
+    }
+    if (delta.from != ver || delta.to - delta.from != delta.changes.size())
+        return false;
+    for (int i = 0; i < delta.changes.size(); i++)
+    {
+        apply(delta.changes.at(i));
+        commit(delta.changes.at(i));
+    }
+    return true;
+}
+
+template <typename Key, typename T, typename Hasher>
+void JournaledOrderedHash<Key, T, Hasher>::apply(const Change &change)
+{
+    switch (change.type)
+    {
+    case Change::Insert:
+    case Change::Update:
+        h.insert(change.key, change.value);
+        break;
+    case Change::Remove:
+        h.remove(change.key);
+        break;
+    case Change::MoveToEnd:
+    case Change::MoveBefore:
+    {
+        // Relinks the entry without copying it.
+        typename Hash::Node node = h.extract(change.key);
+        if (change.type == Change::MoveToEnd)
+            h.insert(node);
+        else
+            h.insert(node, h.find(change.before));
+        break;
+    }
+    case Change::Clear:
+        h.clear();
+        break;
+    }
+}
+
+template <typename Key, typename T, typename Hasher>
+void JournaledOrderedHash<Key, T, Hasher>::record(const Change &change)
+{
+    if (count < ring.size())
+    {
+        ring[(first + count) % ring.size()] = change;
+        count++;
+    }
+    else if (ring.size() < capacity)
+    {
+        ring.append(change);
+        count++;
+    }
+    else if (capacity)
+    {
+        ring[first] = change;
+        first = (first + 1) % ring.size();
+    }
+}
+
+// Keys and values are streamed with their own QDataStream operators, and
+// only where the type of change needs them.
+template <typename Key, typename T>
+QDataStream &operator<<(QDataStream &out,
+                        const OrderedHashChange<Key, T> &change)
+{
+    typedef OrderedHashChange<Key, T> Change;
+    out << qint8(change.type);
+    if (change.type != Change::Clear)
+        out << change.key;
+    if (change.type == Change::Insert || change.type == Change::Update)
+        out << change.value;
+    if (change.type == Change::MoveBefore)
+        out << change.before;
+    return out;
+}
+
+template <typename Key, typename T>
+QDataStream &operator>>(QDataStream &in, OrderedHashChange<Key, T> &change)
+{
+    typedef OrderedHashChange<Key, T> Change;
+    qint8 type;
+    in >> type;
+    if (type < Change::Insert || type > Change::Clear)
+    {
+        in.setStatus(QDataStream::ReadCorruptData);
+        change = Change();
+        return in;
+    }
+    change = Change(typename Change::Type(type));
+    if (change.type != Change::Clear)
+        in >> change.key;
+    if (change.type == Change::Insert || change.type == Change::Update)
+        in >> change.value;
+    if (change.type == Change::MoveBefore)
+        in >> change.before;
+    return in;
+}
+
+template <typename Key, typename T>
+QDataStream &operator<<(QDataStream &out,
+                        const OrderedHashDelta<Key, T> &delta)
+{
+    return out << delta.from << delta.to << delta.changes;
+}
+
+template <typename Key, typename T>
+QDataStream &operator>>(QDataStream &in, OrderedHashDelta<Key, T> &delta)
+{
+    return in >> delta.from >> delta.to >> delta.changes;
+}
+
+}   // namespace qtcollections
+
+template <typename Key, typename T>
+class QTypeInfo<qtcollections::OrderedHashChange<Key, T> > :
+        public qtcollections::TypeInfoMerger<
+            qtcollections::OrderedHashChange<Key, T>, Key, T>
+{};
+
+#endif // QTCOLLECTIONS_JOURNALEDORDEREDHASH_H
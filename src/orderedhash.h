@@ -4,36 +4,245 @@
 #ifdef Q_COMPILER_INITIALIZER_LISTS
 #include <initializer_list>
 #endif
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <string.h>
+#include <QBitArray>
+#include <QByteArray>
 #include <QHash>
 #include <QLinkedList>
 #include <QPair>
 #include <QScopedPointer>
+#include <QSet>
+#include <QString>
+#include <QVariant>
+#include <QVector>
 #include "qtcollections_global.h"
+#include "hashpolicy.h"
+#if defined(Q_CC_MSVC) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
 
 namespace qtcollections
 {
 
-template <typename Key, typename T>
+// Hints that the memory at p is about to be read.
+inline void orderedHashPrefetch(const void *p)
+{
+#if defined(Q_CC_GNU)
+    __builtin_prefetch(p);
+#elif defined(Q_CC_MSVC) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char *>(p), _MM_HINT_T0);
+#else
+    Q_UNUSED(p);
+#endif
+}
+
+// One of the node engine's hashes. By default this is just a QHash. In
+// incremental mode, a full table is not rehashed in one go: a table twice
+// the size is started next to it, and the engine moves a few entries over
+// on each subsequent insertion or removal. Lookups check both tables until
+// the old one is empty.
+//
+// Keys are hashed through the hash policy; see OrderedHashKeyTraits.
+template <typename Key, typename V, typename Hasher = DefaultHashPolicy>
+struct OrderedHashTable
+{
+    typedef OrderedHashKeyTraits<Key, Hasher> Traits;
+    typedef typename Traits::Stored Stored;
+    typedef typename QHash<Stored, V>::iterator Iterator;
+    typedef typename QHash<Stored, V>::const_iterator ConstIterator;
+    QHash<Stored, V> current;
+    QHash<Stored, V> previous;  // Entries not yet moved to current.
+    Iterator cursor;            // Next entry of previous to move.
+    Hasher hasher;
+
+    explicit OrderedHashTable(const Hasher &hasher = Hasher()) :
+        hasher(hasher) {}
+    OrderedHashTable(const OrderedHashTable &o) :
+        current(o.current), hasher(o.hasher)
+    {
+        for (ConstIterator it = o.previous.constBegin();
+             it != o.previous.constEnd(); ++it)
+            current.insert(it.key(), it.value());
+    }
+
+    OrderedHashTable &operator=(const OrderedHashTable &o)
+    {
+        OrderedHashTable copy(o);
+        current.swap(copy.current);
+        previous.clear();
+        hasher = o.hasher;
+        return *this;
+    }
+
+    inline int size() const { return current.size() + previous.size(); }
+    inline int capacity() const { return current.capacity(); }
+
+    void reserve(int size)
+    {
+        finish();
+        current.reserve(size);
+    }
+
+    void squeeze()
+    {
+        finish();
+        current.squeeze();
+    }
+
+    void clear()
+    {
+        current.clear();
+        previous.clear();
+    }
+
+    const V *constFind(const Key &key) const
+    {
+        const Stored &k = Traits::store(hasher, key);
+        ConstIterator it = current.constFind(k);
+        if (it != current.constEnd())
+            return &it.value();
+        if (previous.isEmpty())
+            return 0;
+        it = previous.constFind(k);
+        return it != previous.constEnd() ? &it.value() : 0;
+    }
+
+    V *find(const Key &key)
+    {
+        const Stored &k = Traits::store(hasher, key);
+        Iterator it = current.find(k);
+        if (it != current.end())
+            return &it.value();
+        if (previous.isEmpty())
+            return 0;
+        it = previous.find(k);
+        return it != previous.end() ? &it.value() : 0;
+    }
+
+    // Inserts a key that is in neither table.
+    void insert(const Key &key, const V &value, bool incremental)
+    {
+        if (current.size() >= current.capacity() && !current.isEmpty())
+        {
+            // QHash grows on this insertion; start a resize instead.
+            finish();
+            if (incremental)
+            {
+                previous.swap(current);
+                current.reserve(previous.capacity() * 2);
+                cursor = previous.begin();
+            }
+        }
+        current.insert(Traits::store(hasher, key), value);
+    }
+
+    void remove(const Key &key)
+    {
+        const Stored &k = Traits::store(hasher, key);
+        if (current.remove(k) || previous.isEmpty())
+            return;
+        Iterator it = previous.find(k);
+        if (it == previous.end())
+            return;
+        if (it == cursor)
+            cursor = previous.erase(it);
+        else
+            previous.erase(it);
+        if (previous.isEmpty())
+            previous.clear();
+    }
+
+    // Moves up to n entries from the old table to the new one.
+    void step(int n)
+    {
+        if (previous.isEmpty())
+            return;
+        for (; n > 0 && cursor != previous.end(); n--)
+        {
+            current.insert(cursor.key(), cursor.value());
+            cursor = previous.erase(cursor);
+        }
+        if (previous.isEmpty())
+            previous.clear();
+    }
+
+    void finish()
+    {
+        if (previous.isEmpty())
+            return;
+        for (ConstIterator it = previous.constBegin();
+             it != previous.constEnd(); ++it)
+            current.insert(it.key(), it.value());
+        previous.clear();
+    }
+};
+
+// Storage engines. Each engine exposes the same cursor-based interface so
+// OrderedHash and its iterators do not need to know how entries are kept:
+//
+//   Cursor begin(), end(), next(Cursor), previous(Cursor)
+//   const Key &key(Cursor), T &value(Cursor)
+//   Cursor find(const Key &), Cursor insert(const Key &, const T &)
+//   Cursor erase(Cursor), returning the cursor following the erased entry
+//   int erase(Cursor, Cursor), int removeIf(Predicate)
+//   void setIncrementalResize(bool), const Hasher &hashPolicy()
+//   void findMany(Iterator, Iterator, Sink &), calling the sink with a
+//       pointer to the value of each key in turn, or null if it is absent
+//   Cursor link(Cursor, Key &, T &), adding an absent key before the
+//       cursor, and void unlink(Cursor, Key &, T &), erasing an entry; both
+//       swap the key and value with the ones passed, though the node
+//       engine also copies the key into its hashes
+//
+// The node-based engine is used by default. Integral keys are stored in a
+// flat, open-addressed table instead (see the specialization below), unless
+// the policy is wrapped in NodeEngine.
+//
+// Other relocatable keys, such as QString, stay in the node engine. The flat
+// table keeps keys in its slots and marks empty ones with a key value, which
+// a string does not have to spare, and each probe would compare against the
+// key's heap data. Such keys need stored hashes and control bytes, which is
+// what GroupProbing<> provides. Making it their default is a separate step,
+// as it changes the iterator guarantees of every QString-keyed hash, and the
+// instantiations shipped in qtcollections.cpp along with them.
+
+template <typename Key, typename T, typename Hasher = DefaultHashPolicy,
+          bool isFlat = IsIntegral<Key>::value>
 struct QTCOLLECTIONS_SHARED_EXPORT OrderedHashData
 {
     typedef typename QLinkedList<Key>::iterator KeyIterator;
-    QHash<Key, T> hash;
+    typedef KeyIterator Cursor;
+    OrderedHashTable<Key, T, Hasher> hash;
     QLinkedList<Key> keys;
-    QHash<Key, KeyIterator> lookup;
+    OrderedHashTable<Key, KeyIterator, Hasher> lookup;
+    bool incremental;
 
-    OrderedHashData() {}
-    OrderedHashData(const OrderedHashData &o) : hash(o.hash), keys(o.keys)
+    explicit OrderedHashData(const Hasher &hasher = Hasher()) :
+        hash(hasher), lookup(hasher), incremental(false) {}
+    OrderedHashData(const OrderedHashData &o) :
+        hash(o.hash), keys(o.keys), lookup(o.lookup.hasher),
+        incremental(o.incremental)
     {
+        lookup.reserve(keys.size());
         for (KeyIterator i = keys.begin(); i != keys.end(); i++)
-            lookup.insert(*i, i);
+            lookup.insert(*i, i, false);
     }
 
+    inline const Hasher &hashPolicy() const { return lookup.hasher; }
+
+    inline int size() const { return hash.size(); }
+    inline int capacity() const { return hash.capacity(); }
+
     void reserve(int size)
     {
         hash.reserve(size);
         lookup.reserve(size);
     }
 
+    inline void squeeze() { reserve(1); }
+
     void clear()
     {
         hash.clear();
@@ -41,42 +250,815 @@ struct QTCOLLECTIONS_SHARED_EXPORT OrderedHashData
         lookup.clear();
     }
 
-    void erase(const KeyIterator &it)
+    void setIncrementalResize(bool enable)
+    {
+        incremental = enable;
+        if (!enable)
+        {
+            hash.finish();
+            lookup.finish();
+        }
+    }
+
+    inline Cursor begin() { return keys.begin(); }
+    inline Cursor end() { return keys.end(); }
+    inline Cursor next(Cursor i) const { return ++i; }
+    inline Cursor previous(Cursor i) const { return --i; }
+
+    inline const Key &key(Cursor i) const { return *i; }
+    inline T &value(Cursor i) { return *hash.find(*i); }
+    inline const T &value(Cursor i) const { return *hash.constFind(*i); }
+
+    inline Cursor find(const Key &key)
+    {
+        const KeyIterator *i = lookup.constFind(key);
+        return i ? *i : keys.end();
+    }
+
+    // QHash's buckets cannot be prefetched from outside, but going straight
+    // to the value hash at least skips the lookup hash and the key list.
+    template <typename Iterator, typename Sink>
+    void findMany(Iterator first, Iterator last, Sink &sink) const
+    {
+        for (; first != last; ++first)
+            sink(hash.constFind(*first));
+    }
+
+    Cursor insert(const Key &key, const T &value)
     {
-        Key key = *it;
+        T *v = hash.find(key);
+        if (v)
+        {
+            *v = value;
+            return *lookup.constFind(key);
+        }
+
+        hash.insert(key, value, incremental);
+        KeyIterator kit = keys.insert(keys.end(), key);
+        lookup.insert(key, kit, incremental);
+        step();
+        return kit;
+    }
+
+    // QHash and QLinkedList nodes cannot be handed from one container to
+    // another, so these allocate and free nodes like insert() and erase(),
+    // and copy the key into both hashes. Only the value and the listed key
+    // are swapped in and out.
+    Cursor link(Cursor before, Key &key, T &value)
+    {
+        hash.insert(key, T(), incremental);
+        qSwap(*hash.find(key), value);
+        KeyIterator kit = keys.insert(before, Key());
+        qSwap(*kit, key);
+        lookup.insert(*kit, kit, incremental);
+        step();
+        return kit;
+    }
+
+    void unlink(Cursor it, Key &key, T &value)
+    {
+        qSwap(value, *hash.find(*it));
+        hash.remove(*it);
+        lookup.remove(*it);
+        qSwap(key, *it);
         keys.erase(it);
-        hash.remove(key);
-        lookup.remove(key);
+        step();
+    }
+
+    Cursor erase(Cursor it)
+    {
+        hash.remove(*it);
+        lookup.remove(*it);
+        step();
+        return keys.erase(it);
+    }
+
+    // Removes the range in one pass: the keys leave both hashes without
+    // moving resize steps along, and the list drops them in a single
+    // erase. Erasing everything just clears.
+    int erase(Cursor first, Cursor last)
+    {
+        if (first == keys.begin() && last == keys.end())
+        {
+            const int removed = size();
+            clear();
+            return removed;
+        }
+        int removed = 0;
+        for (KeyIterator it = first; it != last; ++it)
+        {
+            hash.remove(*it);
+            lookup.remove(*it);
+            removed++;
+        }
+        keys.erase(first, last);
+        step();
+        return removed;
+    }
+
+    template <typename Predicate>
+    int removeIf(Predicate pred)
+    {
+        hash.finish();
+        lookup.finish();
+        int removed = 0;
+        KeyIterator it = keys.begin();
+        while (it != keys.end())
+        {
+            if (pred(*it, *hash.find(*it)))
+            {
+                hash.remove(*it);
+                lookup.remove(*it);
+                it = keys.erase(it);
+                removed++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+private:
+    // Entries moved per operation while a resize is in progress. A table
+    // doubles in size, so the move finishes long before it fills up again.
+    enum { ResizeStep = 8 };
+
+    inline void step()
+    {
+        hash.step(ResizeStep);
+        lookup.step(ResizeStep);
+    }
+};
+
+// Entry and slot types of the flat engine. These live at namespace scope so
+// QTypeInfo can be specialized for them right below, before anything
+// instantiates a QVector of them. That lets QVector grow them with memcpy
+// and skip destructors when Key and T allow it.
+
+template <typename Key, typename T>
+struct OrderedHashEntry
+{
+    Key key;
+    T value;
+
+    inline OrderedHashEntry() : key(), value() {}
+    inline OrderedHashEntry(const Key &key, const T &value) :
+        key(key), value(value) {}
+};
+
+template <typename Key>
+struct OrderedHashSlot
+{
+    Key key;
+    int index;
+};
+
+}   // namespace qtcollections
+
+template <typename Key, typename T>
+class QTypeInfo<qtcollections::OrderedHashEntry<Key, T> > :
+        public qtcollections::TypeInfoMerger<
+            qtcollections::OrderedHashEntry<Key, T>, Key, T>
+{};
+
+template <typename Key>
+class QTypeInfo<qtcollections::OrderedHashSlot<Key> > :
+        public qtcollections::TypeInfoMerger<
+            qtcollections::OrderedHashSlot<Key>, Key, int>
+{};
+
+namespace qtcollections
+{
+
+// Flat engine for integral keys.
+//
+// Entries are kept in a QVector in insertion order. Erasing an entry leaves
+// a hole, which is skipped during iteration and reclaimed in bulk when the
+// vector would otherwise need to grow. Keys are indexed by an open-addressed
+// table with linear probing; an empty slot is marked by the largest value
+// of Key, and an entry actually using that key is tracked separately.
+//
+// Unlike the node engine, this one moves entries around. Inserting may
+// compact the entries or reallocate the vector, so it invalidates every
+// iterator, and every reference into the hash, such as the ones returned by
+// operator[](), first() and last(). Erasing never moves entries, so erase()
+// keeps other iterators valid. The largest value of Key is not reserved:
+// the entry using it is found through `sentinel` rather than the table.
+// Code that relies on the node engine's guarantees can keep it with
+// NodeEngine<> (see below).
+//
+// In incremental mode, a full table is replaced by one twice the size, and
+// the old table is kept around read-only while the entries are indexed
+// into the new one a few at a time. Entries below `migrated` and at or past
+// `migrationEnd` are in the new table; the others are only in the old one.
+// The new table itself is cleared ahead of time, a few slots per insertion
+// once the current table is half way to growing. Reallocating and
+// compacting the entries are not spread out, nor is linking a node
+// anywhere but at the end, which finishes the resize first.
+
+template <typename Key, typename T, typename Hasher>
+struct QTCOLLECTIONS_SHARED_EXPORT OrderedHashData<Key, T, Hasher, true>
+{
+    typedef OrderedHashEntry<Key, T> Entry;
+    typedef OrderedHashSlot<Key> Slot;
+    typedef OrderedHashKeyTraits<Key, Hasher> Traits;
+    typedef int Cursor;
+
+    QVector<Entry> entries;
+    QBitArray holes;
+    int holeCount;
+    int head;           // Index of the first live entry.
+    QVector<Slot> table;
+    int shift;          // 64 - log2(table.size()).
+    int sentinel;       // Index of the entry whose key is emptyKey(), or -1.
+    QVector<Slot> oldTable;     // Only while resizing.
+    QVector<Slot> nextTable;    // Being cleared for the next resize.
+    int oldShift;
+    int migrated;
+    int migrationEnd;
+    bool incremental;
+    Hasher hasher;
+
+    explicit OrderedHashData(const Hasher &hasher = Hasher()) :
+        holeCount(0), head(0), shift(64), sentinel(-1),
+        oldShift(64), migrated(0), migrationEnd(0), incremental(false),
+        hasher(hasher) {}
+
+    inline const Hasher &hashPolicy() const { return hasher; }
+
+    static inline Key emptyKey() { return std::numeric_limits<Key>::max(); }
+
+    inline int size() const { return entries.size() - holeCount; }
+    inline int capacity() const { return entries.capacity(); }
+
+    void reserve(int size)
+    {
+        entries.reserve(size);
+        if (holes.size() < size)
+            holes.resize(size);
+        if (tableSizeFor(size) > table.size())
+            rehash(tableSizeFor(size));
+    }
+
+    void squeeze()
+    {
+        if (holeCount)
+            compact();
+        entries.squeeze();
+        if (entries.isEmpty())
+            clear();
+        else if (tableSizeFor(entries.size()) < table.size())
+            rehash(tableSizeFor(entries.size()));
+    }
+
+    void clear()
+    {
+        entries.clear();
+        holes.clear();
+        holeCount = 0;
+        head = 0;
+        table.clear();
+        shift = 64;
+        sentinel = -1;
+        oldTable.clear();
+        nextTable.clear();
+    }
+
+    void setIncrementalResize(bool enable)
+    {
+        incremental = enable;
+        if (!enable)
+        {
+            migrate(entries.size());
+            nextTable.clear();
+        }
+    }
+
+    inline Cursor begin() const { return head; }
+    inline Cursor end() const { return entries.size(); }
+
+    inline Cursor next(Cursor i) const
+    {
+        do {
+            ++i;
+        } while (i < entries.size() && holes.testBit(i));
+        return i;
+    }
+
+    inline Cursor previous(Cursor i) const
+    {
+        do {
+            --i;
+        } while (i > head && holes.testBit(i));
+        return i;
+    }
+
+    inline const Key &key(Cursor i) const { return entries.at(i).key; }
+    inline T &value(Cursor i) { return entries[i].value; }
+    inline const T &value(Cursor i) const { return entries.at(i).value; }
+
+    Cursor find(const Key &key) const
+    {
+        if (key == emptyKey())
+            return sentinel < 0 ? end() : sentinel;
+        int i = probe(table, shift, key);
+        if (i < 0 && !oldTable.isEmpty())
+        {
+            i = probe(oldTable, oldShift, key);
+            if (!inOldTable(i) || holes.testBit(i))
+                i = -1;
+        }
+        return i < 0 ? end() : i;
+    }
+
+    // Resolves keys a batch at a time: first the table slot of every key is
+    // prefetched, then each key is probed and its entry prefetched, and
+    // only then are the values read.
+    template <typename Iterator, typename Sink>
+    void findMany(Iterator first, Iterator last, Sink &sink) const
+    {
+        Iterator keys[BatchSize];
+        Cursor found[BatchSize];
+        while (first != last)
+        {
+            int n = 0;
+            for (; n < BatchSize && first != last; ++first, ++n)
+            {
+                keys[n] = first;
+                if (!table.isEmpty())
+                    orderedHashPrefetch(table.constData() + slotFor(*first));
+            }
+            for (int j = 0; j < n; j++)
+            {
+                found[j] = find(*keys[j]);
+                if (found[j] != end())
+                    orderedHashPrefetch(entries.constData() + found[j]);
+            }
+            for (int j = 0; j < n; j++)
+                sink(found[j] != end() ? &entries.at(found[j]).value : 0);
+        }
+    }
+
+    Cursor insert(const Key &key, const T &value)
+    {
+        Cursor i = find(key);
+        if (i != end())
+        {
+            entries[i].value = value;
+            return i;
+        }
+
+        makeRoom();
+        i = entries.size();
+        entries.append(Entry(key, value));
+        growHoles();
+        place(key, i);
+        migrate(ResizeStep);
+        return i;
+    }
+
+    // An entry linked at the end costs what insert() does. One linked right
+    // after a hole takes its place; one linked anywhere else goes through
+    // open(), which is O(table size) and may reallocate the entry vector.
+    // Both of those first finish any resize in progress.
+    Cursor link(Cursor before, Key &key, T &value)
+    {
+        if (before == end())
+        {
+            makeRoom();
+            const int i = entries.size();
+            entries.append(Entry());
+            growHoles();
+            entries[i].key = key;
+            qSwap(entries[i].value, value);
+            place(key, i);
+            migrate(ResizeStep);
+            return i;
+        }
+        migrate(entries.size());
+        if ((size() + 1) * 4 > table.size() * 3)
+            rehash(table.isEmpty() ? 8 : table.size() * 2);
+        int i = before;
+        if (i > 0 && holes.testBit(i - 1))
+            fillHole(--i);
+        else
+            open(i);
+        entries[i].key = key;
+        qSwap(entries[i].value, value);
+        place(key, i);
+        return i;
+    }
+
+    void unlink(Cursor i, Key &key, T &value)
+    {
+        key = entries.at(i).key;
+        qSwap(value, entries[i].value);
+        erase(i);
+    }
+
+    Cursor erase(Cursor i)
+    {
+        Cursor n = next(i);
+        punch(i);
+        trim();
+        migrate(ResizeStep);
+        return n < entries.size() ? n : entries.size();
+    }
+
+    int erase(Cursor first, Cursor last)
+    {
+        int removed = 0;
+        for (Cursor i = first; i != last; i = next(i))
+        {
+            punch(i);
+            removed++;
+        }
+        trim();
+        if (holeCount && holeCount >= entries.size() / 2)
+            compact();
+        return removed;
+    }
+
+    // Removes matching entries and squeezes out holes in a single pass over
+    // the entries, then reindexes the survivors.
+    template <typename Predicate>
+    int removeIf(Predicate pred)
+    {
+        Entry *e = entries.data();
+        const int n = entries.size();
+        const int count = size();
+        int w = 0;
+        for (int r = head; r < n; )
+        {
+            if (holes.testBit(r) || pred(e[r].key, e[r].value))
+            {
+                r++;
+                continue;
+            }
+            int run = r + 1;
+            while (run < n && !holes.testBit(run)
+                   && !pred(e[run].key, e[run].value))
+                run++;
+            if (w != r)
+                moveEntries(e + w, e + r, run - r);
+            w += run - r;
+            r = run + 1;    // entries[run], if any, is being removed.
+        }
+        entries.resize(w);
+        holes.fill(false, w);
+        holeCount = 0;
+        head = 0;
+        rehash(table.size());
+        return count - w;
+    }
+
+private:
+    // Entries indexed per operation while a resize is in progress, and slots
+    // of the next table cleared per insertion before one. Tables fill up no
+    // faster than one entry per insertion, so both finish long before they
+    // are needed.
+    enum { ResizeStep = 16 };
+
+    // Keys resolved together by findMany().
+    enum { BatchSize = 16 };
+
+    // Prepares the entries and the table for one more entry at the end,
+    // compacting the entries if they are full and half holes.
+    void makeRoom()
+    {
+        if (holeCount && holeCount >= entries.size() / 2
+                && entries.size() == entries.capacity())
+            compact();
+        if (incremental && size() * 8 >= table.size() * 3)
+            prepare(ResizeStep);
+        if ((size() + 1) * 4 > table.size() * 3)
+            grow();
+    }
+
+    static int tableSizeFor(int size)
+    {
+        int n = 8;
+        while (size * 4 > n * 3)
+            n *= 2;
+        return n;
+    }
+
+    // Slots are picked by the top bits of the policy's hash, which for the
+    // default policy is a Fibonacci hash of the key.
+    inline int slotFor(Key key, int shift) const
+    {
+        return int(Traits::spread(hasher, key) >> shift);
+    }
+
+    inline int slotFor(Key key) const { return slotFor(key, shift); }
+
+    int probe(const QVector<Slot> &table, int shift, Key key) const
+    {
+        if (table.isEmpty())
+            return -1;
+        const Slot *buckets = table.constData();
+        const int mask = table.size() - 1;
+        for (int s = slotFor(key, shift); buckets[s].key != emptyKey();
+             s = (s + 1) & mask)
+        {
+            if (buckets[s].key == key)
+                return buckets[s].index;
+        }
+        return -1;
+    }
+
+    // Whether entry i is indexed by the old table rather than the new one.
+    inline bool inOldTable(int i) const
+    {
+        return !oldTable.isEmpty() && i >= migrated && i < migrationEnd;
+    }
+
+    void grow()
+    {
+        int size = table.isEmpty() ? 8 : table.size() * 2;
+        if (!incremental || table.isEmpty())
+        {
+            rehash(size);
+            return;
+        }
+        migrate(entries.size());
+        prepare(size);
+        oldTable.swap(table);
+        oldShift = shift;
+        table.swap(nextTable);
+        setShift(size);
+        migrated = head;
+        migrationEnd = entries.size();
+    }
+
+    // Clears up to n more slots of the table the next resize will use.
+    void prepare(int n)
+    {
+        const int size = table.size() * 2;
+        if (nextTable.size() > size)
+            nextTable.clear();
+        if (nextTable.capacity() < size)
+            nextTable.reserve(size);
+        Slot empty = { emptyKey(), -1 };
+        for (n = qMin(n, size - nextTable.size()); n > 0; n--)
+            nextTable.append(empty);
+    }
+
+    // Indexes up to n more entries of a resize into the new table.
+    void migrate(int n)
+    {
+        if (oldTable.isEmpty())
+            return;
+        const int stop = qMin(migrationEnd, migrated + n);
+        for (; migrated < stop; migrated++)
+        {
+            if (!holes.testBit(migrated))
+                place(entries.at(migrated).key, migrated);
+        }
+        if (migrated >= migrationEnd)
+            oldTable.clear();
+    }
+
+    void place(Key key, int index)
+    {
+        if (key == emptyKey())
+        {
+            sentinel = index;
+            return;
+        }
+        Slot *buckets = table.data();
+        const int mask = table.size() - 1;
+        int s = slotFor(key);
+        while (buckets[s].key != emptyKey())
+            s = (s + 1) & mask;
+        buckets[s].key = key;
+        buckets[s].index = index;
+    }
+
+    // Backward-shift deletion, so the table never needs tombstones. The old
+    // table of a resize is left alone; the hole left by the entry is enough
+    // to hide it there.
+    void unplace(Key key, int index)
+    {
+        if (key == emptyKey())
+        {
+            sentinel = -1;
+            return;
+        }
+        if (inOldTable(index))
+            return;
+        Slot *buckets = table.data();
+        const int mask = table.size() - 1;
+        int hole = slotFor(key);
+        while (buckets[hole].key != key)
+            hole = (hole + 1) & mask;
+        for (int s = (hole + 1) & mask; buckets[s].key != emptyKey();
+             s = (s + 1) & mask)
+        {
+            int home = slotFor(buckets[s].key);
+            if (((s - home) & mask) >= ((s - hole) & mask))
+            {
+                buckets[hole] = buckets[s];
+                hole = s;
+            }
+        }
+        buckets[hole].key = emptyKey();
+    }
+
+    void setShift(int size)
+    {
+        shift = 64;
+        while (size > 1)
+        {
+            size >>= 1;
+            shift--;
+        }
+    }
+
+    void rehash(int size)
+    {
+        Slot empty = { emptyKey(), -1 };
+        oldTable.clear();
+        table.fill(empty, size);
+        setShift(size);
+        sentinel = -1;
+        for (int i = head; i < entries.size(); i = next(i))
+            place(entries.at(i).key, i);
     }
 
-    QPair<Key, T> takeFirst()
+    struct KeepAll
     {
-        const Key &key = keys.takeFirst();
-        const T &value = hash.value(key);
-        hash.remove(key);
-        lookup.remove(key);
-        return QPair<Key, T>(key, value);
+        inline bool operator()(const Key &, const T &) const { return false; }
+    };
+
+    inline void compact() { removeIf(KeepAll()); }
+
+    static void moveEntries(Entry *to, Entry *from, int n)
+    {
+        if (QTypeInfo<Entry>::isComplex)
+        {
+            for (int j = 0; j < n; j++)
+                to[j] = from[j];
+        }
+        else
+        {
+            ::memmove(static_cast<void *>(to), from, n * sizeof(Entry));
+        }
     }
 
-    QPair<Key, T> takeLast()
+    // Keeps a bit for each entry, and grows with the entries' capacity
+    // rather than with each insertion, so that reserve() covers it too.
+    // Bits past the last entry are always clear.
+    inline void growHoles()
     {
-        const Key &key = keys.takeLast();
-        const T &value = hash.value(key);
-        hash.remove(key);
-        lookup.remove(key);
-        return QPair<Key, T>(key, value);
+        if (holes.size() < entries.size())
+            holes.resize(entries.capacity());
     }
+
+    inline void fillHole(int i)
+    {
+        holes.clearBit(i);
+        holeCount--;
+        if (i < head)
+            head = i;
+    }
+
+    // Makes room for an entry at i, moving the entries after it up by one.
+    // Unless i is the end, every slot of the table is visited to renumber
+    // them.
+    void open(int i)
+    {
+        entries.insert(i, Entry());
+        const int n = entries.size();
+        growHoles();
+        for (int j = n - 1; j > i; j--)
+            holes.setBit(j, holes.testBit(j - 1));
+        holes.clearBit(i);
+        if (i == n - 1)
+            return;
+        Slot *buckets = table.data();
+        for (int s = 0; s < table.size(); s++)
+        {
+            if (buckets[s].key != emptyKey() && buckets[s].index >= i)
+                buckets[s].index++;
+        }
+        if (sentinel >= i)
+            sentinel++;
+    }
+
+    // Turns a live entry into a hole.
+    void punch(int i)
+    {
+        unplace(entries.at(i).key, i);
+        holes.setBit(i);
+        holeCount++;
+        if (QTypeInfo<Entry>::isComplex)
+            entries[i] = Entry();
+    }
+
+    // Drops trailing holes, so the last entry is always live and end()
+    // directly follows it, and moves head past leading holes.
+    void trim()
+    {
+        int n = entries.size();
+        while (n > 0 && holes.testBit(n - 1))
+        {
+            entries.removeLast();
+            holeCount--;
+            n--;
+        }
+        holes.resize(n);
+        if (migrationEnd > n)
+            migrationEnd = n;   // Appended entries go to the new table.
+        while (head < n && holes.testBit(head))
+            head++;
+        if (head > n)
+            head = n;
+    }
+};
+
+// Keeps an OrderedHash in the node engine whatever its key type, hashing
+// keys with the given policy:
+//
+//   OrderedHash<int, QString, NodeEngine<> > hash;
+//
+// Iterators stay valid until their entry is erased, and so do references
+// to values, unless incremental resizing is on.
+template <typename Hasher = DefaultHashPolicy>
+struct NodeEngine : public Hasher
+{
+    inline NodeEngine() {}
+    inline NodeEngine(const Hasher &hasher) : Hasher(hasher) {}
 };
 
+template <typename Key, typename Hasher>
+struct OrderedHashKeyTraits<Key, NodeEngine<Hasher> > :
+        public OrderedHashKeyTraits<Key, Hasher>
+{};
+
+template <typename Key, typename T, typename Hasher>
+struct QTCOLLECTIONS_SHARED_EXPORT
+OrderedHashData<Key, T, NodeEngine<Hasher>, true> :
+        public OrderedHashData<Key, T, NodeEngine<Hasher>, false>
+{
+    explicit OrderedHashData(
+            const NodeEngine<Hasher> &hasher = NodeEngine<Hasher>()) :
+        OrderedHashData<Key, T, NodeEngine<Hasher>, false>(hasher) {}
+};
+
+// An entry taken out of an OrderedHash by extract(), owned by the handle
+// until it is inserted into a hash again. With the flat and group-probing
+// engines, extracting and inserting swap the key and value in and out of
+// the hash, so neither is copied; the node engine copies the key into its
+// hashes. Copying the handle itself copies both, so pass it by reference.
 template <typename Key, typename T>
+class QTCOLLECTIONS_SHARED_EXPORT OrderedHashNode
+{
+    template <typename, typename, typename> friend class OrderedHash;
+
+    Key k;
+    T v;
+    bool live;
+
+public:
+    typedef Key key_type;
+    typedef T mapped_type;
+
+    inline OrderedHashNode() : k(), v(), live(false) {}
+
+    inline bool isEmpty() const { return !live; }
+    inline bool empty() const { return !live; }
+
+    inline const Key &key() const { return k; }
+    inline T &value() { return v; }
+    inline const T &value() const { return v; }
+    inline T &mapped() { return v; }
+    inline const T &mapped() const { return v; }
+
+    void swap(OrderedHashNode &other)
+    {
+        qSwap(k, other.k);
+        qSwap(v, other.v);
+        qSwap(live, other.live);
+    }
+};
+
+// The Hasher policy decides how keys are hashed (see hashpolicy.h). A hash
+// keeps its policy, seed included, through clear(); copies and assignments
+// take the policy of the hash they copy.
+template <typename Key, typename T, typename Hasher = DefaultHashPolicy>
 class QTCOLLECTIONS_SHARED_EXPORT OrderedHash
 {
-    typedef OrderedHashData<Key, T> Data;
-    typedef typename QLinkedList<Key>::iterator KeyIterator;
+    typedef OrderedHashData<Key, T, Hasher> Data;
+    typedef typename Data::Cursor Cursor;
     QScopedPointer<Data> d;
 
 public:
     inline OrderedHash() : d(new Data()) {}
+    explicit inline OrderedHash(const Hasher &hasher) :
+        d(new Data(hasher)) {}
     inline OrderedHash(const OrderedHash &other) : d(new Data(*other.d)) {}
 #ifdef Q_COMPILER_INITIALIZER_LISTS
     inline OrderedHash(std::initializer_list<std::pair<Key,T> > list);
@@ -87,31 +1069,54 @@ public:
     }
     // TODO: Move semantics if Q_COMPILER_RVALUE_REFS.
 
-    inline int capacity() const { return d->hash.capacity(); }
+    inline int capacity() const { return d->capacity(); }
     void reserve(int size) { return d->reserve(size); }
-    inline void squeeze() { d->reserve(1); }
+    inline void squeeze() { d->squeeze(); }
+
+    // In incremental-resize mode, the hash grows its index a few entries at
+    // a time over the insertions and removals that follow, instead of all
+    // at once in the insertion that fills it, at the price of slightly
+    // slower lookups while a resize is in progress. Only rehashing is
+    // spread out this way. With the flat engine, an insertion may still
+    // reallocate the entry vector (reserve() avoids that) or compact it
+    // when it is full and half holes, both in one go; the group-probing
+    // engine ignores the mode. The mode is off by default.
+    inline bool isIncrementalResize() const { return d->incremental; }
+    inline void setIncrementalResize(bool enable)
+        { d->setIncrementalResize(enable); }
+
+    inline Hasher hashPolicy() const { return d->hashPolicy(); }
 
     void swap(OrderedHash &other) { qSwap(d, other.d); }
 
     bool operator==(const OrderedHash &other) const;
     bool operator!=(const OrderedHash &other) const;
 
-    inline int size() const { return d->hash.size(); }
-    inline bool isEmpty() const { return d->hash.isEmpty(); }
+    inline int size() const { return d->size(); }
+    inline bool isEmpty() const { return d->size() == 0; }
 
     void clear();
     int remove(const Key &key);
     T take(const Key &key);
 
-    bool contains(const Key &key) const { return d->hash.contains(key); }
+    bool contains(const Key &key) const { return d->find(key) != d->end(); }
     const Key key(const T &value) const { return key(value, Key()); }
     const Key key(const T &value, const Key &defaultKey) const;
-    const T value(const Key &key) const { return d->hash.value(key); }
-    const T value(const Key &key, const T &defaultValue) const
-        { return d->hash.value(key, defaultValue); }
-    T &operator[](const Key &key)
-        { return !d->hash.contains(key) ? *insert(key, T()) : d->hash[key]; }
-    const T operator[](const Key &key) const { return d->hash[key]; }
+    const T value(const Key &key) const { return value(key, T()); }
+    const T value(const Key &key, const T &defaultValue) const;
+    T &operator[](const Key &key);
+    const T operator[](const Key &key) const { return value(key); }
+
+    // Batch lookup. These write one item to out for each key in keys, in
+    // order: its value (or defaultValue) for valuesFor(), and whether it is
+    // present for containsMany(). Keys are hashed, and the memory they will
+    // probe prefetched, a batch at a time before any is resolved, so the
+    // cache misses of different keys overlap. Both return the advanced out.
+    template <typename Range, typename OutputIterator>
+    OutputIterator valuesFor(const Range &keys, OutputIterator out,
+                             const T &defaultValue = T()) const;
+    template <typename Range, typename OutputIterator>
+    OutputIterator containsMany(const Range &keys, OutputIterator out) const;
 
     QList<Key> keys() const;
     QList<Key> keys(const T &value) const;
@@ -123,20 +1128,24 @@ public:
     {
         friend class const_iterator;
         friend class OrderedHash;
-        typedef OrderedHashData<Key, T> HashData;
 
-        KeyIterator i;
-        HashData *d;
+        Cursor i;
+        Data *d;
 
     public:
-        inline iterator() : d(0) {}
-        inline iterator(KeyIterator i, const QScopedPointer<HashData> &d) :
-            i(i), d(d.data()) {}
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef T value_type;
+        typedef T *pointer;
+        typedef T &reference;
+
+        inline iterator() : i(), d(0) {}
+        inline iterator(Cursor i, Data *d) : i(i), d(d) {}
 
-        inline const Key &key() const { return *i; }
-        inline T &value() const { return d->hash[*i]; }
+        inline const Key &key() const { return d->key(i); }
+        inline T &value() const { return d->value(i); }
         inline T &operator*() const { return value(); }
-        inline T &operator->() const { return value(); }
+        inline T *operator->() const { return &value(); }
 
         inline bool operator==(const iterator &o) const
             { return i == o.i && d == o.d; }
@@ -144,21 +1153,21 @@ public:
             { return !(*this == o); }
 
         inline iterator &operator++() {
-            ++i;
+            i = d->next(i);
             return *this;
         }
         inline iterator operator++(int) {
             iterator r = *this;
-            i++;
+            i = d->next(i);
             return r;
         }
         inline iterator &operator--() {
-            --i;
+            i = d->previous(i);
             return *this;
         }
         inline iterator operator--(int) {
             iterator r = *this;
-            i--;
+            i = d->previous(i);
             return r;
         }
         inline iterator operator+(int j) const {
@@ -167,12 +1176,7 @@ public:
             else if (j < 0) while (j < 0) { --r; j++; }
             return r;
         }
-        inline iterator operator-(int j) const {
-            iterator r = *this;
-            if (j > 0) while (j > 0) { --r ; j--; }
-            else if (j < 0) while (j < 0) { ++r; j++; }
-            return r;
-        }
+        inline iterator operator-(int j) const { return operator+(-j); }
         inline iterator &operator+=(int j) { return *this = *this + j; }
         inline iterator &operator-=(int j) { return *this = *this - j; }
 
@@ -189,27 +1193,30 @@ public:
     class const_iterator
     {
         friend class iterator;
-        typedef typename QLinkedList<Key>::const_iterator KeyIterator;
-        typedef OrderedHashData<Key, T> HashData;
+        friend class OrderedHash;
 
-        KeyIterator i;
-        HashData *d;
+        Cursor i;
+        const Data *d;
 
     public:
-        inline const_iterator() : d(0) {}
-        inline const_iterator(
-                KeyIterator i, const QScopedPointer<HashData> &d) :
-            i(i), d(d.data()) {}
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef T value_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        inline const_iterator() : i(), d(0) {}
+        inline const_iterator(Cursor i, const Data *d) : i(i), d(d) {}
 
 #ifdef QT_STRICT_ITERATORS
         explicit
 #endif
         inline const_iterator(const iterator &o) : i(o.i), d(o.d) {}
 
-        inline const Key &key() const { return *i; }
-        inline T &value() const { return d->hash[*i]; }
-        inline T &operator*() const { return value(); }
-        inline T &operator->() const { return value(); }
+        inline const Key &key() const { return d->key(i); }
+        inline const T &value() const { return d->value(i); }
+        inline const T &operator*() const { return value(); }
+        inline const T *operator->() const { return &value(); }
 
         inline bool operator==(const const_iterator &o) const
             { return i == o.i && d == o.d; }
@@ -217,33 +1224,30 @@ public:
             { return !(*this == o); }
 
         inline const_iterator &operator++() {
-            ++i;
+            i = d->next(i);
             return *this;
         }
         inline const_iterator operator++(int) {
             const_iterator r = *this;
-            i++;
+            i = d->next(i);
             return r;
         }
         inline const_iterator &operator--() {
-            --i;
+            i = d->previous(i);
             return *this;
         }
         inline const_iterator operator--(int) {
             const_iterator r = *this;
-            i--;
+            i = d->previous(i);
             return r;
         }
         inline const_iterator operator+(int j) const {
             const_iterator r = *this;
-            i = i + j;
-            return r;
-        }
-        inline const_iterator operator-(int j) const {
-            const_iterator r = *this;
-            i = i - j;
+            if (j > 0) while (j > 0) { ++r ; j--; }
+            else if (j < 0) while (j < 0) { --r; j++; }
             return r;
         }
+        inline const_iterator operator-(int j) const { return operator+(-j); }
         inline const_iterator &operator+=(int j) { return *this = *this + j; }
         inline const_iterator &operator-=(int j) { return *this = *this - j; }
     };
@@ -251,21 +1255,167 @@ public:
 
     // STL-style iteration.
     inline iterator begin()
-        { return iterator(d->keys.begin(), d); }
+        { return iterator(d->begin(), d.data()); }
     inline const_iterator begin() const
-        { return const_iterator(d->keys.begin(), d); }
+        { return const_iterator(d->begin(), d.data()); }
     inline const_iterator cbegin() const
-        { return const_iterator(d->keys.cbegin(), d); }
+        { return const_iterator(d->begin(), d.data()); }
     inline const_iterator constBegin() const
-        { return const_iterator(d->keys.constBegin(), d); }
+        { return const_iterator(d->begin(), d.data()); }
     inline iterator end()
-        { return iterator(d->keys.end(), d); }
+        { return iterator(d->end(), d.data()); }
     inline const_iterator end() const
-        { return const_iterator(d->keys.end(), d); }
+        { return const_iterator(d->end(), d.data()); }
     inline const_iterator cend() const
-        { return const_iterator(d->keys.cend(), d); }
+        { return const_iterator(d->end(), d.data()); }
     inline const_iterator constEnd() const
-        { return const_iterator(d->keys.constEnd(), d); }
+        { return const_iterator(d->end(), d.data()); }
+
+    class key_iterator
+    {
+        const_iterator i;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef Key value_type;
+        typedef const Key *pointer;
+        typedef const Key &reference;
+
+        inline key_iterator() {}
+        explicit inline key_iterator(const const_iterator &o) : i(o) {}
+
+        inline const Key &operator*() const { return i.key(); }
+        inline const Key *operator->() const { return &i.key(); }
+        inline bool operator==(const key_iterator &o) const
+            { return i == o.i; }
+        inline bool operator!=(const key_iterator &o) const
+            { return i != o.i; }
+
+        inline key_iterator &operator++() { ++i; return *this; }
+        inline key_iterator operator++(int) { return key_iterator(i++); }
+        inline key_iterator &operator--() { --i; return *this; }
+        inline key_iterator operator--(int) { return key_iterator(i--); }
+        inline const_iterator base() const { return i; }
+    };
+
+    // Dereferences to a (key, value) pair of references, so it works with
+    // structured bindings.
+    template <typename Iterator, typename Value>
+    class KeyValueIterator
+    {
+        Iterator i;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef std::pair<const Key &, Value &> value_type;
+        typedef value_type reference;
+        typedef void pointer;
+
+        inline KeyValueIterator() {}
+        explicit inline KeyValueIterator(const Iterator &o) : i(o) {}
+
+        inline reference operator*() const
+            { return reference(i.key(), i.value()); }
+        inline bool operator==(const KeyValueIterator &o) const
+            { return i == o.i; }
+        inline bool operator!=(const KeyValueIterator &o) const
+            { return i != o.i; }
+
+        inline KeyValueIterator &operator++() { ++i; return *this; }
+        inline KeyValueIterator operator++(int)
+            { return KeyValueIterator(i++); }
+        inline KeyValueIterator &operator--() { --i; return *this; }
+        inline KeyValueIterator operator--(int)
+            { return KeyValueIterator(i--); }
+        inline Iterator base() const { return i; }
+    };
+    typedef KeyValueIterator<iterator, T> key_value_iterator;
+    typedef KeyValueIterator<const_iterator, const T> const_key_value_iterator;
+
+    inline key_iterator keyBegin() const
+        { return key_iterator(constBegin()); }
+    inline key_iterator keyEnd() const
+        { return key_iterator(constEnd()); }
+    inline key_value_iterator keyValueBegin()
+        { return key_value_iterator(begin()); }
+    inline key_value_iterator keyValueEnd()
+        { return key_value_iterator(end()); }
+    inline const_key_value_iterator keyValueBegin() const
+        { return const_key_value_iterator(constBegin()); }
+    inline const_key_value_iterator keyValueEnd() const
+        { return const_key_value_iterator(constEnd()); }
+    inline const_key_value_iterator constKeyValueBegin() const
+        { return const_key_value_iterator(constBegin()); }
+    inline const_key_value_iterator constKeyValueEnd() const
+        { return const_key_value_iterator(constEnd()); }
+
+    // Read-only views over the hash, similar to Python's dictionary views.
+    // A view borrows the hash it is created from and allocates nothing;
+    // it reflects later changes to the hash, and must not outlive it.
+    template <typename Iterator>
+    class View
+    {
+    protected:
+        const OrderedHash *h;
+
+    public:
+        typedef std::reverse_iterator<Iterator> const_reverse_iterator;
+
+        explicit inline View(const OrderedHash *h) : h(h) {}
+
+        inline int size() const { return h->size(); }
+        inline bool isEmpty() const { return h->isEmpty(); }
+
+        inline Iterator begin() const { return Iterator(h->constBegin()); }
+        inline Iterator end() const { return Iterator(h->constEnd()); }
+        inline const_reverse_iterator rbegin() const
+            { return const_reverse_iterator(end()); }
+        inline const_reverse_iterator rend() const
+            { return const_reverse_iterator(begin()); }
+    };
+
+    class KeysView : public View<key_iterator>
+    {
+    public:
+        explicit inline KeysView(const OrderedHash *h) :
+            View<key_iterator>(h) {}
+        inline bool contains(const Key &key) const
+            { return this->h->contains(key); }
+    };
+
+    class ValuesView : public View<const_iterator>
+    {
+    public:
+        explicit inline ValuesView(const OrderedHash *h) :
+            View<const_iterator>(h) {}
+        bool contains(const T &value) const
+        {
+            for (const_iterator it = this->begin(); it != this->end(); ++it)
+            {
+                if (*it == value)
+                    return true;
+            }
+            return false;
+        }
+    };
+
+    class ItemsView : public View<const_key_value_iterator>
+    {
+    public:
+        explicit inline ItemsView(const OrderedHash *h) :
+            View<const_key_value_iterator>(h) {}
+        bool contains(const Key &key, const T &value) const
+        {
+            const_iterator it = this->h->constFind(key);
+            return it != this->h->constEnd() && it.value() == value;
+        }
+    };
+
+    inline KeysView keysView() const { return KeysView(this); }
+    inline ValuesView valuesView() const { return ValuesView(this); }
+    inline ItemsView itemsView() const { return ItemsView(this); }
 
     // STL compatibility.
     typedef T mapped_type;
@@ -277,39 +1427,110 @@ public:
     // Qt Core compatibility.
     typedef iterator Iterator;
     typedef const_iterator ConstIterator;
-    inline int count() const { return d->hash.count(); }
+    inline int count() const { return d->size(); }
     iterator find(const Key &key)
-        { return iterator(d->lookup.value(key, d->keys.end()), d); }
+        { return iterator(d->find(key), d.data()); }
     const_iterator find(const Key &key) const
-        { return const_iterator(d->lookup.value(key, d->keys.end()), d); }
+        { return const_iterator(d->find(key), d.data()); }
     const_iterator constFind(const Key &key) const
-        { return const_iterator(d->lookup.value(key, d->keys.end()), d); }
+        { return const_iterator(d->find(key), d.data()); }
     iterator erase(iterator it);
 
+    // Batch removal. Each of these returns the number of entries removed,
+    // and may invalidate iterators.
+    template <typename Predicate>
+    int removeIf(Predicate pred) { return d->removeIf(pred); }
+    int erase(iterator first, iterator last);
+    int retainKeys(const QSet<Key> &keys);
+    template <typename Range>
+    int removeKeys(const Range &keys);
+
     // Map interface.
-    iterator insert(const Key &key, const T &value);
-    QHash<Key, T> toHash() const { return d->hash; }
-    const Key &firstKey() const { return d->keys.first(); }
-    const Key &lastKey() const { return d->keys.last(); }
-    QPair<Key, T> takeFirst() { return d->takeFirst(); }
-    QPair<Key, T> takeLast() { return d->takeLast(); }
+    iterator insert(const Key &key, const T &value)
+        { return iterator(d->insert(key, value), d.data()); }
+
+    // Node interface, after std::unordered_map's. extract() takes an entry
+    // out of the hash into a node, and insert() puts it back, here or in
+    // another hash, before the given position or at the end. If the key is
+    // already present, insert() leaves the node alone and returns the
+    // existing entry. splice() and merge() move entries from other to the
+    // end of this hash, keeping their order and skipping keys this hash
+    // already has; they return the number moved.
+    //
+    // With the flat and group-probing engines the key and value are not
+    // copied, and appending a node, or inserting it right after the hole of
+    // an extracted entry, allocates nothing beyond growing the vectors.
+    // Inserting a node before any other entry is O(table size), though: it
+    // finishes any resize in progress, the entries after it move up by one,
+    // which may reallocate the entry vector, and the whole index is
+    // renumbered. The node engine saves nothing over take() and insert():
+    // it copies the key, and frees and allocates QHash and QLinkedList
+    // nodes, wherever the node goes.
+    typedef OrderedHashNode<Key, T> Node;
+    typedef Node node_type;
+    Node extract(const Key &key);
+    Node extract(iterator it);
+    iterator insert(Node &node) { return insert(node, end()); }
+    iterator insert(Node &node, iterator before);
+    int splice(OrderedHash &other, iterator first, iterator last);
+    int merge(OrderedHash &other)
+        { return splice(other, other.begin(), other.end()); }
+    QHash<Key, T> toHash() const;
+    const Key &firstKey() const { return d->key(d->begin()); }
+    const Key &lastKey() const { return d->key(d->previous(d->end())); }
+    QPair<Key, T> takeFirst();
+    QPair<Key, T> takeLast();
 
     // Sequence interface.
-    T &first() { return d->hash[d->keys.first()]; }
-    const T &first() const { return d->hash[d->keys.first()]; }
-    T &last() { return d->hash[d->keys.last()]; }
-    const T &last() const { return d->hash[d->keys.last()]; }
-    void removeFirst() { d->takeFirst(); }
-    void removeLast() { d->takeLast(); }
+    T &first() { return d->value(d->begin()); }
+    const T &first() const { return constData()->value(d->begin()); }
+    T &last() { return d->value(d->previous(d->end())); }
+    const T &last() const
+        { return constData()->value(d->previous(d->end())); }
+    void removeFirst() { takeFirst(); }
+    void removeLast() { takeLast(); }
 
     // Sequence interface, STL-style.
-    void pop_front() { d->takeFirst(); }
-    void pop_back() { d->takeLast(); }
+    void pop_front() { takeFirst(); }
+    void pop_back() { takeLast(); }
+
+private:
+    inline const Data *constData() const { return d.data(); }
+
+    struct In
+    {
+        const QSet<Key> &keys;
+        inline bool operator()(const Key &key, const T &) const
+            { return keys.contains(key); }
+    };
+
+    struct NotIn
+    {
+        const QSet<Key> &keys;
+        inline bool operator()(const Key &key, const T &) const
+            { return !keys.contains(key); }
+    };
+
+    template <typename OutputIterator>
+    struct ValueSink
+    {
+        OutputIterator out;
+        const T &defaultValue;
+        inline void operator()(const T *value)
+            { *out++ = value ? *value : defaultValue; }
+    };
+
+    template <typename OutputIterator>
+    struct ContainsSink
+    {
+        OutputIterator out;
+        inline void operator()(const T *value) { *out++ = value != 0; }
+    };
 };
 
 #ifdef Q_COMPILER_INITIALIZER_LISTS
-template <typename Key, typename T>
-OrderedHash<Key, T>::OrderedHash(
+template <typename Key, typename T, typename Hasher>
+OrderedHash<Key, T, Hasher>::OrderedHash(
         std::initializer_list< std::pair<Key, T> > list) :
     d(new Data())
 {
@@ -320,114 +1541,320 @@ OrderedHash<Key, T>::OrderedHash(
 }
 #endif
 
-template <typename Key, typename T>
-bool OrderedHash<Key, T>::operator==(const OrderedHash &other) const
+template <typename Key, typename T, typename Hasher>
+bool OrderedHash<Key, T, Hasher>::operator==(const OrderedHash &other) const
 {
     if (d == other.d)
         return true;
-    return d->hash == other.d->hash && d->keys == other.d->keys;
+    if (size() != other.size())
+        return false;
+    const_iterator it = constBegin();
+    const_iterator oit = other.constBegin();
+    for (; it != constEnd(); ++it, ++oit)
+    {
+        if (!(it.key() == oit.key()) || !(it.value() == oit.value()))
+            return false;
+    }
+    return true;
 }
 
-template <typename Key, typename T>
-bool OrderedHash<Key, T>::operator!=(const OrderedHash &other) const
+template <typename Key, typename T, typename Hasher>
+bool OrderedHash<Key, T, Hasher>::operator!=(const OrderedHash &other) const
 {
     return !(*this == other);
 }
 
-template <typename Key, typename T>
-void OrderedHash<Key, T>::clear()
+template <typename Key, typename T, typename Hasher>
+void OrderedHash<Key, T, Hasher>::clear()
 {
     d->clear();
 }
 
-template <typename Key, typename T>
-int OrderedHash<Key, T>::remove(const Key &key)
+template <typename Key, typename T, typename Hasher>
+int OrderedHash<Key, T, Hasher>::remove(const Key &key)
 {
-    int r = d->hash.remove(key);
-    if (r)
-        d->keys.erase(d->lookup.take(key));
-    return r;
+    Cursor i = d->find(key);
+    if (i == d->end())
+        return 0;
+    d->erase(i);
+    return 1;
 }
 
-template <typename Key, typename T>
-T OrderedHash<Key, T>::take(const Key &key)
+template <typename Key, typename T, typename Hasher>
+T OrderedHash<Key, T, Hasher>::take(const Key &key)
 {
-    if (d->hash.contains(key))
-        d->keys.erase(d->lookup.take(key));
-    return d->hash.take(key);
+    Cursor i = d->find(key);
+    if (i == d->end())
+        return T();
+    T value = d->value(i);
+    d->erase(i);
+    return value;
 }
 
-template <typename Key, typename T>
-const Key OrderedHash<Key, T>::key(const T &value, const Key &defaultKey) const
+template <typename Key, typename T, typename Hasher>
+const Key OrderedHash<Key, T, Hasher>::key(const T &value,
+                                           const Key &defaultKey) const
 {
-    foreach (const Key &key, d->keys)
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
     {
-        if (d->hash.value(key) == value)
-            return key;
+        if (it.value() == value)
+            return it.key();
     }
     return defaultKey;
 }
 
-template <typename Key, typename T>
-QList<Key> OrderedHash<Key, T>::keys() const
+template <typename Key, typename T, typename Hasher>
+const T OrderedHash<Key, T, Hasher>::value(const Key &key,
+                                           const T &defaultValue) const
+{
+    Cursor i = d->find(key);
+    if (i == d->end())
+        return defaultValue;
+    return constData()->value(i);
+}
+
+template <typename Key, typename T, typename Hasher>
+T &OrderedHash<Key, T, Hasher>::operator[](const Key &key)
+{
+    Cursor i = d->find(key);
+    if (i == d->end())
+        i = d->insert(key, T());
+    return d->value(i);
+}
+
+template <typename Key, typename T, typename Hasher>
+template <typename Range, typename OutputIterator>
+OutputIterator OrderedHash<Key, T, Hasher>::valuesFor(
+        const Range &keys, OutputIterator out, const T &defaultValue) const
+{
+    ValueSink<OutputIterator> sink = { out, defaultValue };
+    constData()->findMany(keys.begin(), keys.end(), sink);
+    return sink.out;
+}
+
+template <typename Key, typename T, typename Hasher>
+template <typename Range, typename OutputIterator>
+OutputIterator OrderedHash<Key, T, Hasher>::containsMany(
+        const Range &keys, OutputIterator out) const
+{
+    ContainsSink<OutputIterator> sink = { out };
+    constData()->findMany(keys.begin(), keys.end(), sink);
+    return sink.out;
+}
+
+template <typename Key, typename T, typename Hasher>
+QList<Key> OrderedHash<Key, T, Hasher>::keys() const
 {
     QList<Key> keys;
-    keys.reserve(d->keys.size());
-    foreach (const Key &key, d->keys)
-        keys.append(key);
+    keys.reserve(size());
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        keys.append(it.key());
     return keys;
 }
 
-template <typename Key, typename T>
-QList<Key> OrderedHash<Key, T>::keys(const T &value) const
+template <typename Key, typename T, typename Hasher>
+QList<Key> OrderedHash<Key, T, Hasher>::keys(const T &value) const
 {
     QList<Key> keys;
-    keys.reserve(d->keys.size());
-    foreach (const Key &key, d->keys)
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
     {
-        if (d->hash.value(key) == value)
-            keys.append(key);
+        if (it.value() == value)
+            keys.append(it.key());
     }
     return keys;
 }
 
-template <typename Key, typename T>
-QList<T> OrderedHash<Key, T>::values() const
+template <typename Key, typename T, typename Hasher>
+QList<T> OrderedHash<Key, T, Hasher>::values() const
 {
     QList<T> values;
-    values.reserve(d->keys.size());
-    foreach (const Key &key, d->keys)
-        values.append(d->hash.value(key));
+    values.reserve(size());
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        values.append(it.value());
     return values;
 }
 
-template <typename Key, typename T>
-typename OrderedHash<Key, T>::iterator OrderedHash<Key, T>::erase(
-        typename OrderedHash<Key, T>::iterator it)
+template <typename Key, typename T, typename Hasher>
+typename OrderedHash<Key, T, Hasher>::iterator
+OrderedHash<Key, T, Hasher>::erase(
+        typename OrderedHash<Key, T, Hasher>::iterator it)
 {
     Q_ASSERT_X(it.d == d.data(), "qtcollections::OrderedHash::erase",
                "The specified iterator argument 'it' is invalid");
     if (it == end())
         return it;
-    iterator next = it + 1;
-    d->erase(it.i);
-    return next;
+    return iterator(d->erase(it.i), d.data());
 }
 
-template <typename Key, typename T>
-typename OrderedHash<Key, T>::iterator OrderedHash<Key, T>::insert(
-        const Key &key, const T &value)
+template <typename Key, typename T, typename Hasher>
+int OrderedHash<Key, T, Hasher>::erase(
+        typename OrderedHash<Key, T, Hasher>::iterator first,
+        typename OrderedHash<Key, T, Hasher>::iterator last)
+{
+    Q_ASSERT_X(first.d == d.data() && last.d == d.data(),
+               "qtcollections::OrderedHash::erase",
+               "The specified iterator range is invalid");
+    return d->erase(first.i, last.i);
+}
+
+template <typename Key, typename T, typename Hasher>
+int OrderedHash<Key, T, Hasher>::retainKeys(const QSet<Key> &keys)
+{
+    NotIn pred = { keys };
+    return d->removeIf(pred);
+}
+
+// Looks up each key while they are few, so the cost is proportional to the
+// number of keys given rather than to the size of the hash. Once they are at
+// least half as many as the entries, one sweep testing every entry against a
+// set of them costs no more, and lets the flat engines squeeze out the holes
+// in the same pass instead of leaving them to later compactions.
+template <typename Key, typename T, typename Hasher>
+template <typename Range>
+int OrderedHash<Key, T, Hasher>::removeKeys(const Range &keys)
+{
+    const int n = int(std::distance(keys.begin(), keys.end()));
+    if (n && n >= d->size() / 2)
+    {
+        QSet<Key> set;
+        set.reserve(n);
+        for (typename Range::const_iterator it = keys.begin();
+             it != keys.end(); ++it)
+            set.insert(*it);
+        In pred = { set };
+        return d->removeIf(pred);
+    }
+
+    int removed = 0;
+    for (typename Range::const_iterator it = keys.begin();
+         it != keys.end(); ++it)
+    {
+        Cursor i = d->find(*it);
+        if (i != d->end())
+        {
+            d->erase(i);
+            removed++;
+        }
+    }
+    return removed;
+}
+
+template <typename Key, typename T, typename Hasher>
+typename OrderedHash<Key, T, Hasher>::Node
+OrderedHash<Key, T, Hasher>::extract(const Key &key)
+{
+    Cursor i = d->find(key);
+    if (i == d->end())
+        return Node();
+    return extract(iterator(i, d.data()));
+}
+
+template <typename Key, typename T, typename Hasher>
+typename OrderedHash<Key, T, Hasher>::Node
+OrderedHash<Key, T, Hasher>::extract(iterator it)
 {
-    bool existed = d->hash.contains(key);
-    d->hash.insert(key, value);
-    if (existed)
-        return iterator(d->lookup.value(key), d);
+    Q_ASSERT_X(it.d == d.data(), "qtcollections::OrderedHash::extract",
+               "The specified iterator argument 'it' is invalid");
+    Node node;
+    d->unlink(it.i, node.k, node.v);
+    node.live = true;
+    return node;
+}
 
-    KeyIterator kit = d->keys.insert(d->keys.end(), key);
-    d->lookup.insert(key, kit);
-    return iterator(kit, d);
+template <typename Key, typename T, typename Hasher>
+typename OrderedHash<Key, T, Hasher>::iterator
+OrderedHash<Key, T, Hasher>::insert(Node &node, iterator before)
+{
+    Q_ASSERT_X(before.d == d.data(), "qtcollections::OrderedHash::insert",
+               "The specified iterator argument 'before' is invalid");
+    if (node.isEmpty())
+        return end();
+    Cursor i = d->find(node.k);
+    if (i == d->end())
+    {
+        i = d->link(before.i, node.k, node.v);
+        node.live = false;
+    }
+    return iterator(i, d.data());
 }
 
+template <typename Key, typename T, typename Hasher>
+int OrderedHash<Key, T, Hasher>::splice(OrderedHash &other,
+                                        iterator first, iterator last)
+{
+    Q_ASSERT_X(&other != this, "qtcollections::OrderedHash::splice",
+               "Cannot splice a hash into itself");
+    Q_ASSERT_X(first.d == other.d.data() && last.d == other.d.data(),
+               "qtcollections::OrderedHash::splice",
+               "The specified iterator arguments are invalid");
+    int moved = 0;
+    Key key;
+    T value;
+    for (Cursor i = first.i; i != last.i; )
+    {
+        // Unlinking leaves the entries after i where they are.
+        const Cursor n = other.d->next(i);
+        if (d->find(other.d->key(i)) == d->end())
+        {
+            other.d->unlink(i, key, value);
+            d->link(d->end(), key, value);
+            moved++;
+        }
+        i = n;
+    }
+    return moved;
+}
+
+template <typename Key, typename T, typename Hasher>
+QHash<Key, T> OrderedHash<Key, T, Hasher>::toHash() const
+{
+    QHash<Key, T> hash;
+    hash.reserve(size());
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        hash.insert(it.key(), it.value());
+    return hash;
+}
+
+template <typename Key, typename T, typename Hasher>
+QPair<Key, T> OrderedHash<Key, T, Hasher>::takeFirst()
+{
+    Q_ASSERT(!isEmpty());
+    Cursor i = d->begin();
+    QPair<Key, T> r(d->key(i), d->value(i));
+    d->erase(i);
+    return r;
+}
+
+template <typename Key, typename T, typename Hasher>
+QPair<Key, T> OrderedHash<Key, T, Hasher>::takeLast()
+{
+    Q_ASSERT(!isEmpty());
+    Cursor i = d->previous(d->end());
+    QPair<Key, T> r(d->key(i), d->value(i));
+    d->erase(i);
+    return r;
+}
+
+// The library instantiates OrderedHash for the most common key and value
+// types once, in qtcollections.cpp, and code using them links to those
+// instead of instantiating them again. This is only done when
+// QTCOLLECTIONS_EXTERN_TEMPLATES is defined, as the projects linking the
+// library do, so the headers keep working on their own without it.
+#if defined(Q_COMPILER_EXTERN_TEMPLATES) \
+        && defined(QTCOLLECTIONS_EXTERN_TEMPLATES)
+extern template struct OrderedHashData<QString, QVariant>;
+extern template class OrderedHash<QString, QVariant>;
+extern template struct OrderedHashData<QString, QString>;
+extern template class OrderedHash<QString, QString>;
+extern template struct OrderedHashData<QString, int>;
+extern template class OrderedHash<QString, int>;
+extern template struct OrderedHashData<QByteArray, QByteArray>;
+extern template class OrderedHash<QByteArray, QByteArray>;
+extern template struct OrderedHashData<int, QString>;
+extern template class OrderedHash<int, QString>;
+extern template struct OrderedHashData<int, QVariant>;
+extern template class OrderedHash<int, QVariant>;
+#endif
 
 }   // namespace qtcollections
 
@@ -0,0 +1,547 @@
+#ifndef QTCOLLECTIONS_ORDEREDHASHMODEL_H
+#define QTCOLLECTIONS_ORDEREDHASHMODEL_H
+
+#include <algorithm>
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QHash>
+#include <QSet>
+#include <QVariant>
+#include <QVector>
+#include "qtcollections_global.h"
+#include "orderedhash.h"
+
+namespace qtcollections
+{
+
+// Order-statistics index over the rows of an OrderedHashModel. Rows get
+// sequence numbers in row order; a Fenwick tree counts the live ones, so
+// both the row of a sequence number and the sequence number of a row are
+// found in O(log n). Removed numbers are not reused until the model
+// renumbers its rows.
+class QTCOLLECTIONS_SHARED_EXPORT OrderedHashRowIndex
+{
+    QVector<int> tree;  // 1-based; tree[i] counts live numbers in
+                        // (i - lowbit(i), i].
+    int count;
+
+public:
+    inline OrderedHashRowIndex() : tree(1, 0), count(0) {}
+
+    inline int size() const { return count; }
+    inline int sequenceCount() const { return tree.size() - 1; }
+
+    void clear()
+    {
+        tree.fill(0, 1);
+        count = 0;
+    }
+
+    int append()
+    {
+        const int i = tree.size();
+        tree.append(1 + prefix(i - 1) - prefix(i - (i & -i)));
+        count++;
+        return i - 1;
+    }
+
+    void remove(int seq)
+    {
+        for (int i = seq + 1; i < tree.size(); i += i & -i)
+            tree[i]--;
+        count--;
+    }
+
+    inline int row(int seq) const { return prefix(seq + 1) - 1; }
+
+    int sequenceAt(int row) const
+    {
+        int step = 1;
+        while (step * 2 < tree.size())
+            step *= 2;
+        int pos = 0;
+        int k = row + 1;
+        for (; step > 0; step /= 2)
+        {
+            if (pos + step < tree.size() && tree.at(pos + step) < k)
+            {
+                pos += step;
+                k -= tree.at(pos);
+            }
+        }
+        return pos;
+    }
+
+private:
+    int prefix(int i) const
+    {
+        int sum = 0;
+        for (; i > 0; i -= i & -i)
+            sum += tree.at(i);
+        return sum;
+    }
+};
+
+// A table model showing an OrderedHash, one row per entry in hash order,
+// with the key in the first column and the value in the second. For QML,
+// the key and value are also available as the "key" and "value" roles.
+//
+// The model owns its hash; change it through the model's own insert(),
+// remove() and friends. Views are not told about each change as it
+// happens. Changes are collected and reported once per event loop pass
+// (or on flush()) as precise row removals, moves to the end, insertions
+// and dataChanged ranges, with consecutive rows merged into one
+// notification. Until then, views keep seeing the rows as they were at the
+// last notification. Rows of removed keys keep their last value, and rows
+// of other keys show the current one.
+template <typename Key, typename T>
+class QTCOLLECTIONS_SHARED_EXPORT OrderedHashModel : public QAbstractTableModel
+{
+public:
+    enum Columns
+    {
+        KeyColumn,
+        ValueColumn,
+        ColumnCount
+    };
+
+    enum Roles
+    {
+        KeyRole = Qt::UserRole + 1,
+        ValueRole
+    };
+
+    explicit OrderedHashModel(QObject *parent = 0) :
+        QAbstractTableModel(parent), cleared(false), scheduled(false) {}
+    explicit OrderedHashModel(const OrderedHash<Key, T> &hash,
+                              QObject *parent = 0) :
+        QAbstractTableModel(parent), cleared(false), scheduled(false)
+    {
+        setHash(hash);
+    }
+
+    inline const OrderedHash<Key, T> &hash() const { return h; }
+    void setHash(const OrderedHash<Key, T> &hash);
+
+    // Changes, reported to views on the next flush.
+    void insert(const Key &key, const T &value);
+    int remove(const Key &key);
+    T take(const Key &key);
+    void moveToEnd(const Key &key);
+    void clear();
+
+    // Reports pending changes to views right away.
+    void flush();
+
+    // Lookups in the rows views currently see.
+    int row(const Key &key) const;
+    Key keyAt(int row) const;
+    inline QModelIndex indexOf(const Key &key, int column = KeyColumn) const
+    {
+        int r = row(key);
+        return r < 0 ? QModelIndex() : index(r, column);
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const
+        Q_DECL_OVERRIDE
+    {
+        return parent.isValid() ? 0 : rows.size();
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const
+        Q_DECL_OVERRIDE
+    {
+        return parent.isValid() ? 0 : int(ColumnCount);
+    }
+
+    QVariant data(const QModelIndex &index,
+                  int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    bool setData(const QModelIndex &index, const QVariant &value,
+                 int role = Qt::EditRole) Q_DECL_OVERRIDE;
+    Qt::ItemFlags flags(const QModelIndex &index) const Q_DECL_OVERRIDE;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE;
+
+protected:
+    bool event(QEvent *e) Q_DECL_OVERRIDE
+    {
+        if (e->type() != flushEvent())
+            return QAbstractTableModel::event(e);
+        flush();
+        return true;
+    }
+
+private:
+    OrderedHash<Key, T> h;
+
+    // The rows views see: a row index plus the key of each sequence number.
+    OrderedHashRowIndex rows;
+    QVector<Key> keysBySequence;
+    QHash<Key, int> sequences;
+
+    // Pending changes. Keys in `moved` were inserted, removed or moved to
+    // the end; keys in `changed` had their value replaced.
+    QSet<Key> moved;
+    QSet<Key> changed;
+    QHash<Key, T> removedValues;    // Of removed keys still shown in rows.
+    bool cleared;
+    bool scheduled;
+
+    static QEvent::Type flushEvent()
+    {
+        static int type = QEvent::registerEventType();
+        return QEvent::Type(type);
+    }
+
+    void schedule()
+    {
+        if (scheduled)
+            return;
+        scheduled = true;
+        QCoreApplication::postEvent(this, new QEvent(flushEvent()));
+    }
+
+    void keepRemoved(const Key &key, const T &value)
+    {
+        if (sequences.contains(key))
+            removedValues.insert(key, value);
+    }
+
+    void appendRow(const Key &key)
+    {
+        sequences.insert(key, rows.append());
+        keysBySequence.append(key);
+    }
+
+    void removeRow(int row)
+    {
+        int seq = rows.sequenceAt(row);
+        rows.remove(seq);
+        sequences.remove(keysBySequence.at(seq));
+    }
+
+    void renumber();
+    static QVector<QPair<int, int> > runs(QVector<int> rowList);
+};
+
+template <typename Key, typename T>
+void OrderedHashModel<Key, T>::setHash(const OrderedHash<Key, T> &hash)
+{
+    beginResetModel();
+    h = hash;
+    rows.clear();
+    keysBySequence.clear();
+    sequences.clear();
+    moved.clear();
+    changed.clear();
+    removedValues.clear();
+    cleared = false;
+    keysBySequence.reserve(h.size());
+    sequences.reserve(h.size());
+    for (typename OrderedHash<Key, T>::const_iterator it = h.constBegin();
+         it != h.constEnd(); ++it)
+        appendRow(it.key());
+    endResetModel();
+}
+
+template <typename Key, typename T>
+void OrderedHashModel<Key, T>::insert(const Key &key, const T &value)
+{
+    if (h.contains(key))
+    {
+        changed.insert(key);
+    }
+    else
+    {
+        moved.insert(key);
+        if (sequences.contains(key))
+            changed.insert(key);
+    }
+    h.insert(key, value);
+    schedule();
+}
+
+template <typename Key, typename T>
+int OrderedHashModel<Key, T>::remove(const Key &key)
+{
+    if (!h.contains(key))
+        return 0;
+    take(key);
+    return 1;
+}
+
+template <typename Key, typename T>
+T OrderedHashModel<Key, T>::take(const Key &key)
+{
+    if (!h.contains(key))
+        return T();
+    moved.insert(key);
+    schedule();
+    T value = h.take(key);
+    keepRemoved(key, value);
+    return value;
+}
+
+template <typename Key, typename T>
+void OrderedHashModel<Key, T>::moveToEnd(const Key &key)
+{
+    if (!h.contains(key) || h.lastKey() == key)
+        return;
+    h.insert(key, h.take(key));
+    moved.insert(key);
+    schedule();
+}
+
+template <typename Key, typename T>
+void OrderedHashModel<Key, T>::clear()
+{
+    if (h.isEmpty())
+        return;
+    for (typename OrderedHash<Key, T>::const_iterator it = h.constBegin();
+         it != h.constEnd(); ++it)
+        keepRemoved(it.key(), it.value());
+    h.clear();
+    moved.clear();
+    changed.clear();
+    cleared = true;
+    schedule();
+}
+
+template <typename Key, typename T>
+void OrderedHashModel<Key, T>::flush()
+{
+    scheduled = false;
+
+    // Rows of removed keys go first, last run first, so the rows of the
+    // other runs stay put.
+    if (cleared)
+    {
+        cleared = false;
+        if (rows.size())
+        {
+            beginRemoveRows(QModelIndex(), 0, rows.size() - 1);
+            rows.clear();
+            keysBySequence.clear();
+            sequences.clear();
+            endRemoveRows();
+        }
+    }
+
+    QVector<int> removedRows;
+    int tailSize = 0;
+    for (typename QSet<Key>::const_iterator it = moved.constBegin();
+         it != moved.constEnd(); ++it)
+    {
+        if (h.contains(*it))
+            tailSize++;
+        else if (sequences.contains(*it))
+            removedRows.append(rows.row(sequences.value(*it)));
+    }
+    QVector<QPair<int, int> > removedRuns = runs(removedRows);
+    for (int i = removedRuns.size() - 1; i >= 0; i--)
+    {
+        int first = removedRuns.at(i).first;
+        int last = removedRuns.at(i).second;
+        beginRemoveRows(QModelIndex(), first, last);
+        for (int r = last; r >= first; r--)
+            removeRow(r);
+        endRemoveRows();
+    }
+    removedValues.clear();
+
+    // Every other key in `moved` is now at the end of the hash, after all
+    // the keys that stayed in place. Walk that tail in order, moving known
+    // keys to the end and appending new ones, a run at a time.
+    QVector<Key> tail(tailSize);
+    typename OrderedHash<Key, T>::const_iterator it = h.constEnd();
+    for (int i = tailSize - 1; i >= 0; i--)
+        tail[i] = (--it).key();
+
+    for (int i = 0; i < tailSize; )
+    {
+        int j = i + 1;
+        if (sequences.contains(tail.at(i)))
+        {
+            int first = rows.row(sequences.value(tail.at(i)));
+            while (j < tailSize && sequences.contains(tail.at(j))
+                   && rows.row(sequences.value(tail.at(j)))
+                        == first + j - i)
+                j++;
+            int last = first + j - i - 1;
+            bool notify = last != rows.size() - 1;
+            if (notify)
+                beginMoveRows(QModelIndex(), first, last,
+                              QModelIndex(), rows.size());
+            for (int k = i; k < j; k++)
+            {
+                removeRow(first);
+                appendRow(tail.at(k));
+            }
+            if (notify)
+                endMoveRows();
+        }
+        else
+        {
+            while (j < tailSize && !sequences.contains(tail.at(j)))
+                j++;
+            beginInsertRows(QModelIndex(), rows.size(),
+                            rows.size() + j - i - 1);
+            for (int k = i; k < j; k++)
+            {
+                appendRow(tail.at(k));
+                changed.remove(tail.at(k));
+            }
+            endInsertRows();
+        }
+        i = j;
+    }
+    moved.clear();
+
+    QVector<int> changedRows;
+    for (typename QSet<Key>::const_iterator it = changed.constBegin();
+         it != changed.constEnd(); ++it)
+    {
+        if (sequences.contains(*it))
+            changedRows.append(rows.row(sequences.value(*it)));
+    }
+    changed.clear();
+    QVector<QPair<int, int> > changedRuns = runs(changedRows);
+    for (int i = 0; i < changedRuns.size(); i++)
+    {
+        emit dataChanged(index(changedRuns.at(i).first, KeyColumn),
+                         index(changedRuns.at(i).second, ValueColumn));
+    }
+
+    if (rows.sequenceCount() > 2 * rows.size() + 64)
+        renumber();
+}
+
+// Gives live rows consecutive sequence numbers again, once most numbers
+// belong to removed rows. Rows themselves do not change.
+template <typename Key, typename T>
+void OrderedHashModel<Key, T>::renumber()
+{
+    QVector<Key> keys;
+    keys.reserve(rows.size());
+    for (int r = 0; r < rows.size(); r++)
+        keys.append(keysBySequence.at(rows.sequenceAt(r)));
+    rows.clear();
+    keysBySequence.clear();
+    for (int i = 0; i < keys.size(); i++)
+        appendRow(keys.at(i));
+}
+
+// Sorts rows and merges them into (first, last) runs of consecutive rows.
+template <typename Key, typename T>
+QVector<QPair<int, int> > OrderedHashModel<Key, T>::runs(
+        QVector<int> rowList)
+{
+    std::sort(rowList.begin(), rowList.end());
+    QVector<QPair<int, int> > result;
+    for (int i = 0; i < rowList.size(); i++)
+    {
+        if (!result.isEmpty() && result.last().second + 1 == rowList.at(i))
+            result.last().second = rowList.at(i);
+        else
+            result.append(qMakePair(rowList.at(i), rowList.at(i)));
+    }
+    return result;
+}
+
+template <typename Key, typename T>
+int OrderedHashModel<Key, T>::row(const Key &key) const
+{
+    typename QHash<Key, int>::const_iterator it = sequences.constFind(key);
+    return it == sequences.constEnd() ? -1 : rows.row(it.value());
+}
+
+template <typename Key, typename T>
+Key OrderedHashModel<Key, T>::keyAt(int row) const
+{
+    if (row < 0 || row >= rows.size())
+        return Key();
+    return keysBySequence.at(rows.sequenceAt(row));
+}
+
+template <typename Key, typename T>
+QVariant OrderedHashModel<Key, T>::data(const QModelIndex &index,
+                                        int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size())
+        return QVariant();
+
+    bool isKey;
+    if (role == KeyRole)
+        isKey = true;
+    else if (role == ValueRole)
+        isKey = false;
+    else if (role == Qt::DisplayRole || role == Qt::EditRole)
+        isKey = index.column() == KeyColumn;
+    else
+        return QVariant();
+
+    Key key = keyAt(index.row());
+    if (isKey)
+        return QVariant::fromValue(key);
+    typename OrderedHash<Key, T>::const_iterator it = h.constFind(key);
+    if (it != h.constEnd())
+        return QVariant::fromValue(it.value());
+    return QVariant::fromValue(removedValues.value(key));
+}
+
+template <typename Key, typename T>
+bool OrderedHashModel<Key, T>::setData(const QModelIndex &index,
+                                       const QVariant &value, int role)
+{
+    if (!index.isValid() || index.row() >= rows.size())
+        return false;
+    if (!(role == ValueRole
+          || (role == Qt::EditRole && index.column() == ValueColumn)))
+        return false;
+
+    Key key = keyAt(index.row());
+    if (!h.contains(key))
+        return false;
+    h.insert(key, qvariant_cast<T>(value));
+    emit dataChanged(index.sibling(index.row(), KeyColumn),
+                     index.sibling(index.row(), ValueColumn));
+    return true;
+}
+
+template <typename Key, typename T>
+Qt::ItemFlags OrderedHashModel<Key, T>::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags f = QAbstractTableModel::flags(index);
+    if (index.isValid() && index.column() == ValueColumn)
+        f |= Qt::ItemIsEditable;
+    return f;
+}
+
+template <typename Key, typename T>
+QVariant OrderedHashModel<Key, T>::headerData(
+        int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+    if (section == KeyColumn)
+        return QCoreApplication::translate("OrderedHashModel", "Key");
+    if (section == ValueColumn)
+        return QCoreApplication::translate("OrderedHashModel", "Value");
+    return QVariant();
+}
+
+template <typename Key, typename T>
+QHash<int, QByteArray> OrderedHashModel<Key, T>::roleNames() const
+{
+    QHash<int, QByteArray> names = QAbstractTableModel::roleNames();
+    names.insert(KeyRole, "key");
+    names.insert(ValueRole, "value");
+    return names;
+}
+
+}   // namespace qtcollections
+
+#endif // QTCOLLECTIONS_ORDEREDHASHMODEL_H
@@ -0,0 +1,752 @@
+#ifndef QTCOLLECTIONS_ORDEREDJSON_H
+#define QTCOLLECTIONS_ORDEREDJSON_H
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QIODevice>
+#include <QJsonParseError>
+#include <QLocale>
+#include <QMetaType>
+#include <QString>
+#include <QVariant>
+#include <QtNumeric>
+#include "qtcollections_global.h"
+#include "orderedhash.h"
+
+namespace qtcollections
+{
+
+// A JSON object with its keys in document order.
+typedef OrderedHash<QString, QVariant> OrderedVariantHash;
+
+}   // namespace qtcollections
+
+Q_DECLARE_METATYPE(qtcollections::OrderedVariantHash)
+
+namespace qtcollections
+{
+
+// Streaming JSON parser that keeps the key order of objects.
+//
+// The document is read from the device in fixed-size chunks and parsed
+// straight into its final form: objects become OrderedVariantHash, arrays
+// QVariantList, strings QString, integers qlonglong (or double if they do
+// not fit), other numbers double, booleans bool, and null an invalid
+// QVariant. Nested values are built in place inside their parents, so
+// apart from the current chunk no intermediate copy is ever made.
+//
+// Errors are reported through QJsonParseError, with the offset counted in
+// bytes from where the reader started. Strings must be well-formed UTF-8;
+// an invalid sequence fails with IllegalUTF8String rather than being
+// replaced.
+class QTCOLLECTIONS_SHARED_EXPORT OrderedJsonReader
+{
+    QIODevice *device;
+    QByteArray buffer;
+    QByteArray scratch;
+    int pos;
+    qint64 consumed;        // Bytes read from the device before buffer.
+    int depth;
+    QJsonParseError::ParseError status;
+
+    enum { ChunkSize = 64 * 1024, MaxDepth = 1024 };
+
+public:
+    explicit OrderedJsonReader(QIODevice *device) :
+        device(device), pos(0), consumed(0), depth(0),
+        status(QJsonParseError::NoError) {}
+
+    // Reads a document whose top-level value may be of any type.
+    QVariant read(QJsonParseError *error = 0)
+    {
+        QVariant value;
+        if (!parseValue(&value) || !atEnd())
+            value = QVariant();
+        report(error);
+        return value;
+    }
+
+    // Reads a document that must be an object, into *object.
+    bool read(OrderedVariantHash *object, QJsonParseError *error = 0)
+    {
+        object->clear();
+        if (skipSpace() != '{')
+            fail(QJsonParseError::MissingObject);
+        else if (!parseObject(object) || !atEnd())
+            object->clear();
+        report(error);
+        return status == QJsonParseError::NoError;
+    }
+
+    static QVariant parse(const QByteArray &json, QJsonParseError *error = 0)
+    {
+        QBuffer device;
+        device.setData(json);
+        device.open(QIODevice::ReadOnly);
+        return OrderedJsonReader(&device).read(error);
+    }
+
+private:
+    bool fill()
+    {
+        consumed += buffer.size();
+        pos = 0;
+        buffer.resize(ChunkSize);
+        qint64 n = device->read(buffer.data(), ChunkSize);
+        buffer.resize(n > 0 ? int(n) : 0);
+        return !buffer.isEmpty();
+    }
+
+    inline int peek()
+    {
+        if (pos >= buffer.size() && !fill())
+            return -1;
+        return uchar(buffer.at(pos));
+    }
+
+    inline int get()
+    {
+        int c = peek();
+        if (c >= 0)
+            pos++;
+        return c;
+    }
+
+    int skipSpace()
+    {
+        int c = peek();
+        while (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        {
+            pos++;
+            c = peek();
+        }
+        return c;
+    }
+
+    bool fail(QJsonParseError::ParseError error)
+    {
+        if (status == QJsonParseError::NoError)
+            status = error;
+        return false;
+    }
+
+    bool atEnd()
+    {
+        if (status != QJsonParseError::NoError)
+            return false;
+        return skipSpace() < 0 || fail(QJsonParseError::GarbageAtEnd);
+    }
+
+    void report(QJsonParseError *error)
+    {
+        if (!error)
+            return;
+        error->error = status;
+        error->offset = status == QJsonParseError::NoError ?
+                    0 : int(consumed + pos);
+    }
+
+    bool parseValue(QVariant *value)
+    {
+        int c = skipSpace();
+        switch (c)
+        {
+        case '{':
+            *value = QVariant::fromValue(OrderedVariantHash());
+            return parseObject(static_cast<OrderedVariantHash *>(
+                                   value->data()));
+        case '[':
+            *value = QVariantList();
+            return parseArray(static_cast<QVariantList *>(value->data()));
+        case '"':
+        {
+            QString string;
+            if (!parseString(&string))
+                return false;
+            *value = string;
+            return true;
+        }
+        case 't':
+            *value = true;
+            return parseLiteral("true");
+        case 'f':
+            *value = false;
+            return parseLiteral("false");
+        case 'n':
+            *value = QVariant();
+            return parseLiteral("null");
+        case -1:
+            return fail(QJsonParseError::IllegalValue);
+        default:
+            if (c == '-' || (c >= '0' && c <= '9'))
+                return parseNumber(value);
+            return fail(QJsonParseError::IllegalValue);
+        }
+    }
+
+    bool parseObject(OrderedVariantHash *object)
+    {
+        pos++;  // '{'
+        if (++depth > MaxDepth)
+            return fail(QJsonParseError::DeepNesting);
+        int c = skipSpace();
+        if (c == '}')
+        {
+            pos++;
+            depth--;
+            return true;
+        }
+        for (;;)
+        {
+            if (c != '"')
+            {
+                return fail(c < 0 ? QJsonParseError::UnterminatedObject :
+                                    QJsonParseError::IllegalValue);
+            }
+            QString key;
+            if (!parseString(&key))
+                return false;
+            if (skipSpace() != ':')
+                return fail(QJsonParseError::MissingNameSeparator);
+            pos++;
+            if (!parseValue(&*object->insert(key, QVariant())))
+                return false;
+
+            c = skipSpace();
+            pos++;
+            if (c == '}')
+                break;
+            if (c != ',')
+            {
+                pos--;
+                return fail(c < 0 ? QJsonParseError::UnterminatedObject :
+                                    QJsonParseError::MissingValueSeparator);
+            }
+            c = skipSpace();
+        }
+        depth--;
+        return true;
+    }
+
+    bool parseArray(QVariantList *array)
+    {
+        pos++;  // '['
+        if (++depth > MaxDepth)
+            return fail(QJsonParseError::DeepNesting);
+        int c = skipSpace();
+        if (c == ']')
+        {
+            pos++;
+            depth--;
+            return true;
+        }
+        for (;;)
+        {
+            array->append(QVariant());
+            if (!parseValue(&array->last()))
+                return false;
+
+            c = skipSpace();
+            pos++;
+            if (c == ']')
+                break;
+            if (c != ',')
+            {
+                pos--;
+                return fail(c < 0 ? QJsonParseError::UnterminatedArray :
+                                    QJsonParseError::MissingValueSeparator);
+            }
+        }
+        depth--;
+        return true;
+    }
+
+    bool parseString(QString *string)
+    {
+        pos++;  // '"'
+        scratch.resize(0);
+        // UTF-8 is checked as the string is scanned, so that an invalid
+        // sequence is reported where it is, even across buffer refills.
+        int need = 0;       // Continuation bytes still expected.
+        uchar low = 0x80;   // Range of the next continuation byte.
+        uchar high = 0xBF;
+        for (;;)
+        {
+            if (pos >= buffer.size() && !fill())
+                return fail(QJsonParseError::UnterminatedString);
+            const char *begin = buffer.constData() + pos;
+            const char *end = buffer.constData() + buffer.size();
+            const char *p = begin;
+            for (; p < end; p++)
+            {
+                const uchar c = uchar(*p);
+                if (need)
+                {
+                    if (c < low || c > high)
+                        break;
+                    need--;
+                    low = 0x80;
+                    high = 0xBF;
+                }
+                else if (c >= 0x80)
+                {
+                    if (!startSequence(c, &need, &low, &high))
+                        break;
+                }
+                else if (c == '"' || c == '\\' || c < 0x20)
+                {
+                    break;
+                }
+            }
+            pos += int(p - begin);
+            if (p == end)
+            {
+                scratch.append(begin, int(p - begin));
+                continue;
+            }
+            // A bad lead or continuation byte, or a sequence cut short.
+            if (need || uchar(*p) >= 0x80)
+                return fail(QJsonParseError::IllegalUTF8String);
+            // Control characters must be escaped.
+            if (uchar(*p) < 0x20)
+                return fail(QJsonParseError::IllegalValue);
+            pos++;
+            if (*p == '"')
+            {
+                // Strings without escapes that fit in the buffer are
+                // decoded straight from it.
+                if (scratch.isEmpty())
+                {
+                    *string = QString::fromUtf8(begin, int(p - begin));
+                }
+                else
+                {
+                    scratch.append(begin, int(p - begin));
+                    *string = QString::fromUtf8(scratch);
+                }
+                return true;
+            }
+            scratch.append(begin, int(p - begin));
+            if (!parseEscape())
+                return false;
+        }
+    }
+
+    // Sets up the continuation bytes expected after lead byte c, following
+    // the well-formed sequences of the Unicode standard (table 3-7), which
+    // leave out overlong forms, surrogates and code points past U+10FFFF.
+    static bool startSequence(uchar c, int *need, uchar *low, uchar *high)
+    {
+        *low = 0x80;
+        *high = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF)
+            *need = 1;
+        else if (c >= 0xE0 && c <= 0xEF)
+            *need = 2;
+        else if (c >= 0xF0 && c <= 0xF4)
+            *need = 3;
+        else
+            return false;
+        if (c == 0xE0)
+            *low = 0xA0;
+        else if (c == 0xED)
+            *high = 0x9F;
+        else if (c == 0xF0)
+            *low = 0x90;
+        else if (c == 0xF4)
+            *high = 0x8F;
+        return true;
+    }
+
+    bool parseEscape()
+    {
+        int c = get();
+        switch (c)
+        {
+        case '"': case '\\': case '/':
+            scratch.append(char(c));
+            return true;
+        case 'b': scratch.append('\b'); return true;
+        case 'f': scratch.append('\f'); return true;
+        case 'n': scratch.append('\n'); return true;
+        case 'r': scratch.append('\r'); return true;
+        case 't': scratch.append('\t'); return true;
+        case 'u':
+            break;
+        default:
+            return fail(QJsonParseError::IllegalEscapeSequence);
+        }
+
+        uint code;
+        if (!parseHex(&code))
+            return false;
+        if (code >= 0xD800 && code < 0xDC00)
+        {
+            // A high surrogate must be followed by an escaped low one.
+            uint low;
+            if (get() != '\\' || get() != 'u' || !parseHex(&low)
+                    || low < 0xDC00 || low >= 0xE000)
+                return fail(QJsonParseError::IllegalEscapeSequence);
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        else if (code >= 0xDC00 && code < 0xE000)
+        {
+            return fail(QJsonParseError::IllegalEscapeSequence);
+        }
+
+        // Encode as UTF-8, like the rest of the string.
+        if (code < 0x80)
+        {
+            scratch.append(char(code));
+        }
+        else if (code < 0x800)
+        {
+            scratch.append(char(0xC0 | (code >> 6)));
+            scratch.append(char(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000)
+        {
+            scratch.append(char(0xE0 | (code >> 12)));
+            scratch.append(char(0x80 | ((code >> 6) & 0x3F)));
+            scratch.append(char(0x80 | (code & 0x3F)));
+        }
+        else
+        {
+            scratch.append(char(0xF0 | (code >> 18)));
+            scratch.append(char(0x80 | ((code >> 12) & 0x3F)));
+            scratch.append(char(0x80 | ((code >> 6) & 0x3F)));
+            scratch.append(char(0x80 | (code & 0x3F)));
+        }
+        return true;
+    }
+
+    bool parseHex(uint *code)
+    {
+        *code = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            int c = get();
+            uint digit;
+            if (c >= '0' && c <= '9')
+                digit = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                digit = c - 'A' + 10;
+            else
+                return fail(QJsonParseError::IllegalEscapeSequence);
+            *code = (*code << 4) | digit;
+        }
+        return true;
+    }
+
+    bool parseLiteral(const char *literal)
+    {
+        for (const char *p = literal; *p; p++)
+        {
+            if (get() != uchar(*p))
+                return fail(QJsonParseError::IllegalValue);
+        }
+        return true;
+    }
+
+    // Numbers are checked against the grammar of RFC 8259 as they are read:
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool parseNumber(QVariant *value)
+    {
+        scratch.resize(0);
+        bool isInteger = true;
+        if (peek() == '-')
+            scratch.append(char(get()));
+        if (peek() == '0')
+            scratch.append(char(get()));
+        else if (!appendDigits())
+            return fail(QJsonParseError::IllegalNumber);
+        int c = peek();
+        if (c == '.')
+        {
+            isInteger = false;
+            scratch.append(char(get()));
+            if (!appendDigits())
+                return fail(QJsonParseError::IllegalNumber);
+            c = peek();
+        }
+        if (c == 'e' || c == 'E')
+        {
+            isInteger = false;
+            scratch.append(char(get()));
+            c = peek();
+            if (c == '+' || c == '-')
+                scratch.append(char(get()));
+            if (!appendDigits())
+                return fail(QJsonParseError::IllegalNumber);
+            c = peek();
+        }
+        // Anything that could go on a number must not, as in 01 or 1.2.3.
+        if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E'
+                || c == '+' || c == '-')
+            return fail(QJsonParseError::IllegalNumber);
+
+        bool ok = false;
+        if (isInteger)
+        {
+            qlonglong n = scratch.toLongLong(&ok);
+            if (ok)
+            {
+                *value = n;
+                return true;
+            }
+        }
+        double d = scratch.toDouble(&ok);
+        if (!ok)
+            return fail(QJsonParseError::IllegalNumber);
+        *value = d;
+        return true;
+    }
+
+    // Appends a run of digits to scratch, returning false if there is none.
+    bool appendDigits()
+    {
+        const int n = scratch.size();
+        for (int c = peek(); c >= '0' && c <= '9'; c = peek())
+        {
+            scratch.append(char(c));
+            pos++;
+        }
+        return scratch.size() > n;
+    }
+};
+
+// Streaming JSON serializer for OrderedVariantHash documents.
+//
+// Output is collected in a small buffer that is written to the device
+// whenever it fills up, so writing a document never holds more than a
+// chunk of it in memory. Objects are written in key order; besides the
+// types produced by OrderedJsonReader, QVariantMap, QVariantHash and any
+// value convertible to QString are accepted. Non-finite numbers are
+// written as null, as QJsonDocument does.
+class QTCOLLECTIONS_SHARED_EXPORT OrderedJsonWriter
+{
+public:
+    enum Format
+    {
+        Indented,
+        Compact
+    };
+
+    explicit OrderedJsonWriter(QIODevice *device,
+                               Format format = Indented) :
+        device(device), format(format), failed(false)
+    {
+        buffer.reserve(ChunkSize + ChunkSize / 4);
+    }
+
+    bool write(const QVariant &value)
+    {
+        writeValue(value, 0);
+        return finish();
+    }
+
+    bool write(const OrderedVariantHash &object)
+    {
+        writeObject(object, 0);
+        return finish();
+    }
+
+    static QByteArray toJson(const QVariant &value,
+                             Format format = Indented)
+    {
+        QBuffer device;
+        device.open(QIODevice::WriteOnly);
+        OrderedJsonWriter(&device, format).write(value);
+        return device.data();
+    }
+
+private:
+    QIODevice *device;
+    Format format;
+    bool failed;
+    QByteArray buffer;
+    QByteArray spaces;
+
+    enum { ChunkSize = 64 * 1024 };
+
+    void flush()
+    {
+        if (buffer.isEmpty())
+            return;
+        if (device->write(buffer) != buffer.size())
+            failed = true;
+        buffer.resize(0);
+    }
+
+    bool finish()
+    {
+        if (format == Indented)
+            buffer.append('\n');
+        flush();
+        return !failed;
+    }
+
+    void newLine(int indent)
+    {
+        if (format == Compact)
+            return;
+        buffer.append('\n');
+        if (spaces.size() < indent * 4)
+            spaces.fill(' ', indent * 4);
+        buffer.append(spaces.constData(), indent * 4);
+    }
+
+    void writeValue(const QVariant &value, int indent)
+    {
+        const int type = value.userType();
+        if (type == qMetaTypeId<OrderedVariantHash>())
+        {
+            writeObject(*static_cast<const OrderedVariantHash *>(
+                            value.constData()), indent);
+            return;
+        }
+
+        switch (type)
+        {
+        case QMetaType::UnknownType:
+        case QMetaType::Nullptr:
+            buffer.append("null");
+            break;
+        case QMetaType::Bool:
+            buffer.append(value.toBool() ? "true" : "false");
+            break;
+        case QMetaType::Int:
+        case QMetaType::Long:
+        case QMetaType::LongLong:
+        case QMetaType::Short:
+            buffer.append(QByteArray::number(value.toLongLong()));
+            break;
+        case QMetaType::UInt:
+        case QMetaType::ULong:
+        case QMetaType::ULongLong:
+        case QMetaType::UShort:
+            buffer.append(QByteArray::number(value.toULongLong()));
+            break;
+        case QMetaType::Double:
+        case QMetaType::Float:
+        {
+            double d = value.toDouble();
+            if (!qIsFinite(d))
+                buffer.append("null");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 7, 0)
+            else
+                buffer.append(QByteArray::number(
+                                  d, 'g', QLocale::FloatingPointShortest));
+#else
+            else
+                buffer.append(QByteArray::number(d, 'g', 17));
+#endif
+            break;
+        }
+        case QMetaType::QVariantList:
+        case QMetaType::QStringList:
+            writeArray(value.toList(), indent);
+            break;
+        case QMetaType::QVariantMap:
+            writeObject(value.toMap(), indent);
+            break;
+        case QMetaType::QVariantHash:
+            writeObject(value.toHash(), indent);
+            break;
+        default:
+            if (value.canConvert<QString>())
+                writeString(value.toString());
+            else
+                buffer.append("null");
+            break;
+        }
+        if (buffer.size() >= ChunkSize)
+            flush();
+    }
+
+    template <typename Object>
+    void writeObject(const Object &object, int indent)
+    {
+        if (object.isEmpty())
+        {
+            buffer.append("{}");
+            return;
+        }
+        buffer.append('{');
+        for (typename Object::const_iterator it = object.constBegin();
+             it != object.constEnd(); ++it)
+        {
+            if (it != object.constBegin())
+                buffer.append(',');
+            newLine(indent + 1);
+            writeString(it.key());
+            buffer.append(format == Compact ? ":" : ": ");
+            writeValue(it.value(), indent + 1);
+        }
+        newLine(indent);
+        buffer.append('}');
+    }
+
+    void writeArray(const QVariantList &array, int indent)
+    {
+        if (array.isEmpty())
+        {
+            buffer.append("[]");
+            return;
+        }
+        buffer.append('[');
+        for (int i = 0; i < array.size(); i++)
+        {
+            if (i)
+                buffer.append(',');
+            newLine(indent + 1);
+            writeValue(array.at(i), indent + 1);
+        }
+        newLine(indent);
+        buffer.append(']');
+    }
+
+    void writeString(const QString &string)
+    {
+        static const char hex[] = "0123456789abcdef";
+        const QByteArray utf8 = string.toUtf8();
+        const char *p = utf8.constData();
+        const char *end = p + utf8.size();
+        buffer.append('"');
+        while (p < end)
+        {
+            // Copy runs that need no escaping in one go.
+            const char *run = p;
+            while (p < end && uchar(*p) >= 0x20 && *p != '"' && *p != '\\')
+                p++;
+            buffer.append(run, int(p - run));
+            if (p == end)
+                break;
+
+            const uchar c = uchar(*p++);
+            buffer.append('\\');
+            switch (c)
+            {
+            case '"': buffer.append('"'); break;
+            case '\\': buffer.append('\\'); break;
+            case '\b': buffer.append('b'); break;
+            case '\f': buffer.append('f'); break;
+            case '\n': buffer.append('n'); break;
+            case '\r': buffer.append('r'); break;
+            case '\t': buffer.append('t'); break;
+            default:
+                buffer.append("u00");
+                buffer.append(hex[c >> 4]);
+                buffer.append(hex[c & 0xF]);
+                break;
+            }
+        }
+        buffer.append('"');
+    }
+};
+
+}   // namespace qtcollections
+
+#endif // QTCOLLECTIONS_ORDEREDJSON_H
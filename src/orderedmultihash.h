@@ -0,0 +1,464 @@
+#ifndef QTCOLLECTIONS_ORDEREDMULTIHASH_H
+#define QTCOLLECTIONS_ORDEREDMULTIHASH_H
+
+#ifdef Q_COMPILER_INITIALIZER_LISTS
+#include <initializer_list>
+#endif
+#include <iterator>
+#include <QList>
+#include "qtcollections_global.h"
+#include "orderedhash.h"
+
+namespace qtcollections
+{
+
+// One occurrence of a key. Occurrences of the same key are doubly linked
+// through their serial numbers, in insertion order.
+template <typename Key, typename T>
+struct OrderedMultiHashItem
+{
+    Key key;
+    T value;
+    qint64 previous;
+    qint64 next;
+};
+
+// First and last occurrence of a key, and the number of occurrences.
+struct OrderedMultiHashChain
+{
+    qint64 first;
+    qint64 last;
+    int count;
+
+    inline OrderedMultiHashChain() : first(-1), last(-1), count(0) {}
+};
+
+// An insertion-ordered hash that allows multiple values per key.
+//
+// Every insert() adds a new occurrence at the end, so iteration yields all
+// (key, value) pairs in arrival order. The hash is made of two OrderedHash
+// instances: occurrences keyed by a serial number (which uses the flat
+// engine), and, for each distinct key, the chain linking its occurrences.
+// values(key) follows that chain without scanning other keys, erasing an
+// occurrence through an iterator is O(1), and uniqueKeys() returns keys in
+// the order they were first seen.
+//
+// Pairs are not indexed, though: remove(key, value), find(key, value),
+// contains(key, value) and count(key, value) walk the key's chain comparing
+// values, so they are O(count(key)). When a key has many values, keep the
+// iterator returned by insert() or find() and erase through it instead:
+//
+//     OrderedMultiHash<QString, int>::iterator it = hash.insert("a", 1);
+//     ...
+//     hash.erase(it);
+template <typename Key, typename T>
+class QTCOLLECTIONS_SHARED_EXPORT OrderedMultiHash
+{
+    typedef OrderedMultiHashItem<Key, T> Item;
+    typedef OrderedMultiHashChain Chain;
+    typedef OrderedHash<qint64, Item> Items;
+
+    Items items;
+    OrderedHash<Key, Chain> chains;
+    qint64 nextSerial;
+
+public:
+    inline OrderedMultiHash() : nextSerial(0) {}
+#ifdef Q_COMPILER_INITIALIZER_LISTS
+    inline OrderedMultiHash(std::initializer_list<std::pair<Key,T> > list);
+#endif
+
+    inline void reserve(int size) { items.reserve(size); }
+    inline void squeeze() { items.squeeze(); chains.squeeze(); }
+    inline void swap(OrderedMultiHash &other);
+
+    bool operator==(const OrderedMultiHash &other) const;
+    inline bool operator!=(const OrderedMultiHash &other) const
+        { return !(*this == other); }
+
+    inline int size() const { return items.size(); }
+    inline bool isEmpty() const { return items.isEmpty(); }
+    inline int count() const { return items.size(); }
+    inline int count(const Key &key) const
+        { return chains.value(key).count; }
+    int count(const Key &key, const T &value) const;
+
+    inline void clear() { items.clear(); chains.clear(); }
+    int remove(const Key &key);
+    // O(count(key)); see above.
+    int remove(const Key &key, const T &value);
+
+    inline bool contains(const Key &key) const
+        { return chains.contains(key); }
+    inline bool contains(const Key &key, const T &value) const
+        { return find(key, value) != constEnd(); }
+
+    // The first value inserted for the key.
+    const T value(const Key &key) const { return value(key, T()); }
+    const T value(const Key &key, const T &defaultValue) const;
+    QList<T> values(const Key &key) const;
+    QList<T> values() const;
+    QList<Key> keys() const;
+    inline QList<Key> uniqueKeys() const { return chains.keys(); }
+    inline int uniqueCount() const { return chains.size(); }
+
+    class const_iterator;
+
+    class iterator
+    {
+        friend class const_iterator;
+        friend class OrderedMultiHash;
+
+        typename Items::iterator i;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef T value_type;
+        typedef T *pointer;
+        typedef T &reference;
+
+        inline iterator() {}
+        explicit inline iterator(const typename Items::iterator &i) : i(i) {}
+
+        inline const Key &key() const { return i->key; }
+        inline T &value() const { return i->value; }
+        inline T &operator*() const { return value(); }
+        inline T *operator->() const { return &value(); }
+
+        inline bool operator==(const iterator &o) const { return i == o.i; }
+        inline bool operator!=(const iterator &o) const { return i != o.i; }
+
+        inline iterator &operator++() { ++i; return *this; }
+        inline iterator operator++(int) { return iterator(i++); }
+        inline iterator &operator--() { --i; return *this; }
+        inline iterator operator--(int) { return iterator(i--); }
+    };
+    friend class iterator;
+
+    class const_iterator
+    {
+        friend class iterator;
+        friend class OrderedMultiHash;
+
+        typename Items::const_iterator i;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef T value_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        inline const_iterator() {}
+        explicit inline const_iterator(
+                const typename Items::const_iterator &i) : i(i) {}
+#ifdef QT_STRICT_ITERATORS
+        explicit
+#endif
+        inline const_iterator(const iterator &o) : i(o.i) {}
+
+        inline const Key &key() const { return i->key; }
+        inline const T &value() const { return i->value; }
+        inline const T &operator*() const { return value(); }
+        inline const T *operator->() const { return &value(); }
+
+        inline bool operator==(const const_iterator &o) const
+            { return i == o.i; }
+        inline bool operator!=(const const_iterator &o) const
+            { return i != o.i; }
+
+        inline const_iterator &operator++() { ++i; return *this; }
+        inline const_iterator operator++(int)
+            { return const_iterator(i++); }
+        inline const_iterator &operator--() { --i; return *this; }
+        inline const_iterator operator--(int)
+            { return const_iterator(i--); }
+    };
+    friend class const_iterator;
+
+    // STL-style iteration.
+    inline iterator begin() { return iterator(items.begin()); }
+    inline const_iterator begin() const
+        { return const_iterator(items.constBegin()); }
+    inline const_iterator cbegin() const
+        { return const_iterator(items.constBegin()); }
+    inline const_iterator constBegin() const
+        { return const_iterator(items.constBegin()); }
+    inline iterator end() { return iterator(items.end()); }
+    inline const_iterator end() const
+        { return const_iterator(items.constEnd()); }
+    inline const_iterator cend() const
+        { return const_iterator(items.constEnd()); }
+    inline const_iterator constEnd() const
+        { return const_iterator(items.constEnd()); }
+
+    // STL compatibility.
+    typedef T mapped_type;
+    typedef Key key_type;
+    typedef qptrdiff difference_type;
+    typedef int size_type;
+    inline bool empty() const { return isEmpty(); }
+
+    // Qt Core compatibility.
+    typedef iterator Iterator;
+    typedef const_iterator ConstIterator;
+    iterator find(const Key &key);
+    const_iterator find(const Key &key) const { return constFind(key); }
+    const_iterator constFind(const Key &key) const;
+    // O(count(key)), as are the other lookups by pair.
+    iterator find(const Key &key, const T &value);
+    const_iterator find(const Key &key, const T &value) const
+        { return constFind(key, value); }
+    const_iterator constFind(const Key &key, const T &value) const;
+    iterator erase(iterator it);
+
+    // Map interface.
+    iterator insert(const Key &key, const T &value);
+
+private:
+    void unlink(const Item &item);
+    qint64 serialOf(const Key &key, const T &value) const;
+};
+
+#ifdef Q_COMPILER_INITIALIZER_LISTS
+template <typename Key, typename T>
+OrderedMultiHash<Key, T>::OrderedMultiHash(
+        std::initializer_list< std::pair<Key, T> > list) :
+    nextSerial(0)
+{
+    typedef typename std::initializer_list<std::pair<Key,T> >::const_iterator
+            InitListConstIterator;
+    for (InitListConstIterator it = list.begin(); it != list.end(); ++it)
+        insert(it->first, it->second);
+}
+#endif
+
+template <typename Key, typename T>
+void OrderedMultiHash<Key, T>::swap(OrderedMultiHash &other)
+{
+    items.swap(other.items);
+    chains.swap(other.chains);
+    qSwap(nextSerial, other.nextSerial);
+}
+
+template <typename Key, typename T>
+bool OrderedMultiHash<Key, T>::operator==(const OrderedMultiHash &other) const
+{
+    if (size() != other.size())
+        return false;
+    const_iterator it = constBegin();
+    const_iterator oit = other.constBegin();
+    for (; it != constEnd(); ++it, ++oit)
+    {
+        if (!(it.key() == oit.key()) || !(it.value() == oit.value()))
+            return false;
+    }
+    return true;
+}
+
+template <typename Key, typename T>
+int OrderedMultiHash<Key, T>::count(const Key &key, const T &value) const
+{
+    int n = 0;
+    qint64 serial = chains.value(key).first;
+    while (serial >= 0)
+    {
+        const Item &item = *items.constFind(serial);
+        if (item.value == value)
+            n++;
+        serial = item.next;
+    }
+    return n;
+}
+
+template <typename Key, typename T>
+int OrderedMultiHash<Key, T>::remove(const Key &key)
+{
+    typename OrderedHash<Key, Chain>::iterator cit = chains.find(key);
+    if (cit == chains.end())
+        return 0;
+    int n = cit->count;
+    qint64 serial = cit->first;
+    while (serial >= 0)
+    {
+        typename Items::iterator it = items.find(serial);
+        serial = it->next;
+        items.erase(it);
+    }
+    chains.erase(cit);
+    return n;
+}
+
+template <typename Key, typename T>
+int OrderedMultiHash<Key, T>::remove(const Key &key, const T &value)
+{
+    int n = 0;
+    qint64 serial = chains.value(key).first;
+    while (serial >= 0)
+    {
+        typename Items::iterator it = items.find(serial);
+        serial = it->next;
+        if (it->value == value)
+        {
+            erase(iterator(it));
+            n++;
+        }
+    }
+    return n;
+}
+
+template <typename Key, typename T>
+const T OrderedMultiHash<Key, T>::value(
+        const Key &key, const T &defaultValue) const
+{
+    typename OrderedHash<Key, Chain>::const_iterator cit = chains.find(key);
+    if (cit == chains.constEnd())
+        return defaultValue;
+    return items.constFind(cit->first)->value;
+}
+
+template <typename Key, typename T>
+QList<T> OrderedMultiHash<Key, T>::values(const Key &key) const
+{
+    QList<T> values;
+    typename OrderedHash<Key, Chain>::const_iterator cit = chains.find(key);
+    if (cit == chains.constEnd())
+        return values;
+    values.reserve(cit->count);
+    for (qint64 serial = cit->first; serial >= 0; )
+    {
+        const Item &item = *items.constFind(serial);
+        values.append(item.value);
+        serial = item.next;
+    }
+    return values;
+}
+
+template <typename Key, typename T>
+QList<T> OrderedMultiHash<Key, T>::values() const
+{
+    QList<T> values;
+    values.reserve(size());
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        values.append(it.value());
+    return values;
+}
+
+template <typename Key, typename T>
+QList<Key> OrderedMultiHash<Key, T>::keys() const
+{
+    QList<Key> keys;
+    keys.reserve(size());
+    for (const_iterator it = constBegin(); it != constEnd(); ++it)
+        keys.append(it.key());
+    return keys;
+}
+
+template <typename Key, typename T>
+typename OrderedMultiHash<Key, T>::iterator OrderedMultiHash<Key, T>::find(
+        const Key &key)
+{
+    typename OrderedHash<Key, Chain>::const_iterator cit = chains.find(key);
+    if (cit == chains.constEnd())
+        return end();
+    return iterator(items.find(cit->first));
+}
+
+template <typename Key, typename T>
+typename OrderedMultiHash<Key, T>::const_iterator
+OrderedMultiHash<Key, T>::constFind(const Key &key) const
+{
+    typename OrderedHash<Key, Chain>::const_iterator cit = chains.find(key);
+    if (cit == chains.constEnd())
+        return constEnd();
+    return const_iterator(items.constFind(cit->first));
+}
+
+template <typename Key, typename T>
+typename OrderedMultiHash<Key, T>::iterator OrderedMultiHash<Key, T>::find(
+        const Key &key, const T &value)
+{
+    qint64 serial = serialOf(key, value);
+    return serial < 0 ? end() : iterator(items.find(serial));
+}
+
+template <typename Key, typename T>
+typename OrderedMultiHash<Key, T>::const_iterator
+OrderedMultiHash<Key, T>::constFind(const Key &key, const T &value) const
+{
+    qint64 serial = serialOf(key, value);
+    return serial < 0 ? constEnd() : const_iterator(items.constFind(serial));
+}
+
+template <typename Key, typename T>
+typename OrderedMultiHash<Key, T>::iterator OrderedMultiHash<Key, T>::erase(
+        typename OrderedMultiHash<Key, T>::iterator it)
+{
+    if (it == end())
+        return it;
+    unlink(*it.i);
+    return iterator(items.erase(it.i));
+}
+
+template <typename Key, typename T>
+typename OrderedMultiHash<Key, T>::iterator OrderedMultiHash<Key, T>::insert(
+        const Key &key, const T &value)
+{
+    qint64 serial = nextSerial++;
+    Chain &chain = chains[key];
+    Item item = { key, value, chain.last, -1 };
+    if (chain.last >= 0)
+        items.find(chain.last)->next = serial;
+    else
+        chain.first = serial;
+    chain.last = serial;
+    chain.count++;
+    return iterator(items.insert(serial, item));
+}
+
+template <typename Key, typename T>
+void OrderedMultiHash<Key, T>::unlink(const Item &item)
+{
+    // item may live in items, so read it before touching its neighbours.
+    typename OrderedHash<Key, Chain>::iterator cit = chains.find(item.key);
+    qint64 previous = item.previous;
+    qint64 next = item.next;
+    if (previous >= 0)
+        items.find(previous)->next = next;
+    else
+        cit->first = next;
+    if (next >= 0)
+        items.find(next)->previous = previous;
+    else
+        cit->last = previous;
+    if (--cit->count == 0)
+        chains.erase(cit);
+}
+
+template <typename Key, typename T>
+qint64 OrderedMultiHash<Key, T>::serialOf(
+        const Key &key, const T &value) const
+{
+    qint64 serial = chains.value(key).first;
+    while (serial >= 0)
+    {
+        const Item &item = *items.constFind(serial);
+        if (item.value == value)
+            return serial;
+        serial = item.next;
+    }
+    return -1;
+}
+
+}   // namespace qtcollections
+
+template <typename Key, typename T>
+class QTypeInfo<qtcollections::OrderedMultiHashItem<Key, T> > :
+        public qtcollections::TypeInfoMerger<
+            qtcollections::OrderedMultiHashItem<Key, T>, Key, T>
+{};
+
+Q_DECLARE_TYPEINFO(qtcollections::OrderedMultiHashChain, Q_MOVABLE_TYPE);
+
+#endif // QTCOLLECTIONS_ORDEREDMULTIHASH_H
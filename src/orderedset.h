@@ -0,0 +1,477 @@
+#ifndef QTCOLLECTIONS_ORDEREDSET_H
+#define QTCOLLECTIONS_ORDEREDSET_H
+
+#ifdef Q_COMPILER_INITIALIZER_LISTS
+#include <initializer_list>
+#endif
+#include <iterator>
+#include <QHash>
+#include <QLinkedList>
+#include <QList>
+#include "qtcollections_global.h"
+#include "orderedhash.h"
+
+namespace qtcollections
+{
+
+// Value type of the OrderedHash behind an OrderedSet. The engines below are
+// specialized for it so that no value is actually stored.
+struct OrderedHashDummyValue
+{
+    inline bool operator==(const OrderedHashDummyValue &) const
+        { return true; }
+};
+
+template <typename Key>
+struct OrderedHashEntry<Key, OrderedHashDummyValue>
+{
+    static OrderedHashDummyValue value;
+    Key key;
+
+    inline OrderedHashEntry() : key() {}
+    inline OrderedHashEntry(const Key &key, const OrderedHashDummyValue &) :
+        key(key) {}
+};
+
+template <typename Key>
+OrderedHashDummyValue OrderedHashEntry<Key, OrderedHashDummyValue>::value;
+
+}   // namespace qtcollections
+
+// Declared before anything below instantiates a QVector of these entries.
+Q_DECLARE_TYPEINFO(qtcollections::OrderedHashDummyValue, Q_PRIMITIVE_TYPE);
+
+template <typename Key>
+class QTypeInfo<
+        qtcollections::OrderedHashEntry<Key,
+                                        qtcollections::OrderedHashDummyValue> > :
+        public qtcollections::TypeInfoMerger<
+            qtcollections::OrderedHashEntry<Key,
+                                            qtcollections::OrderedHashDummyValue>,
+            Key>
+{};
+
+namespace qtcollections
+{
+
+// Node engine without the value hash: the key list keeps the order, and the
+// lookup hash doubles as the membership index.
+template <typename Key, typename Hasher>
+struct QTCOLLECTIONS_SHARED_EXPORT
+OrderedHashData<Key, OrderedHashDummyValue, Hasher, false>
+{
+    typedef OrderedHashDummyValue T;
+    typedef typename QLinkedList<Key>::iterator KeyIterator;
+    typedef KeyIterator Cursor;
+    QLinkedList<Key> keys;
+    OrderedHashTable<Key, KeyIterator, Hasher> lookup;
+    bool incremental;
+    T dummy;
+
+    explicit OrderedHashData(const Hasher &hasher = Hasher()) :
+        lookup(hasher), incremental(false) {}
+    OrderedHashData(const OrderedHashData &o) :
+        keys(o.keys), lookup(o.lookup.hasher), incremental(o.incremental)
+    {
+        lookup.reserve(keys.size());
+        for (KeyIterator i = keys.begin(); i != keys.end(); i++)
+            lookup.insert(*i, i, false);
+    }
+
+    inline const Hasher &hashPolicy() const { return lookup.hasher; }
+
+    inline int size() const { return lookup.size(); }
+    inline int capacity() const { return lookup.capacity(); }
+    inline void reserve(int size) { lookup.reserve(size); }
+    inline void squeeze() { lookup.squeeze(); }
+
+    void clear()
+    {
+        keys.clear();
+        lookup.clear();
+    }
+
+    void setIncrementalResize(bool enable)
+    {
+        incremental = enable;
+        if (!enable)
+            lookup.finish();
+    }
+
+    inline Cursor begin() { return keys.begin(); }
+    inline Cursor end() { return keys.end(); }
+    inline Cursor next(Cursor i) const { return ++i; }
+    inline Cursor previous(Cursor i) const { return --i; }
+
+    inline const Key &key(Cursor i) const { return *i; }
+    inline T &value(Cursor) { return dummy; }
+    inline const T &value(Cursor) const { return dummy; }
+
+    inline Cursor find(const Key &key)
+    {
+        const KeyIterator *i = lookup.constFind(key);
+        return i ? *i : keys.end();
+    }
+
+    Cursor insert(const Key &key, const T &)
+    {
+        const KeyIterator *i = lookup.constFind(key);
+        if (i)
+            return *i;
+
+        KeyIterator kit = keys.insert(keys.end(), key);
+        lookup.insert(key, kit, incremental);
+        lookup.step(ResizeStep);
+        return kit;
+    }
+
+    Cursor link(Cursor before, Key &key, T &)
+    {
+        KeyIterator kit = keys.insert(before, Key());
+        qSwap(*kit, key);
+        lookup.insert(*kit, kit, incremental);
+        lookup.step(ResizeStep);
+        return kit;
+    }
+
+    void unlink(Cursor it, Key &key, T &)
+    {
+        lookup.remove(*it);
+        lookup.step(ResizeStep);
+        qSwap(key, *it);
+        keys.erase(it);
+    }
+
+    Cursor erase(Cursor it)
+    {
+        lookup.remove(*it);
+        lookup.step(ResizeStep);
+        return keys.erase(it);
+    }
+
+    int erase(Cursor first, Cursor last)
+    {
+        if (first == keys.begin() && last == keys.end())
+        {
+            const int removed = size();
+            clear();
+            return removed;
+        }
+        int removed = 0;
+        for (KeyIterator it = first; it != last; ++it)
+        {
+            lookup.remove(*it);
+            removed++;
+        }
+        keys.erase(first, last);
+        lookup.step(ResizeStep);
+        return removed;
+    }
+
+    template <typename Predicate>
+    int removeIf(Predicate pred)
+    {
+        lookup.finish();
+        int removed = 0;
+        KeyIterator it = keys.begin();
+        while (it != keys.end())
+        {
+            if (pred(*it, dummy))
+            {
+                lookup.remove(*it);
+                it = keys.erase(it);
+                removed++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+private:
+    enum { ResizeStep = 8 };
+};
+
+// An insertion-ordered set, the set counterpart of OrderedHash.
+//
+// OrderedSet shares OrderedHash's engines, specialized so that no storage
+// is spent on values. Set algebra keeps the order of the left-hand side,
+// with new items from unite() appended in the order of the right-hand side,
+// and runs in time linear in the sizes of the operands.
+template <typename T>
+class QTCOLLECTIONS_SHARED_EXPORT OrderedSet
+{
+    typedef OrderedHash<T, OrderedHashDummyValue> Hash;
+    Hash h;
+
+public:
+    inline OrderedSet() {}
+#ifdef Q_COMPILER_INITIALIZER_LISTS
+    inline OrderedSet(std::initializer_list<T> list)
+    {
+        reserve(int(list.size()));
+        for (typename std::initializer_list<T>::const_iterator it =
+                list.begin(); it != list.end(); ++it)
+            insert(*it);
+    }
+#endif
+
+    inline int capacity() const { return h.capacity(); }
+    inline void reserve(int size) { h.reserve(size); }
+    inline void squeeze() { h.squeeze(); }
+
+    inline void swap(OrderedSet &other) { h.swap(other.h); }
+
+    // Sets compare equal only if they hold the same items in the same order.
+    inline bool operator==(const OrderedSet &other) const
+        { return h == other.h; }
+    inline bool operator!=(const OrderedSet &other) const
+        { return h != other.h; }
+
+    inline int size() const { return h.size(); }
+    inline bool isEmpty() const { return h.isEmpty(); }
+
+    inline void clear() { h.clear(); }
+    inline bool remove(const T &value) { return h.remove(value) != 0; }
+
+    inline bool contains(const T &value) const { return h.contains(value); }
+    bool contains(const OrderedSet &other) const;
+    bool intersects(const OrderedSet &other) const;
+
+    class const_iterator
+    {
+        friend class OrderedSet;
+        typename Hash::const_iterator i;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef T value_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        inline const_iterator() {}
+        explicit inline const_iterator(const typename Hash::const_iterator &i) :
+            i(i) {}
+
+        inline const T &operator*() const { return i.key(); }
+        inline const T *operator->() const { return &i.key(); }
+
+        inline bool operator==(const const_iterator &o) const
+            { return i == o.i; }
+        inline bool operator!=(const const_iterator &o) const
+            { return i != o.i; }
+
+        inline const_iterator &operator++() { ++i; return *this; }
+        inline const_iterator operator++(int)
+            { return const_iterator(i++); }
+        inline const_iterator &operator--() { --i; return *this; }
+        inline const_iterator operator--(int)
+            { return const_iterator(i--); }
+        inline const_iterator operator+(int j) const
+            { return const_iterator(i + j); }
+        inline const_iterator operator-(int j) const
+            { return const_iterator(i - j); }
+    };
+    typedef const_iterator iterator;
+
+    // STL-style iteration.
+    inline const_iterator begin() const
+        { return const_iterator(h.constBegin()); }
+    inline const_iterator cbegin() const
+        { return const_iterator(h.constBegin()); }
+    inline const_iterator constBegin() const
+        { return const_iterator(h.constBegin()); }
+    inline const_iterator end() const
+        { return const_iterator(h.constEnd()); }
+    inline const_iterator cend() const
+        { return const_iterator(h.constEnd()); }
+    inline const_iterator constEnd() const
+        { return const_iterator(h.constEnd()); }
+
+    // STL compatibility.
+    typedef T key_type;
+    typedef T value_type;
+    typedef qptrdiff difference_type;
+    typedef int size_type;
+    inline bool empty() const { return isEmpty(); }
+
+    // Qt Core compatibility.
+    typedef const_iterator ConstIterator;
+    typedef const_iterator Iterator;
+    inline int count() const { return h.size(); }
+    inline const_iterator find(const T &value) const
+        { return const_iterator(h.constFind(value)); }
+    inline const_iterator constFind(const T &value) const
+        { return const_iterator(h.constFind(value)); }
+    const_iterator erase(const_iterator it);
+    inline const_iterator insert(const T &value)
+        { return const_iterator(h.insert(value, OrderedHashDummyValue())); }
+
+    // Node interface, as OrderedHash's.
+    typedef typename Hash::Node Node;
+    typedef Node node_type;
+    inline Node extract(const T &value) { return h.extract(value); }
+    inline const_iterator insert(Node &node)
+        { return const_iterator(h.insert(node)); }
+    const_iterator insert(Node &node, const_iterator before);
+    inline int merge(OrderedSet &other) { return h.merge(other.h); }
+
+    // Set algebra.
+    OrderedSet &unite(const OrderedSet &other);
+    OrderedSet &intersect(const OrderedSet &other);
+    OrderedSet &subtract(const OrderedSet &other);
+
+    inline OrderedSet &operator<<(const T &value)
+        { insert(value); return *this; }
+    inline OrderedSet &operator|=(const OrderedSet &other)
+        { return unite(other); }
+    inline OrderedSet &operator|=(const T &value)
+        { insert(value); return *this; }
+    inline OrderedSet &operator&=(const OrderedSet &other)
+        { return intersect(other); }
+    inline OrderedSet &operator+=(const OrderedSet &other)
+        { return unite(other); }
+    inline OrderedSet &operator+=(const T &value)
+        { insert(value); return *this; }
+    inline OrderedSet &operator-=(const OrderedSet &other)
+        { return subtract(other); }
+    inline OrderedSet &operator-=(const T &value)
+        { remove(value); return *this; }
+    inline OrderedSet operator|(const OrderedSet &other) const
+        { OrderedSet result = *this; result |= other; return result; }
+    inline OrderedSet operator&(const OrderedSet &other) const
+        { OrderedSet result = *this; result &= other; return result; }
+    inline OrderedSet operator+(const OrderedSet &other) const
+        { OrderedSet result = *this; result += other; return result; }
+    inline OrderedSet operator-(const OrderedSet &other) const
+        { OrderedSet result = *this; result -= other; return result; }
+
+    // Sequence interface.
+    inline const T &first() const { return h.firstKey(); }
+    inline const T &last() const { return h.lastKey(); }
+    inline T takeFirst() { return h.takeFirst().first; }
+    inline T takeLast() { return h.takeLast().first; }
+    inline void removeFirst() { h.removeFirst(); }
+    inline void removeLast() { h.removeLast(); }
+
+    QList<T> values() const { return h.keys(); }
+    QList<T> toList() const { return h.keys(); }
+
+private:
+    struct In
+    {
+        const OrderedSet &set;
+        inline bool operator()(const T &value,
+                               const OrderedHashDummyValue &) const
+            { return set.contains(value); }
+    };
+
+    struct NotIn
+    {
+        const OrderedSet &set;
+        inline bool operator()(const T &value,
+                               const OrderedHashDummyValue &) const
+            { return !set.contains(value); }
+    };
+};
+
+template <typename T>
+bool OrderedSet<T>::contains(const OrderedSet &other) const
+{
+    for (const_iterator it = other.constBegin(); it != other.constEnd(); ++it)
+    {
+        if (!contains(*it))
+            return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool OrderedSet<T>::intersects(const OrderedSet &other) const
+{
+    const OrderedSet &small = size() <= other.size() ? *this : other;
+    const OrderedSet &large = size() <= other.size() ? other : *this;
+    for (const_iterator it = small.constBegin(); it != small.constEnd(); ++it)
+    {
+        if (large.contains(*it))
+            return true;
+    }
+    return false;
+}
+
+template <typename T>
+typename OrderedSet<T>::const_iterator OrderedSet<T>::erase(
+        typename OrderedSet<T>::const_iterator it)
+{
+    // Sets have no mutable iterator; find the hash iterator by key.
+    if (it == constEnd())
+        return it;
+    return const_iterator(h.erase(h.find(*it)));
+}
+
+template <typename T>
+typename OrderedSet<T>::const_iterator OrderedSet<T>::insert(
+        Node &node, typename OrderedSet<T>::const_iterator before)
+{
+    if (before == constEnd())
+        return insert(node);
+    return const_iterator(h.insert(node, h.find(*before)));
+}
+
+template <typename T>
+OrderedSet<T> &OrderedSet<T>::unite(const OrderedSet &other)
+{
+    if (&other == this)
+        return *this;
+    reserve(size() + other.size());
+    for (const_iterator it = other.constBegin(); it != other.constEnd(); ++it)
+        insert(*it);
+    return *this;
+}
+
+template <typename T>
+OrderedSet<T> &OrderedSet<T>::intersect(const OrderedSet &other)
+{
+    if (&other == this)
+        return *this;
+    NotIn pred = { other };
+    h.removeIf(pred);
+    return *this;
+}
+
+template <typename T>
+OrderedSet<T> &OrderedSet<T>::subtract(const OrderedSet &other)
+{
+    if (&other == this)
+    {
+        clear();
+    }
+    else if (other.size() < size())
+    {
+        h.removeKeys(other);
+    }
+    else
+    {
+        In pred = { other };
+        h.removeIf(pred);
+    }
+    return *this;
+}
+
+// Instantiated in the library, as OrderedHash is.
+#if defined(Q_COMPILER_EXTERN_TEMPLATES) \
+        && defined(QTCOLLECTIONS_EXTERN_TEMPLATES)
+extern template struct OrderedHashData<QString, OrderedHashDummyValue>;
+extern template class OrderedHash<QString, OrderedHashDummyValue>;
+extern template class OrderedSet<QString>;
+extern template struct OrderedHashData<int, OrderedHashDummyValue>;
+extern template class OrderedHash<int, OrderedHashDummyValue>;
+extern template class OrderedSet<int>;
+#endif
+
+}   // namespace qtcollections
+
+#endif // QTCOLLECTIONS_ORDEREDSET_H
@@ -0,0 +1,28 @@
+#include "qtcollections.h"
+
+// Explicit instantiations of the templates declared extern in the headers.
+
+namespace qtcollections
+{
+
+template struct OrderedHashData<QString, QVariant>;
+template class OrderedHash<QString, QVariant>;
+template struct OrderedHashData<QString, QString>;
+template class OrderedHash<QString, QString>;
+template struct OrderedHashData<QString, int>;
+template class OrderedHash<QString, int>;
+template struct OrderedHashData<QByteArray, QByteArray>;
+template class OrderedHash<QByteArray, QByteArray>;
+template struct OrderedHashData<int, QString>;
+template class OrderedHash<int, QString>;
+template struct OrderedHashData<int, QVariant>;
+template class OrderedHash<int, QVariant>;
+
+template struct OrderedHashData<QString, OrderedHashDummyValue>;
+template class OrderedHash<QString, OrderedHashDummyValue>;
+template class OrderedSet<QString>;
+template struct OrderedHashData<int, OrderedHashDummyValue>;
+template class OrderedHash<int, OrderedHashDummyValue>;
+template class OrderedSet<int>;
+
+}   // namespace qtcollections
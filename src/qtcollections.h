@@ -3,5 +3,19 @@
 
 #include "qtcollections_global.h"
 #include "orderedhash.h"
+#include "internedstring.h"
+#include "orderedmultihash.h"
+#include "orderedset.h"
+#include "immutableorderedhash.h"
+#include "hashpolicy.h"
+#include "groupprobing.h"
+#include "ttlorderedhash.h"
+#include "journaledorderedhash.h"
+
+// The item model and the JSON reader and writer need Qt 5.
+#if QT_VERSION >= 0x050000
+#include "orderedhashmodel.h"
+#include "orderedjson.h"
+#endif
 
 #endif  // QTCOLLECTIONS_H
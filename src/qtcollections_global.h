@@ -13,4 +13,60 @@
 #   endif
 #endif
 
+namespace qtcollections
+{
+
+// Whether T is an integral type. Qt 4's QTypeInfo does not say, so there
+// the built-in integer types are listed instead.
+template <typename T>
+struct IsIntegral
+{
+#if QT_VERSION >= 0x050000
+    enum { value = QTypeInfo<T>::isIntegral };
+#else
+    enum { value = false };
+#endif
+};
+
+#if QT_VERSION < 0x050000
+#define QTCOLLECTIONS_DECLARE_INTEGRAL(T) \
+    template <> struct IsIntegral<T> { enum { value = true }; };
+QTCOLLECTIONS_DECLARE_INTEGRAL(bool)
+QTCOLLECTIONS_DECLARE_INTEGRAL(char)
+QTCOLLECTIONS_DECLARE_INTEGRAL(signed char)
+QTCOLLECTIONS_DECLARE_INTEGRAL(uchar)
+QTCOLLECTIONS_DECLARE_INTEGRAL(short)
+QTCOLLECTIONS_DECLARE_INTEGRAL(ushort)
+QTCOLLECTIONS_DECLARE_INTEGRAL(int)
+QTCOLLECTIONS_DECLARE_INTEGRAL(uint)
+QTCOLLECTIONS_DECLARE_INTEGRAL(long)
+QTCOLLECTIONS_DECLARE_INTEGRAL(ulong)
+QTCOLLECTIONS_DECLARE_INTEGRAL(long long)
+QTCOLLECTIONS_DECLARE_INTEGRAL(unsigned long long)
+#undef QTCOLLECTIONS_DECLARE_INTEGRAL
+#endif
+
+// The type info of a struct made of T1 and T2, for specializing QTypeInfo.
+// This is QTypeInfoMerger on Qt 5, which Qt 4 does not have.
+#if QT_VERSION >= 0x050000
+template <typename T, typename T1, typename T2 = T1>
+class TypeInfoMerger : public QTypeInfoMerger<T, T1, T2>
+{};
+#else
+template <typename T, typename T1, typename T2 = T1>
+class TypeInfoMerger
+{
+public:
+    enum {
+        isPointer = false,
+        isComplex = QTypeInfo<T1>::isComplex || QTypeInfo<T2>::isComplex,
+        isStatic = QTypeInfo<T1>::isStatic || QTypeInfo<T2>::isStatic,
+        isLarge = sizeof(T) > sizeof(void *),
+        isDummy = false
+    };
+};
+#endif
+
+}   // namespace qtcollections
+
 #endif // QTCOLLECTIONS_GLOBAL_H
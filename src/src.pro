@@ -4,11 +4,15 @@ greaterThan(QT_MAJOR_VERSION, 4) {
     CONFIG += c++11
 }
 
-TEMPLATE = subdirs
+TARGET = qtcollections
+TEMPLATE = lib
 
 include(../qtcollections.pri)
 
-DEFINES += QTCOLLECTIONS_LIBRARY
+DEFINES += QTCOLLECTIONS_LIBRARY QTCOLLECTIONS_EXTERN_TEMPLATES
+
+SOURCES += \
+    qtcollections.cpp
 
 unix {
     target.path = /usr/lib
@@ -0,0 +1,589 @@
+#ifndef QTCOLLECTIONS_TTLORDEREDHASH_H
+#define QTCOLLECTIONS_TTLORDEREDHASH_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QVector>
+#include "qtcollections_global.h"
+#include "hashpolicy.h"
+#include "orderedhash.h"
+
+namespace qtcollections
+{
+
+struct TtlOrderedHashTimer
+{
+    QElapsedTimer timer;
+    inline TtlOrderedHashTimer() { timer.start(); }
+};
+
+// Milliseconds on a monotonic clock; the default clock of TtlOrderedHash.
+inline qint64 ttlOrderedHashClock()
+{
+    static TtlOrderedHashTimer clock;
+    return clock.timer.elapsed();
+}
+
+template <typename T>
+struct TtlOrderedHashEntry
+{
+    T value;
+    qint64 deadline;
+    qint64 ttl;
+    bool custom;        // Has its own TTL, and is kept in the timer wheel.
+
+    inline TtlOrderedHashEntry() :
+        value(), deadline(0), ttl(0), custom(false) {}
+    inline TtlOrderedHashEntry(const T &value, qint64 deadline, qint64 ttl,
+                               bool custom) :
+        value(value), deadline(deadline), ttl(ttl), custom(custom) {}
+};
+
+// When an entry is due to expire. Records are never updated in place;
+// when an entry is removed or gets a new deadline, its record is left
+// behind and recognized as stale when it comes up.
+template <typename Key>
+struct TtlOrderedHashRecord
+{
+    Key key;
+    qint64 deadline;
+
+    inline TtlOrderedHashRecord() : key(), deadline(0) {}
+    inline TtlOrderedHashRecord(const Key &key, qint64 deadline) :
+        key(key), deadline(deadline) {}
+};
+
+// An insertion-ordered hash whose entries expire a fixed time (the TTL, in
+// milliseconds) after they are inserted, or after they are last written or
+// read, depending on the expiry policy.
+//
+// Whenever an entry's deadline is reset, it also moves to the end of the
+// hash, so entries with the hash's own TTL are always in deadline order: a
+// sweep pops them from the front until it reaches one that has not expired,
+// and never looks at the rest. Entries inserted with a TTL of their own
+// break that order, and are tracked by a timer wheel instead, whose slots
+// a sweep only visits once their time has come. Either way a sweep costs
+// about as much as the entries it removes.
+//
+// Expired entries are never returned by lookups, even before a sweep gets
+// to them; a lookup that runs into one removes it. Iteration and size()
+// do see expired entries not yet swept.
+//
+// Nothing here runs on its own. To sweep from a QTimer, call expire() on
+// timeout and restart the timer with msecsToNextExpiry().
+template <typename Key, typename T, typename Hasher = DefaultHashPolicy>
+class QTCOLLECTIONS_SHARED_EXPORT TtlOrderedHash
+{
+    typedef TtlOrderedHashEntry<T> Entry;
+    typedef TtlOrderedHashRecord<Key> Record;
+    typedef OrderedHash<Key, Entry, Hasher> Entries;
+
+public:
+    enum ExpiryPolicy
+    {
+        ExpireAfterInsert,  // Deadlines are set once, on first insertion.
+        ExpireAfterWrite,   // ...and reset by insert() and touch().
+        ExpireAfterAccess   // ...and by value() too, by the entry's TTL.
+    };
+
+    typedef qint64 (*Clock)();
+
+    explicit TtlOrderedHash(qint64 ttl,
+                            ExpiryPolicy policy = ExpireAfterWrite);
+
+    inline qint64 ttl() const { return defaultTtl; }
+    inline ExpiryPolicy expiryPolicy() const { return policy; }
+
+    // Replaces the clock. Deadlines already set are measured against the
+    // old clock, so this is best done while the hash is empty.
+    void setClock(Clock clock);
+    inline qint64 now() const { return clock(); }
+
+    inline int size() const { return entries.size(); }
+    inline bool isEmpty() const { return entries.isEmpty(); }
+    inline int count() const { return entries.size(); }
+    void clear();
+
+    // Inserts or updates an entry, with the given TTL or else the hash's
+    // own. Under ExpireAfterInsert, updating an entry only replaces its
+    // value, and keeps its TTL and deadline.
+    inline void insert(const Key &key, const T &value)
+        { insert(key, value, defaultTtl); }
+    void insert(const Key &key, const T &value, qint64 ttl);
+
+    bool contains(const Key &key);
+    const T value(const Key &key) { return value(key, T()); }
+    const T value(const Key &key, const T &defaultValue);
+    int remove(const Key &key);
+    T take(const Key &key);
+
+    // Resets the deadline of an entry as a write would, whatever the
+    // policy, and moves it to the end. Returns false if there is none.
+    bool touch(const Key &key);
+
+    // Milliseconds left before the entry expires, or -1 if there is none.
+    qint64 remainingTtl(const Key &key) const;
+
+    // Removes expired entries, and returns how many. The second form also
+    // calls sink(key, value) for each of them before it is removed.
+    inline int expire() { IgnoreExpired sink; return expire(sink); }
+    template <typename Sink>
+    int expire(Sink &sink);
+
+    // Milliseconds until the next sweep has something to do: 0 if it
+    // already has, and -1 if nothing is left to expire. This may err on
+    // the early side, never on the late one.
+    qint64 msecsToNextExpiry() const;
+
+    // Live entries only.
+    QList<Key> keys() const;
+    QList<T> values() const;
+
+    class const_iterator
+    {
+        friend class TtlOrderedHash;
+
+        typename Entries::const_iterator i;
+
+        explicit inline const_iterator(
+                const typename Entries::const_iterator &i) : i(i) {}
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef qptrdiff difference_type;
+        typedef T value_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        inline const_iterator() {}
+
+        inline const Key &key() const { return i.key(); }
+        inline const T &value() const { return i->value; }
+        inline qint64 deadline() const { return i->deadline; }
+        inline const T &operator*() const { return value(); }
+        inline const T *operator->() const { return &value(); }
+
+        inline bool operator==(const const_iterator &o) const
+            { return i == o.i; }
+        inline bool operator!=(const const_iterator &o) const
+            { return i != o.i; }
+
+        inline const_iterator &operator++() { ++i; return *this; }
+        inline const_iterator operator++(int)
+            { return const_iterator(i++); }
+        inline const_iterator &operator--() { --i; return *this; }
+        inline const_iterator operator--(int)
+            { return const_iterator(i--); }
+    };
+
+    // STL-style iteration, in expiry order for entries with the hash's
+    // own TTL.
+    inline const_iterator begin() const
+        { return const_iterator(entries.constBegin()); }
+    inline const_iterator end() const
+        { return const_iterator(entries.constEnd()); }
+    inline const_iterator constBegin() const
+        { return const_iterator(entries.constBegin()); }
+    inline const_iterator constEnd() const
+        { return const_iterator(entries.constEnd()); }
+
+private:
+    // Slots of the timer wheel. A slot spans ttl / WheelSlots milliseconds,
+    // so one turn of the wheel takes about one default TTL.
+    enum { WheelSlots = 256 };
+
+    Entries entries;
+    QVector<Record> queue;      // Records of entries with the default TTL.
+    int queueHead;              // First record not yet swept.
+    QVector<QVector<Record> > wheel;    // Records of the other entries.
+    int wheelCount;
+    qint64 wheelTick;           // Last tick swept for good.
+    qint64 resolution;          // Milliseconds per tick.
+    int customCount;            // Entries with their own TTL.
+    qint64 defaultTtl;
+    ExpiryPolicy policy;
+    Clock clock;
+
+    struct IgnoreExpired
+    {
+        inline void operator()(const Key &, const T &) const {}
+    };
+
+    inline qint64 tickOf(qint64 deadline) const
+        { return deadline / resolution; }
+
+    typename Entries::iterator find(const Key &key);
+    void erase(typename Entries::iterator it);
+    typename Entries::iterator restart(typename Entries::iterator it,
+                                       qint64 ttl);
+    void schedule(const Key &key, const Entry &entry);
+    typename Entries::iterator moveToEnd(typename Entries::iterator it);
+    bool isCurrent(const Record &record, bool custom);
+    void compactQueue();
+    void compactWheel();
+};
+
+template <typename Key, typename T, typename Hasher>
+TtlOrderedHash<Key, T, Hasher>::TtlOrderedHash(qint64 ttl,
+                                               ExpiryPolicy policy) :
+    queueHead(0), wheel(WheelSlots), wheelCount(0),
+    resolution(qMax(qint64(1), ttl / WheelSlots)), customCount(0),
+    defaultTtl(ttl), policy(policy), clock(&ttlOrderedHashClock)
+{
+    wheelTick = now() / resolution - 1;
+}
+
+template <typename Key, typename T, typename Hasher>
+void TtlOrderedHash<Key, T, Hasher>::setClock(Clock clock)
+{
+    this->clock = clock;
+    wheelTick = now() / resolution - 1;
+}
+
+template <typename Key, typename T, typename Hasher>
+void TtlOrderedHash<Key, T, Hasher>::clear()
+{
+    entries.clear();
+    queue.clear();
+    queueHead = 0;
+    wheel.fill(QVector<Record>());
+    wheelCount = 0;
+    customCount = 0;
+}
+
+template <typename Key, typename T, typename Hasher>
+void TtlOrderedHash<Key, T, Hasher>::insert(const Key &key, const T &value,
+                                            qint64 ttl)
+{
+    typename Entries::iterator it = find(key);
+    if (it == entries.end())
+    {
+        const bool custom = ttl != defaultTtl;
+        Entry entry(value, now() + ttl, ttl, custom);
+        if (custom)
+            customCount++;
+        entries.insert(key, entry);
+        schedule(key, entry);
+        return;
+    }
+    it->value = value;
+    if (policy != ExpireAfterInsert)
+        restart(it, ttl);
+}
+
+template <typename Key, typename T, typename Hasher>
+bool TtlOrderedHash<Key, T, Hasher>::contains(const Key &key)
+{
+    return find(key) != entries.end();
+}
+
+template <typename Key, typename T, typename Hasher>
+const T TtlOrderedHash<Key, T, Hasher>::value(const Key &key,
+                                              const T &defaultValue)
+{
+    typename Entries::iterator it = find(key);
+    if (it == entries.end())
+        return defaultValue;
+    if (policy == ExpireAfterAccess)
+        it = restart(it, it->ttl);
+    return it->value;
+}
+
+template <typename Key, typename T, typename Hasher>
+int TtlOrderedHash<Key, T, Hasher>::remove(const Key &key)
+{
+    typename Entries::iterator it = find(key);
+    if (it == entries.end())
+        return 0;
+    erase(it);
+    return 1;
+}
+
+template <typename Key, typename T, typename Hasher>
+T TtlOrderedHash<Key, T, Hasher>::take(const Key &key)
+{
+    typename Entries::iterator it = find(key);
+    if (it == entries.end())
+        return T();
+    T value = it->value;
+    erase(it);
+    return value;
+}
+
+template <typename Key, typename T, typename Hasher>
+bool TtlOrderedHash<Key, T, Hasher>::touch(const Key &key)
+{
+    typename Entries::iterator it = find(key);
+    if (it == entries.end())
+        return false;
+    restart(it, defaultTtl);
+    return true;
+}
+
+template <typename Key, typename T, typename Hasher>
+qint64 TtlOrderedHash<Key, T, Hasher>::remainingTtl(const Key &key) const
+{
+    typename Entries::const_iterator it = entries.constFind(key);
+    if (it == entries.constEnd())
+        return -1;
+    const qint64 left = it->deadline - now();
+    return left > 0 ? left : -1;
+}
+
+template <typename Key, typename T, typename Hasher>
+template <typename Sink>
+int TtlOrderedHash<Key, T, Hasher>::expire(Sink &sink)
+{
+    const qint64 t = now();
+    int removed = 0;
+
+    for (; queueHead < queue.size(); queueHead++)
+    {
+        const Record &record = queue.at(queueHead);
+        if (record.deadline > t)
+            break;
+        if (!isCurrent(record, false))
+            continue;
+        typename Entries::iterator it = entries.find(record.key);
+        sink(it.key(), it->value);
+        erase(it);
+        removed++;
+    }
+    compactQueue();
+
+    // Visit the slots whose ticks have begun since the last sweep, all of
+    // them at most once. Records not yet due, on a later turn of the wheel
+    // or later in the current tick, stay where they are.
+    const qint64 tick = t / resolution;
+    if (wheelCount)
+    {
+        qint64 first = wheelTick + 1;
+        if (tick - first >= WheelSlots)
+            first = tick - WheelSlots + 1;
+        for (qint64 k = first; k <= tick; k++)
+        {
+            QVector<Record> &slot = wheel[int(k & (WheelSlots - 1))];
+            int kept = 0;
+            for (int j = 0; j < slot.size(); j++)
+            {
+                if (slot.at(j).deadline > t)
+                {
+                    if (kept != j)
+                        slot[kept] = slot.at(j);
+                    kept++;
+                    continue;
+                }
+                if (isCurrent(slot.at(j), true))
+                {
+                    typename Entries::iterator it =
+                            entries.find(slot.at(j).key);
+                    sink(it.key(), it->value);
+                    erase(it);
+                    removed++;
+                }
+            }
+            wheelCount -= slot.size() - kept;
+            slot.resize(kept);
+        }
+    }
+    // The current tick is not over, so its slot is visited again next time.
+    wheelTick = tick - 1;
+    return removed;
+}
+
+template <typename Key, typename T, typename Hasher>
+qint64 TtlOrderedHash<Key, T, Hasher>::msecsToNextExpiry() const
+{
+    qint64 next = -1;
+    if (queueHead < queue.size())
+        next = queue.at(queueHead).deadline;
+    // Records in the slot of tick k are due no earlier than that tick, so
+    // the slots are scanned until none can beat the earliest found yet.
+    for (qint64 k = wheelTick + 1; wheelCount && k <= wheelTick + WheelSlots
+         && (next < 0 || k * resolution < next); k++)
+    {
+        const QVector<Record> &slot = wheel.at(int(k & (WheelSlots - 1)));
+        for (int j = 0; j < slot.size(); j++)
+        {
+            if (next < 0 || slot.at(j).deadline < next)
+                next = slot.at(j).deadline;
+        }
+    }
+    if (next < 0)
+        return -1;
+    return qMax(qint64(0), next - now());
+}
+
+template <typename Key, typename T, typename Hasher>
+QList<Key> TtlOrderedHash<Key, T, Hasher>::keys() const
+{
+    const qint64 t = now();
+    QList<Key> result;
+    result.reserve(entries.size());
+    typename Entries::const_iterator it = entries.constBegin();
+    for (; it != entries.constEnd(); ++it)
+    {
+        if (it->deadline > t)
+            result.append(it.key());
+    }
+    return result;
+}
+
+template <typename Key, typename T, typename Hasher>
+QList<T> TtlOrderedHash<Key, T, Hasher>::values() const
+{
+    const qint64 t = now();
+    QList<T> result;
+    result.reserve(entries.size());
+    typename Entries::const_iterator it = entries.constBegin();
+    for (; it != entries.constEnd(); ++it)
+    {
+        if (it->deadline > t)
+            result.append(it->value);
+    }
+    return result;
+}
+
+// Lazy expiry: an expired entry found by a lookup is removed there and then.
+template <typename Key, typename T, typename Hasher>
+typename TtlOrderedHash<Key, T, Hasher>::Entries::iterator
+TtlOrderedHash<Key, T, Hasher>::find(const Key &key)
+{
+    typename Entries::iterator it = entries.find(key);
+    if (it != entries.end() && it->deadline <= now())
+    {
+        erase(it);
+        return entries.end();
+    }
+    return it;
+}
+
+template <typename Key, typename T, typename Hasher>
+void TtlOrderedHash<Key, T, Hasher>::erase(typename Entries::iterator it)
+{
+    if (it->custom)
+        customCount--;
+    entries.erase(it);
+}
+
+// Gives the entry a new deadline, ttl from now, and moves it to the end. A
+// ttl equal to the hash's own puts the entry back in the queue.
+template <typename Key, typename T, typename Hasher>
+typename TtlOrderedHash<Key, T, Hasher>::Entries::iterator
+TtlOrderedHash<Key, T, Hasher>::restart(typename Entries::iterator it,
+                                        qint64 ttl)
+{
+    const bool custom = ttl != defaultTtl;
+    if (custom != it->custom)
+        customCount += custom ? 1 : -1;
+    it->custom = custom;
+    it->ttl = ttl;
+    it->deadline = now() + ttl;
+    it = moveToEnd(it);
+    schedule(it.key(), *it);
+    return it;
+}
+
+template <typename Key, typename T, typename Hasher>
+void TtlOrderedHash<Key, T, Hasher>::schedule(const Key &key,
+                                              const Entry &entry)
+{
+    if (!entry.custom)
+    {
+        queue.append(Record(key, entry.deadline));
+        // Stale records outnumbering live ones are dropped early, so
+        // memory stays bounded even if nothing ever sweeps.
+        if (queue.size() - queueHead > 2 * (entries.size() - customCount)
+                + 64)
+            compactQueue();
+        return;
+    }
+    const qint64 tick = qMax(tickOf(entry.deadline), wheelTick + 1);
+    wheel[int(tick & (WheelSlots - 1))].append(Record(key, entry.deadline));
+    wheelCount++;
+    if (wheelCount > 2 * customCount + 64)
+        compactWheel();
+}
+
+// Relinks the entry at the end of the hash without copying it. This has to
+// happen before the entry is scheduled, which may rebuild the queue from
+// the order of the hash.
+template <typename Key, typename T, typename Hasher>
+typename TtlOrderedHash<Key, T, Hasher>::Entries::iterator
+TtlOrderedHash<Key, T, Hasher>::moveToEnd(typename Entries::iterator it)
+{
+    typename Entries::Node node = entries.extract(it);
+    return entries.insert(node);
+}
+
+template <typename Key, typename T, typename Hasher>
+bool TtlOrderedHash<Key, T, Hasher>::isCurrent(const Record &record,
+                                               bool custom)
+{
+    typename Entries::const_iterator it = entries.constFind(record.key);
+    return it != entries.constEnd() && it->custom == custom
+            && it->deadline == record.deadline;
+}
+
+// Drops swept records, and stale ones too if they have piled up. Entries
+// with the default TTL are in deadline order in the hash, so the queue can
+// be rebuilt from it.
+template <typename Key, typename T, typename Hasher>
+void TtlOrderedHash<Key, T, Hasher>::compactQueue()
+{
+    const int live = entries.size() - customCount;
+    if (queue.size() - queueHead > 2 * live + 64)
+    {
+        queue.clear();
+        typename Entries::const_iterator it = entries.constBegin();
+        for (; it != entries.constEnd(); ++it)
+        {
+            if (!it->custom)
+                queue.append(Record(it.key(), it->deadline));
+        }
+        queueHead = 0;
+    }
+    else if (queueHead == queue.size())
+    {
+        queue.clear();
+        queueHead = 0;
+    }
+    else if (queueHead >= 64 && queueHead * 2 >= queue.size())
+    {
+        queue.remove(0, queueHead);
+        queueHead = 0;
+    }
+}
+
+template <typename Key, typename T, typename Hasher>
+void TtlOrderedHash<Key, T, Hasher>::compactWheel()
+{
+    wheel.fill(QVector<Record>());
+    wheelCount = 0;
+    typename Entries::const_iterator it = entries.constBegin();
+    for (; it != entries.constEnd(); ++it)
+    {
+        if (!it->custom)
+            continue;
+        const qint64 tick = qMax(tickOf(it->deadline), wheelTick + 1);
+        wheel[int(tick & (WheelSlots - 1))].append(
+                    Record(it.key(), it->deadline));
+        wheelCount++;
+    }
+}
+
+}   // namespace qtcollections
+
+template <typename T>
+class QTypeInfo<qtcollections::TtlOrderedHashEntry<T> > :
+        public qtcollections::TypeInfoMerger<
+            qtcollections::TtlOrderedHashEntry<T>, T>
+{};
+
+template <typename Key>
+class QTypeInfo<qtcollections::TtlOrderedHashRecord<Key> > :
+        public qtcollections::TypeInfoMerger<
+            qtcollections::TtlOrderedHashRecord<Key>, Key>
+{};
+
+#endif // QTCOLLECTIONS_TTLORDEREDHASH_H
@@ -0,0 +1,253 @@
+#include <iterator>
+#include "groupprobingtests.h"
+
+using qtcollections::GroupProbing;
+using qtcollections::OrderedHash;
+using qtcollections::OrderedHashGroup;
+using qtcollections::SipHashPolicy;
+
+typedef OrderedHash<QString, int, GroupProbing<> > StringHash;
+typedef OrderedHash<int, int, GroupProbing<> > IntHash;
+
+namespace
+{
+
+struct IsOdd
+{
+    inline bool operator()(const QString &, int value) const
+        { return value % 2; }
+};
+
+}   // namespace
+
+void GroupProbingTests::testGroupMatch()
+{
+    qint8 ctrl[OrderedHashGroup::Width];
+    for (int i = 0; i < OrderedHashGroup::Width; i++)
+        ctrl[i] = qint8(OrderedHashGroup::Empty);
+    ctrl[1] = 5;
+    ctrl[3] = qint8(OrderedHashGroup::Deleted);
+    ctrl[7] = 5;
+    ctrl[15] = 127;
+
+    QCOMPARE(OrderedHashGroup::match(ctrl, 5), OrderedHashGroup::Mask(0x82));
+    QCOMPARE(OrderedHashGroup::match(ctrl, 127),
+             OrderedHashGroup::Mask(0x8000));
+    QCOMPARE(OrderedHashGroup::match(ctrl, 0), OrderedHashGroup::Mask(0));
+
+    OrderedHashGroup::Mask full = 0x8082;
+    OrderedHashGroup::Mask all = OrderedHashGroup::Width == 32 ?
+                0xffffffffu : 0xffffu;
+    QCOMPARE(OrderedHashGroup::matchFree(ctrl), all & ~full);
+    QCOMPARE(OrderedHashGroup::matchEmpty(ctrl), all & ~full & ~0x8u);
+}
+
+void GroupProbingTests::testInsert()
+{
+    StringHash hash;
+    QCOMPARE(hash.insert("b", 1).value(), 1);
+    hash.insert("a", 2);
+    hash.insert("c", 3);
+    hash.insert("a", 4);
+    QCOMPARE(hash.size(), 3);
+    QCOMPARE(hash.keys(), QList<QString>() << "b" << "a" << "c");
+    QCOMPARE(hash.value("a"), 4);
+    QCOMPARE(hash.value("d", -1), -1);
+    QVERIFY(hash.contains("c"));
+    QVERIFY(!hash.contains("d"));
+}
+
+void GroupProbingTests::testRemove()
+{
+    StringHash hash;
+    hash.insert("a", 1);
+    hash.insert("b", 2);
+    hash.insert("c", 3);
+    QCOMPARE(hash.remove("b"), 1);
+    QCOMPARE(hash.remove("b"), 0);
+    QVERIFY(!hash.contains("b"));
+    QCOMPARE(hash.take("a"), 1);
+    QCOMPARE(hash.keys(), QList<QString>() << "c");
+
+    hash.insert("b", 4);
+    QCOMPARE(hash.keys(), QList<QString>() << "c" << "b");
+    hash.clear();
+    QVERIFY(hash.isEmpty());
+    QVERIFY(!hash.contains("c"));
+}
+
+void GroupProbingTests::testIteration()
+{
+    StringHash hash;
+    for (int i = 0; i < 10; i++)
+        hash.insert(QString::number(i), i);
+    hash.remove("0");
+    hash.remove("5");
+    hash.remove("9");
+
+    QList<int> values;
+    for (StringHash::const_iterator it = hash.constBegin();
+         it != hash.constEnd(); ++it)
+        values.append(it.value());
+    QCOMPARE(values, QList<int>() << 1 << 2 << 3 << 4 << 6 << 7 << 8);
+
+    StringHash::const_iterator it = hash.constEnd();
+    --it;
+    QCOMPARE(it.key(), QString("8"));
+    QCOMPARE(hash.firstKey(), QString("1"));
+}
+
+void GroupProbingTests::testGrowth()
+{
+    StringHash hash;
+    for (int i = 0; i < 100000; i++)
+        hash.insert(QString::number(i), i);
+    QCOMPARE(hash.size(), 100000);
+    for (int i = 0; i < 100000; i++)
+        QCOMPARE(hash.value(QString::number(i), -1), i);
+    for (int i = 100000; i < 101000; i++)
+        QVERIFY(!hash.contains(QString::number(i)));
+    QCOMPARE(hash.firstKey(), QString("0"));
+    QCOMPARE(hash.lastKey(), QString("99999"));
+}
+
+void GroupProbingTests::testTombstones()
+{
+    // A small live set over many distinct keys leaves tombstones behind,
+    // which must be cleaned up without the index growing without bound.
+    StringHash hash;
+    for (int i = 0; i < 50000; i++)
+    {
+        hash.insert(QString::number(i), i);
+        if (i >= 20)
+            hash.remove(QString::number(i - 20));
+    }
+    QCOMPARE(hash.size(), 20);
+    QCOMPARE(hash.firstKey(), QString("49980"));
+    for (int i = 0; i < 49980; i += 97)
+        QVERIFY(!hash.contains(QString::number(i)));
+    for (int i = 49980; i < 50000; i++)
+        QCOMPARE(hash.value(QString::number(i)), i);
+}
+
+void GroupProbingTests::testRemoveIf()
+{
+    StringHash hash;
+    for (int i = 0; i < 1000; i++)
+        hash.insert(QString::number(i), i);
+    QCOMPARE(hash.removeIf(IsOdd()), 500);
+    QCOMPARE(hash.size(), 500);
+    for (int i = 0; i < 1000; i++)
+        QCOMPARE(hash.contains(QString::number(i)), i % 2 == 0);
+    QCOMPARE(hash.lastKey(), QString("998"));
+
+    hash.insert("x", 1);
+    QCOMPARE(hash.lastKey(), QString("x"));
+}
+
+void GroupProbingTests::testEraseRange()
+{
+    StringHash hash;
+    for (int i = 0; i < 100; i++)
+        hash.insert(QString::number(i), i);
+    QCOMPARE(hash.erase(hash.begin() + 10, hash.begin() + 90), 80);
+    QCOMPARE(hash.size(), 20);
+    QVERIFY(hash.contains("9"));
+    QVERIFY(!hash.contains("10"));
+    QVERIFY(!hash.contains("89"));
+    QVERIFY(hash.contains("90"));
+}
+
+void GroupProbingTests::testIntegralKeys()
+{
+    IntHash hash;
+    for (int i = 0; i < 10000; i++)
+        hash.insert(i << 16, i);
+    hash.insert(std::numeric_limits<int>::max(), -1);
+    QCOMPARE(hash.size(), 10001);
+    for (int i = 0; i < 10000; i++)
+        QCOMPARE(hash.value(i << 16), i);
+    QCOMPARE(hash.value(std::numeric_limits<int>::max()), -1);
+    QVERIFY(!hash.contains(1));
+}
+
+void GroupProbingTests::testSeededPolicy()
+{
+    OrderedHash<QString, int, GroupProbing<SipHashPolicy> > hash(
+                SipHashPolicy(1, 2));
+    QCOMPARE(hash.hashPolicy().k0, Q_UINT64_C(1));
+    for (int i = 0; i < 1000; i++)
+        hash.insert(QString::number(i), i);
+    for (int i = 0; i < 1000; i += 2)
+        hash.remove(QString::number(i));
+    QCOMPARE(hash.size(), 500);
+    QCOMPARE(hash.value("501"), 501);
+    QVERIFY(!hash.contains("500"));
+}
+
+void GroupProbingTests::testCopy()
+{
+    StringHash hash;
+    for (int i = 0; i < 100; i++)
+        hash.insert(QString::number(i), i);
+    StringHash copy(hash);
+    copy.remove("50");
+    copy.insert("x", 0);
+    QVERIFY(hash.contains("50"));
+    QVERIFY(!hash.contains("x"));
+    QCOMPARE(copy.size(), 100);
+    QCOMPARE(copy.lastKey(), QString("x"));
+
+    hash = copy;
+    QVERIFY(hash == copy);
+}
+
+void GroupProbingTests::testBatchLookup()
+{
+    StringHash hash;
+    for (int i = 0; i < 500; i++)
+        hash.insert(QString::number(i), i);
+    for (int i = 0; i < 500; i += 5)
+        hash.remove(QString::number(i));
+
+    QStringList keys;
+    for (int i = 0; i < 600; i += 3)
+        keys << QString::number(i);
+    QList<int> values;
+    QList<bool> found;
+    hash.valuesFor(keys, std::back_inserter(values), -1);
+    hash.containsMany(keys, std::back_inserter(found));
+    QCOMPARE(values.size(), keys.size());
+    for (int i = 0; i < keys.size(); i++)
+    {
+        QCOMPARE(values.at(i), hash.value(keys.at(i), -1));
+        QCOMPARE(found.at(i), hash.contains(keys.at(i)));
+    }
+}
+
+void GroupProbingTests::testNodes()
+{
+    StringHash pending;
+    StringHash active;
+    for (int i = 0; i < 100; i++)
+        pending.insert(QString::number(i), i);
+
+    StringHash::Node node = pending.extract("50");
+    QCOMPARE(node.value(), 50);
+    QVERIFY(!pending.contains("50"));
+    active.insert(node);
+    QVERIFY(node.isEmpty());
+    QCOMPARE(active.value("50"), 50);
+
+    node = pending.extract("10");
+    active.insert(node, active.begin());
+    QCOMPARE(active.keys(), QList<QString>() << "10" << "50");
+
+    QCOMPARE(active.merge(pending), 98);
+    QVERIFY(pending.isEmpty());
+    QCOMPARE(active.size(), 100);
+    QCOMPARE(active.firstKey(), QString("10"));
+    QCOMPARE(active.lastKey(), QString("99"));
+    for (int i = 0; i < 100; i++)
+        QCOMPARE(active.value(QString::number(i)), i);
+}
@@ -0,0 +1,28 @@
+#ifndef GROUPPROBINGTESTS_H
+#define GROUPPROBINGTESTS_H
+
+#include <QtTest>
+#include "groupprobing.h"
+
+class GroupProbingTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testGroupMatch();
+
+    void testInsert();
+    void testRemove();
+    void testIteration();
+    void testGrowth();
+    void testTombstones();
+    void testRemoveIf();
+    void testEraseRange();
+    void testIntegralKeys();
+    void testSeededPolicy();
+    void testCopy();
+    void testBatchLookup();
+    void testNodes();
+};
+
+#endif  // GROUPPROBINGTESTS_H
@@ -0,0 +1,203 @@
+#include "hashpolicytests.h"
+#include "orderedhash.h"
+
+using qtcollections::FastHashPolicy;
+using qtcollections::OrderedHash;
+using qtcollections::SipHashPolicy;
+
+namespace
+{
+
+struct Point
+{
+    int x;
+    int y;
+
+    inline bool operator==(const Point &o) const
+        { return x == o.x && y == o.y; }
+};
+
+inline uint qHash(const Point &p, uint seed = 0)
+{
+    return ::qHash(p.x, seed) * 31 + ::qHash(p.y, seed);
+}
+
+// Counts comparisons, to tell which keys a lookup compared.
+struct Counted
+{
+    int id;
+    static int compares;
+
+    inline bool operator==(const Counted &o) const
+        { compares++; return id == o.id; }
+};
+
+int Counted::compares = 0;
+
+// Hashes every key to the same 32 bits once folded, and distinct 64.
+struct FoldingPolicy
+{
+    inline quint64 operator()(const Counted &key) const
+        { return quint64(key.id) << 32 | quint64(key.id); }
+};
+
+}   // namespace
+
+void HashPolicyTests::testSipHashVectors()
+{
+    // From the SipHash paper, for SipHash-2-4 with key 00..0f.
+    uchar bytes[16];
+    for (int i = 0; i < 16; i++)
+        bytes[i] = uchar(i);
+    const quint64 k0 = Q_UINT64_C(0x0706050403020100);
+    const quint64 k1 = Q_UINT64_C(0x0f0e0d0c0b0a0908);
+    using qtcollections::hashpolicy::sipHash;
+    quint64 empty = sipHash<2, 4>(bytes, 0, k0, k1);
+    quint64 fifteen = sipHash<2, 4>(bytes, 15, k0, k1);
+    QCOMPARE(empty, Q_UINT64_C(0x726fdb47dd0e0e31));
+    QCOMPARE(fifteen, Q_UINT64_C(0xa129ca6149be45e5));
+}
+
+void HashPolicyTests::testSeeds()
+{
+    const QByteArray key = "some key";
+    QCOMPARE(FastHashPolicy(1)(key), FastHashPolicy(1)(key));
+    QVERIFY(FastHashPolicy(1)(key) != FastHashPolicy(2)(key));
+    QCOMPARE(SipHashPolicy(1, 2)(key), SipHashPolicy(1, 2)(key));
+    QVERIFY(SipHashPolicy(1, 2)(key) != SipHashPolicy(2, 1)(key));
+
+    // Lengths around each of the fast hash's code paths.
+    FastHashPolicy fast(7);
+    QSet<quint64> hashes;
+    for (int size = 0; size <= 100; size++)
+        hashes.insert(fast(QByteArray(size, 'x')));
+    QCOMPARE(hashes.size(), 101);
+}
+
+void HashPolicyTests::testInstanceSeeds()
+{
+    FastHashPolicy a, b;
+    QVERIFY(a.seed() != b.seed());
+    SipHashPolicy c, d;
+    QVERIFY(c.k0 != d.k0 || c.k1 != d.k1);
+
+    OrderedHash<QString, int, FastHashPolicy> x, y;
+    QVERIFY(x.hashPolicy().seed() != y.hashPolicy().seed());
+}
+
+void HashPolicyTests::testKeyTypes()
+{
+    FastHashPolicy fast(3);
+    QCOMPARE(fast(QString("abc")), fast(QString("abc")));
+    QVERIFY(fast(QString("abc")) != fast(QString("abd")));
+    QVERIFY(fast(1) != fast(2));
+    QVERIFY(fast(qint64(1)) != fast(qint64(1) << 32));
+
+    Point p = { 1, 2 };
+    Point q = { 2, 1 };
+    QCOMPARE(fast(p), fast(p));
+    QVERIFY(fast(p) != fast(q));
+
+    OrderedHash<Point, int, SipHashPolicy> hash;
+    hash.insert(p, 1);
+    hash.insert(q, 2);
+    QCOMPARE(hash.value(p), 1);
+    QCOMPARE(hash.value(q), 2);
+}
+
+void HashPolicyTests::testFoldedCollisions()
+{
+    // The node engine's QHashes see one bucket for all of these keys, but
+    // the full stored hashes keep them from being compared with each other.
+    OrderedHash<Counted, int, FoldingPolicy> hash;
+    for (int i = 1; i <= 100; i++)
+    {
+        Counted key = { i };
+        hash.insert(key, i);
+    }
+    Counted::compares = 0;
+    for (int i = 1; i <= 100; i++)
+    {
+        Counted key = { i };
+        QCOMPARE(hash.value(key), i);
+    }
+    QVERIFY(Counted::compares <= 2 * 100);
+}
+
+void HashPolicyTests::testStringKeys()
+{
+    OrderedHash<QString, int, FastHashPolicy> hash;
+    for (int i = 0; i < 1000; i++)
+        hash.insert(QString::number(999 - i), i);
+    QCOMPARE(hash.size(), 1000);
+    QCOMPARE(hash.firstKey(), QString("999"));
+    QCOMPARE(hash.lastKey(), QString("0"));
+    QCOMPARE(hash.value("500"), 499);
+
+    QCOMPARE(hash.remove("500"), 1);
+    QCOMPARE(hash.remove("500"), 0);
+    QVERIFY(!hash.contains("500"));
+    hash.insert("500", -1);
+    QCOMPARE(hash.lastKey(), QString("500"));
+    QCOMPARE(hash.size(), 1000);
+}
+
+void HashPolicyTests::testIntegralKeys()
+{
+    // Keys qHash() maps to the same low bits.
+    OrderedHash<int, int, SipHashPolicy> hash(SipHashPolicy(1, 2));
+    for (int i = 0; i < 1000; i++)
+        hash.insert(i << 16, i);
+    QCOMPARE(hash.size(), 1000);
+    for (int i = 0; i < 1000; i++)
+        QCOMPARE(hash.value(i << 16, -1), i);
+    QVERIFY(!hash.contains(1));
+
+    for (int i = 0; i < 1000; i += 2)
+        hash.remove(i << 16);
+    QCOMPARE(hash.size(), 500);
+    QCOMPARE(hash.firstKey(), 1 << 16);
+    QCOMPARE(hash.value(999 << 16), 999);
+}
+
+void HashPolicyTests::testIncrementalResize()
+{
+    OrderedHash<QString, int, SipHashPolicy> hash;
+    hash.setIncrementalResize(true);
+    for (int i = 0; i < 5000; i++)
+        hash.insert(QString::number(i), i);
+    for (int i = 0; i < 5000; i += 3)
+        hash.remove(QString::number(i));
+    hash.setIncrementalResize(false);
+
+    int expected = 1;
+    for (OrderedHash<QString, int, SipHashPolicy>::const_iterator it =
+            hash.constBegin(); it != hash.constEnd(); ++it)
+    {
+        if (expected % 3 == 0)
+            expected++;
+        QCOMPARE(it.value(), expected);
+        QCOMPARE(hash.value(it.key()), expected);
+        expected++;
+    }
+    QCOMPARE(expected, 5000);
+}
+
+void HashPolicyTests::testCopyKeepsPolicy()
+{
+    OrderedHash<QString, int, FastHashPolicy> hash(FastHashPolicy(42));
+    hash.insert("a", 1);
+    hash.insert("b", 2);
+
+    OrderedHash<QString, int, FastHashPolicy> copy(hash);
+    QCOMPARE(copy.hashPolicy().seed(), Q_UINT64_C(42));
+    QCOMPARE(copy.value("b"), 2);
+
+    OrderedHash<QString, int, FastHashPolicy> other;
+    other = hash;
+    QCOMPARE(other.hashPolicy().seed(), Q_UINT64_C(42));
+    QVERIFY(other == hash);
+
+    hash.clear();
+    QCOMPARE(hash.hashPolicy().seed(), Q_UINT64_C(42));
+}
@@ -0,0 +1,24 @@
+#ifndef HASHPOLICYTESTS_H
+#define HASHPOLICYTESTS_H
+
+#include <QtTest>
+#include "hashpolicy.h"
+
+class HashPolicyTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSipHashVectors();
+    void testSeeds();
+    void testInstanceSeeds();
+    void testKeyTypes();
+    void testFoldedCollisions();
+
+    void testStringKeys();
+    void testIntegralKeys();
+    void testIncrementalResize();
+    void testCopyKeepsPolicy();
+};
+
+#endif  // HASHPOLICYTESTS_H
@@ -0,0 +1,162 @@
+#include "immutableorderedhashtests.h"
+
+typedef qtcollections::ImmutableOrderedHash<QString, int> Hash;
+
+namespace
+{
+
+struct Colliding
+{
+    int value;
+    bool operator==(const Colliding &o) const { return value == o.value; }
+};
+
+uint qHash(const Colliding &key, uint seed = 0)
+{
+    return uint(key.value % 2) ^ seed;
+}
+
+}   // namespace
+
+void ImmutableOrderedHashTests::testDefaultConstructor()
+{
+    Hash hash;
+    QVERIFY(hash.isEmpty());
+    QCOMPARE(hash.size(), 0);
+    QVERIFY(hash.constBegin() == hash.constEnd());
+}
+
+void ImmutableOrderedHashTests::testInitializerListConstructor()
+{
+    Hash hash({{"b", 1}, {"a", 2}});
+    QCOMPARE(hash.keys(), QList<QString>() << "b" << "a");
+    QCOMPARE(hash.values(), QList<int>() << 1 << 2);
+}
+
+void ImmutableOrderedHashTests::testOrderedHashConversion()
+{
+    qtcollections::OrderedHash<QString, int> ordered({{"b", 1}, {"a", 2}});
+    Hash hash(ordered);
+    QCOMPARE(hash, Hash({{"b", 1}, {"a", 2}}));
+    QCOMPARE(hash.toOrderedHash(), ordered);
+}
+
+void ImmutableOrderedHashTests::testEqualityOperator()
+{
+    Hash hash({{"b", 1}, {"a", 2}});
+    QVERIFY(hash == Hash({{"b", 1}, {"a", 2}}));
+    QVERIFY(hash != Hash({{"a", 2}, {"b", 1}}));
+    QVERIFY(hash != Hash({{"b", 1}, {"a", 3}}));
+}
+
+void ImmutableOrderedHashTests::testInserted()
+{
+    Hash empty;
+    Hash one = empty.inserted("one", 1);
+    Hash two = one.inserted("two", 2);
+
+    QVERIFY(empty.isEmpty());
+    QCOMPARE(one.keys(), QList<QString>() << "one");
+    QCOMPARE(two.keys(), QList<QString>() << "one" << "two");
+}
+
+void ImmutableOrderedHashTests::testInsertedExisting()
+{
+    Hash hash({{"b", 1}, {"a", 2}});
+    Hash inserted = hash.inserted("b", 3);
+
+    QCOMPARE(inserted.keys(), QList<QString>() << "b" << "a");
+    QCOMPARE(inserted.value("b"), 3);
+    QCOMPARE(hash.value("b"), 1);
+}
+
+void ImmutableOrderedHashTests::testUpdated()
+{
+    Hash hash({{"b", 1}, {"a", 2}});
+
+    QCOMPARE(hash.updated("a", 3).values(), QList<int>() << 1 << 3);
+    QCOMPARE(hash.updated("c", 3), hash);
+}
+
+void ImmutableOrderedHashTests::testRemoved()
+{
+    Hash hash({{"c", 1}, {"b", 2}, {"a", 3}});
+    Hash removed = hash.removed("b");
+
+    QCOMPARE(removed.keys(), QList<QString>() << "c" << "a");
+    QCOMPARE(removed.size(), 2);
+    QVERIFY(!removed.contains("b"));
+    QCOMPARE(hash.size(), 3);
+    QCOMPARE(hash.removed("d"), hash);
+
+    Hash reinserted = removed.inserted("b", 4);
+    QCOMPARE(reinserted.keys(), QList<QString>() << "c" << "a" << "b");
+}
+
+void ImmutableOrderedHashTests::testVersionsAreIndependent()
+{
+    QList<Hash> versions;
+    versions.append(Hash());
+    for (int i = 0; i < 100; i++)
+    {
+        Hash next = versions.last().inserted(QString::number(i % 10), i);
+        versions.append(i % 3 ? next : next.removed(QString::number(i % 7)));
+    }
+
+    Hash replayed;
+    for (int i = 0; i < 100; i++)
+    {
+        replayed = replayed.inserted(QString::number(i % 10), i);
+        if (i % 3 == 0)
+            replayed = replayed.removed(QString::number(i % 7));
+        QCOMPARE(versions.at(i + 1), replayed);
+    }
+}
+
+void ImmutableOrderedHashTests::testValue()
+{
+    Hash hash({{"b", 1}});
+    QCOMPARE(hash.value("b"), 1);
+    QCOMPARE(hash.value("a"), 0);
+    QCOMPARE(hash.value("a", -1), -1);
+}
+
+void ImmutableOrderedHashTests::testFirstAndLast()
+{
+    Hash hash({{"c", 1}, {"b", 2}, {"a", 3}});
+    QCOMPARE(hash.firstKey(), QString("c"));
+    QCOMPARE(hash.lastKey(), QString("a"));
+    QCOMPARE(hash.first(), 1);
+    QCOMPARE(hash.last(), 3);
+}
+
+void ImmutableOrderedHashTests::testManyEntries()
+{
+    qtcollections::ImmutableOrderedHash<int, int> hash;
+    for (int i = 0; i < 5000; i++)
+        hash = hash.inserted(i * 7919 % 5000, i);
+    for (int i = 0; i < 5000; i += 2)
+        hash = hash.removed(i * 7919 % 5000);
+
+    QCOMPARE(hash.size(), 2500);
+    int expected = 1;
+    for (auto it = hash.constBegin(); it != hash.constEnd(); ++it)
+    {
+        QCOMPARE(it.key(), expected * 7919 % 5000);
+        QCOMPARE(it.value(), expected);
+        expected += 2;
+    }
+}
+
+void ImmutableOrderedHashTests::testHashCollisions()
+{
+    qtcollections::ImmutableOrderedHash<Colliding, int> hash;
+    for (int i = 0; i < 10; i++)
+        hash = hash.inserted(Colliding{i}, i);
+    hash = hash.removed(Colliding{4}).removed(Colliding{5});
+
+    QCOMPARE(hash.size(), 8);
+    QCOMPARE(hash.value(Colliding{6}), 6);
+    QVERIFY(!hash.contains(Colliding{4}));
+    QCOMPARE(hash.lastKey().value, 9);
+}
@@ -0,0 +1,29 @@
+#ifndef IMMUTABLEORDEREDHASHTESTS_H
+#define IMMUTABLEORDEREDHASHTESTS_H
+
+#include <QtTest>
+#include "immutableorderedhash.h"
+
+class ImmutableOrderedHashTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDefaultConstructor();
+    void testInitializerListConstructor();
+    void testOrderedHashConversion();
+    void testEqualityOperator();
+
+    void testInserted();
+    void testInsertedExisting();
+    void testUpdated();
+    void testRemoved();
+    void testVersionsAreIndependent();
+
+    void testValue();
+    void testFirstAndLast();
+    void testManyEntries();
+    void testHashCollisions();
+};
+
+#endif  // IMMUTABLEORDEREDHASHTESTS_H
@@ -0,0 +1,82 @@
+#include "internedstringtests.h"
+
+using qtcollections::InternedString;
+using qtcollections::InternedStringPool;
+
+void InternedStringTests::testEquality()
+{
+    QString name = QString("na") + QString("me");
+    QCOMPARE(InternedString(name), InternedString("name"));
+    QVERIFY(InternedString("name") != InternedString("value"));
+}
+
+void InternedStringTests::testEmpty()
+{
+    QVERIFY(InternedString().isEmpty());
+    QVERIFY(InternedString("").isEmpty());
+    QCOMPARE(InternedString(QString()), InternedString(""));
+    QVERIFY(!InternedString("name").isEmpty());
+}
+
+void InternedStringTests::testHash()
+{
+    QCOMPARE(InternedString("name").hash(), qHash(QString("name")));
+    QCOMPARE(qHash(InternedString("name"), 42), qHash(QString("name")) ^ 42);
+}
+
+void InternedStringTests::testToString()
+{
+    QCOMPARE(InternedString("name").toString(), QString("name"));
+    QCOMPARE(InternedString().toString(), QString());
+}
+
+void InternedStringTests::testPoolSharing()
+{
+    InternedString("shared");
+    int size = InternedStringPool::instance()->size();
+    for (int i = 0; i < 10; i++)
+        InternedString(QString("sha") + QString("red"));
+    QCOMPARE(InternedStringPool::instance()->size(), size);
+}
+
+void InternedStringTests::testOrderedHashKeys()
+{
+    qtcollections::InternedOrderedHash<int> record;
+    record.insert(InternedString("id"), 1);
+    record.insert(InternedString("name"), 2);
+    record.insert(InternedString(QString("id")), 3);
+
+    QCOMPARE(record.size(), 2);
+    QCOMPARE(record.value(InternedString::find("id")), 3);
+    QCOMPARE(record.firstKey().toString(), QString("id"));
+    QCOMPARE(record.lastKey(), InternedString("name"));
+}
+
+void InternedStringTests::testFind()
+{
+    QCOMPARE(InternedString::find("name"), InternedString("name"));
+    QCOMPARE(InternedString::find(""), InternedString(""));
+
+    int size = InternedStringPool::instance()->size();
+    InternedString missing = InternedString::find("never interned");
+    QVERIFY(missing.isNull());
+    QVERIFY(missing != InternedString(""));
+    QCOMPARE(InternedStringPool::instance()->size(), size);
+}
+
+void InternedStringTests::testMissedLookup()
+{
+    qtcollections::InternedOrderedHash<int> record;
+    record.insert(InternedString("id"), 1);
+    record.insert(InternedString(""), 2);
+    int size = InternedStringPool::instance()->size();
+
+    for (int i = 0; i < 100; i++)
+    {
+        const QString field = QString("unknown field %1").arg(i);
+        QVERIFY(!record.contains(InternedString::find(field)));
+        QCOMPARE(record.value(InternedString::find(field), -1), -1);
+    }
+    QCOMPARE(record.value(InternedString::find("id")), 1);
+    QCOMPARE(InternedStringPool::instance()->size(), size);
+}
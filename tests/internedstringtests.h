@@ -0,0 +1,23 @@
+#ifndef INTERNEDSTRINGTESTS_H
+#define INTERNEDSTRINGTESTS_H
+
+#include <QtTest>
+#include "internedstring.h"
+
+class InternedStringTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testEquality();
+    void testEmpty();
+    void testHash();
+    void testToString();
+    void testPoolSharing();
+    void testFind();
+
+    void testOrderedHashKeys();
+    void testMissedLookup();
+};
+
+#endif  // INTERNEDSTRINGTESTS_H
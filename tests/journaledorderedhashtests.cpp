@@ -0,0 +1,304 @@
+#include "journaledorderedhashtests.h"
+
+typedef qtcollections::JournaledOrderedHash<QString, int> Journaled;
+typedef Journaled::Delta Delta;
+typedef Journaled::Change Change;
+
+namespace
+{
+
+bool sameEntries(const Journaled &a, const Journaled &b)
+{
+    return a.hash().keys() == b.hash().keys()
+            && a.hash().values() == b.hash().values();
+}
+
+}   // namespace
+
+void JournaledOrderedHashTests::testVersions()
+{
+    Journaled hash;
+    QCOMPARE(hash.version(), qint64(0));
+    hash.insert("a", 1);
+    hash.insert("b", 2);
+    hash.insert("a", 3);
+    QCOMPARE(hash.version(), qint64(3));
+
+    // Nothing to change, nothing journaled.
+    QCOMPARE(hash.remove("c"), 0);
+    QCOMPARE(hash.take("c"), 0);
+    hash.moveToEnd("b");
+    hash.move("a", "b");
+    hash.move("a", "a");
+    QCOMPARE(hash.version(), qint64(3));
+    QCOMPARE(hash.journalSize(), 3);
+
+    QCOMPARE(hash.take("a"), 3);
+    hash.clear();
+    hash.clear();
+    QCOMPARE(hash.version(), qint64(5));
+    QVERIFY(hash.isEmpty());
+}
+
+void JournaledOrderedHashTests::testChangesSince()
+{
+    Journaled source;
+    Journaled replica;
+    for (int i = 0; i < 5; i++)
+        source.insert(QString::number(i), i);
+    QVERIFY(replica.applyChanges(source.changesSince(replica.version())));
+    QVERIFY(sameEntries(source, replica));
+
+    source.insert("1", 10);
+    source.remove("3");
+    Delta delta = source.changesSince(replica.version());
+    QVERIFY(!delta.isSnapshot());
+    QCOMPARE(delta.from, qint64(5));
+    QCOMPARE(delta.to, qint64(7));
+    QCOMPARE(delta.changes.size(), 2);
+    QCOMPARE(int(delta.changes.at(0).type), int(Change::Update));
+    QCOMPARE(delta.changes.at(0).value, 10);
+    QCOMPARE(int(delta.changes.at(1).type), int(Change::Remove));
+    QCOMPARE(delta.changes.at(1).key, QString("3"));
+
+    QVERIFY(replica.applyChanges(delta));
+    QCOMPARE(replica.version(), source.version());
+    QVERIFY(sameEntries(source, replica));
+
+    delta = source.changesSince(source.version());
+    QVERIFY(delta.isEmpty());
+    QVERIFY(replica.applyChanges(delta));
+    QCOMPARE(replica.version(), qint64(7));
+}
+
+void JournaledOrderedHashTests::testMoves()
+{
+    Journaled source;
+    Journaled replica;
+    source.insert("a", 1);
+    source.insert("b", 2);
+    source.insert("c", 3);
+    source.insert("d", 4);
+    replica.applyChanges(source.changesSince(replica.version()));
+
+    source.moveToEnd("a");
+    source.move("d", "b");
+    source.move("c", "e");
+    QCOMPARE(source.hash().keys(),
+             QList<QString>() << "d" << "b" << "a" << "c");
+
+    Delta delta = source.changesSince(replica.version());
+    QCOMPARE(delta.changes.size(), 3);
+    QCOMPARE(int(delta.changes.at(1).type), int(Change::MoveBefore));
+    QCOMPARE(delta.changes.at(1).before, QString("b"));
+    QCOMPARE(int(delta.changes.at(2).type), int(Change::MoveToEnd));
+    QVERIFY(replica.applyChanges(delta));
+    QVERIFY(sameEntries(source, replica));
+}
+
+void JournaledOrderedHashTests::testJournalOverflow()
+{
+    Journaled source(4);
+    Journaled replica;
+    for (int i = 0; i < 20; i++)
+        source.insert(QString::number(i), i);
+    replica.applyChanges(source.changesSince(replica.version()));
+
+    for (int i = 0; i < 4; i++)
+        source.insert(QString::number(i), -i);
+    QCOMPARE(source.journalSize(), 4);
+    QVERIFY(!source.changesSince(20).isSnapshot());
+
+    source.remove("19");
+    Delta delta = source.changesSince(replica.version());
+    QVERIFY(delta.isSnapshot());
+    QCOMPARE(delta.to, qint64(25));
+    QCOMPARE(delta.changes.size(), 20);
+    QCOMPARE(int(delta.changes.first().type), int(Change::Clear));
+
+    // Snapshots apply to replicas of any version.
+    replica.insert("x", 0);
+    QVERIFY(replica.applyChanges(delta));
+    QCOMPARE(replica.version(), qint64(25));
+    QCOMPARE(replica.journalSize(), 0);
+    QVERIFY(sameEntries(source, replica));
+}
+
+void JournaledOrderedHashTests::testSnapshotWhenSmaller()
+{
+    Journaled source;
+    source.insert("a", 0);
+    for (int i = 1; i <= 10; i++)
+        source.insert("a", i);
+    QCOMPARE(source.changesSince(9).changes.size(), 2);
+    Delta delta = source.changesSince(8);
+    QVERIFY(delta.isSnapshot());
+    QCOMPARE(delta.changes.size(), 2);
+    QCOMPARE(delta.changes.last().value, 10);
+
+    // A version this hash never had.
+    QVERIFY(source.changesSince(12).isSnapshot());
+    QVERIFY(source.changesSince(-1).isSnapshot());
+}
+
+void JournaledOrderedHashTests::testSetJournalCapacity()
+{
+    Journaled source(8);
+    for (int i = 0; i < 20; i++)
+        source.insert(QString::number(i), i);
+    source.setJournalCapacity(3);
+    QCOMPARE(source.journalSize(), 3);
+    QVERIFY(!source.changesSince(17).isSnapshot());
+    QVERIFY(source.changesSince(16).isSnapshot());
+
+    source.setJournalCapacity(6);
+    source.insert("20", 20);
+    source.insert("21", 21);
+    QCOMPARE(source.journalSize(), 5);
+    Delta delta = source.changesSince(17);
+    QCOMPARE(delta.changes.size(), 5);
+    QCOMPARE(delta.changes.first().key, QString("17"));
+    QCOMPARE(delta.changes.last().key, QString("21"));
+
+    source.setJournalCapacity(0);
+    source.insert("22", 22);
+    QCOMPARE(source.journalSize(), 0);
+    QVERIFY(source.changesSince(22).isSnapshot());
+    QVERIFY(source.changesSince(23).isEmpty());
+}
+
+void JournaledOrderedHashTests::testApplyOutOfOrder()
+{
+    Journaled source;
+    Journaled replica;
+    source.insert("a", 1);
+    Delta first = source.changesSince(0);
+    source.insert("b", 2);
+    Delta second = source.changesSince(1);
+
+    QVERIFY(!replica.applyChanges(second));
+    QVERIFY(replica.isEmpty());
+    QCOMPARE(replica.version(), qint64(0));
+
+    QVERIFY(replica.applyChanges(first));
+    QVERIFY(!replica.applyChanges(first));
+    QVERIFY(replica.applyChanges(second));
+    QVERIFY(sameEntries(source, replica));
+}
+
+void JournaledOrderedHashTests::testRelay()
+{
+    Journaled source(4);
+    Journaled relay;
+    Journaled replica;
+    for (int i = 0; i < 10; i++)
+        source.insert(QString::number(i), i);
+    relay.applyChanges(source.changesSince(relay.version()));
+
+    source.remove("5");
+    source.move("9", "0");
+    relay.applyChanges(source.changesSince(relay.version()));
+
+    // The relay only has a snapshot of the first ten changes, but journals
+    // the two after it.
+    QVERIFY(relay.changesSince(0).isSnapshot());
+    QCOMPARE(relay.changesSince(10).changes.size(), 2);
+    replica.applyChanges(relay.changesSince(replica.version()));
+    QCOMPARE(replica.version(), qint64(12));
+    QVERIFY(sameEntries(source, replica));
+}
+
+void JournaledOrderedHashTests::testStream()
+{
+    Journaled source;
+    Journaled replica;
+    source.insert("a", 1);
+    source.insert("b", 2);
+    source.insert("c", 3);
+    source.insert("d", 4);
+    source.insert("e", 5);
+    replica.applyChanges(source.changesSince(replica.version()));
+    source.insert("a", 6);
+    source.move("c", "a");
+    source.moveToEnd("a");
+    source.remove("b");
+
+    QByteArray bytes;
+    {
+        QDataStream out(&bytes, QIODevice::WriteOnly);
+        out << source.changesSince(replica.version());
+        out << source.snapshot();
+    }
+    QDataStream in(bytes);
+    Delta delta;
+    in >> delta;
+    QCOMPARE(in.status(), QDataStream::Ok);
+    QCOMPARE(delta.from, qint64(5));
+    QCOMPARE(delta.changes.size(), 4);
+    QVERIFY(replica.applyChanges(delta));
+    QVERIFY(sameEntries(source, replica));
+
+    Journaled other;
+    in >> delta;
+    QCOMPARE(in.status(), QDataStream::Ok);
+    QVERIFY(in.atEnd());
+    QVERIFY(delta.isSnapshot());
+    QVERIFY(other.applyChanges(delta));
+    QVERIFY(sameEntries(source, other));
+}
+
+void JournaledOrderedHashTests::testStreamCorrupt()
+{
+    QByteArray bytes;
+    {
+        QDataStream out(&bytes, QIODevice::WriteOnly);
+        out << qint8(42) << QString("a");
+    }
+    QDataStream in(bytes);
+    Change change;
+    in >> change;
+    QCOMPARE(in.status(), QDataStream::ReadCorruptData);
+    QCOMPARE(int(change.type), int(Change::Clear));
+}
+
+void JournaledOrderedHashTests::testRandomReplication()
+{
+    Journaled source(64);
+    Journaled replica;
+    quint32 seed = 1;
+    for (int round = 0; round < 200; round++)
+    {
+        const int changes = round % 7 == 0 ? 100 : round % 13;
+        for (int i = 0; i < changes; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            const QString key = QString::number((seed >> 8) % 40);
+            const QString other = QString::number((seed >> 16) % 40);
+            switch ((seed >> 24) % 8)
+            {
+            case 0: case 1: case 2:
+                source.insert(key, int(seed));
+                break;
+            case 3: case 4:
+                source.remove(key);
+                break;
+            case 5:
+                source.moveToEnd(key);
+                break;
+            case 6:
+                source.move(key, other);
+                break;
+            default:
+                if (seed % 50 == 0)
+                    source.clear();
+                else
+                    source.take(key);
+                break;
+            }
+        }
+        QVERIFY(replica.applyChanges(
+                    source.changesSince(replica.version())));
+        QCOMPARE(replica.version(), source.version());
+        QVERIFY(sameEntries(source, replica));
+    }
+}
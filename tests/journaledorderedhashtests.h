@@ -0,0 +1,25 @@
+#ifndef JOURNALEDORDEREDHASHTESTS_H
+#define JOURNALEDORDEREDHASHTESTS_H
+
+#include <QtTest>
+#include "journaledorderedhash.h"
+
+class JournaledOrderedHashTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testVersions();
+    void testChangesSince();
+    void testMoves();
+    void testJournalOverflow();
+    void testSnapshotWhenSmaller();
+    void testSetJournalCapacity();
+    void testApplyOutOfOrder();
+    void testRelay();
+    void testStream();
+    void testStreamCorrupt();
+    void testRandomReplication();
+};
+
+#endif  // JOURNALEDORDEREDHASHTESTS_H
@@ -0,0 +1,220 @@
+#include "orderedhashmodeltests.h"
+
+typedef qtcollections::OrderedHash<QString, int> Hash;
+typedef qtcollections::OrderedHashModel<QString, int> Model;
+
+namespace
+{
+
+QList<QString> rowKeys(const Model &model)
+{
+    QList<QString> keys;
+    for (int row = 0; row < model.rowCount(); row++)
+        keys << model.keyAt(row);
+    return keys;
+}
+
+}   // namespace
+
+void OrderedHashModelTests::testRows()
+{
+    Model model(Hash({{"a", 1}, {"b", 2}}));
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(model.columnCount(), 2);
+    QCOMPARE(model.keyAt(1), QString("b"));
+    QCOMPARE(model.row("a"), 0);
+    QCOMPARE(model.row("c"), -1);
+    QCOMPARE(model.indexOf("b", Model::ValueColumn), model.index(1, 1));
+}
+
+void OrderedHashModelTests::testData()
+{
+    Model model(Hash({{"a", 1}, {"b", 2}}));
+    QCOMPARE(model.data(model.index(1, Model::KeyColumn)),
+             QVariant(QString("b")));
+    QCOMPARE(model.data(model.index(1, Model::ValueColumn)), QVariant(2));
+    QCOMPARE(model.data(model.index(0, 0), Model::ValueRole), QVariant(1));
+    QCOMPARE(model.data(model.index(0, 1), Model::KeyRole),
+             QVariant(QString("a")));
+    QVERIFY(!model.data(model.index(0, 0), Qt::UserRole + 10).isValid());
+}
+
+void OrderedHashModelTests::testSetData()
+{
+    Model model(Hash({{"a", 1}, {"b", 2}}));
+    QSignalSpy spy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex)));
+
+    QVERIFY(!model.setData(model.index(1, Model::KeyColumn), QVariant(5)));
+    QVERIFY(model.setData(model.index(1, Model::ValueColumn), QVariant(5)));
+    QCOMPARE(model.hash().value("b"), 5);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(model.flags(model.index(1, Model::ValueColumn))
+            & Qt::ItemIsEditable);
+    QVERIFY(!(model.flags(model.index(1, Model::KeyColumn))
+              & Qt::ItemIsEditable));
+}
+
+void OrderedHashModelTests::testRoleNames()
+{
+    Model model;
+    QCOMPARE(model.roleNames().value(Model::KeyRole), QByteArray("key"));
+    QCOMPARE(model.roleNames().value(Model::ValueRole), QByteArray("value"));
+}
+
+void OrderedHashModelTests::testInsertIsCoalesced()
+{
+    Model model(Hash({{"a", 1}}));
+    QSignalSpy spy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+
+    model.insert("b", 2);
+    model.insert("c", 3);
+    model.insert("d", 4);
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(model.rowCount(), 1);
+
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(1).toInt(), 1);
+    QCOMPARE(spy.at(0).at(2).toInt(), 3);
+    QCOMPARE(rowKeys(model), QList<QString>() << "a" << "b" << "c" << "d");
+}
+
+void OrderedHashModelTests::testRemoveRuns()
+{
+    Model model(Hash({{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}, {"e", 5}}));
+    QSignalSpy spy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    model.remove("d");
+    model.remove("a");
+    model.remove("b");
+    model.flush();
+
+    // Later runs are removed first, so earlier rows stay valid.
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(0).at(1).toInt(), 3);
+    QCOMPARE(spy.at(0).at(2).toInt(), 3);
+    QCOMPARE(spy.at(1).at(1).toInt(), 0);
+    QCOMPARE(spy.at(1).at(2).toInt(), 1);
+    QCOMPARE(rowKeys(model), QList<QString>() << "c" << "e");
+}
+
+void OrderedHashModelTests::testMoveToEnd()
+{
+    Model model(Hash({{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}}));
+    QSignalSpy moved(&model,
+                     SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+
+    model.moveToEnd("a");
+    model.moveToEnd("b");
+    model.flush();
+
+    QCOMPARE(moved.count(), 1);
+    QCOMPARE(moved.at(0).at(1).toInt(), 0);
+    QCOMPARE(moved.at(0).at(2).toInt(), 1);
+    QCOMPARE(moved.at(0).at(4).toInt(), 4);
+    QCOMPARE(rowKeys(model), QList<QString>() << "c" << "d" << "a" << "b");
+    QCOMPARE(model.hash().keys(), rowKeys(model));
+}
+
+void OrderedHashModelTests::testReinsertMovesRow()
+{
+    Model model(Hash({{"a", 1}, {"b", 2}}));
+    QSignalSpy moved(&model,
+                     SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+    QSignalSpy removed(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    model.remove("a");
+    model.insert("a", 3);
+    model.flush();
+
+    QCOMPARE(removed.count(), 0);
+    QCOMPARE(moved.count(), 1);
+    QCOMPARE(rowKeys(model), QList<QString>() << "b" << "a");
+    QCOMPARE(model.data(model.index(1, Model::ValueColumn)), QVariant(3));
+}
+
+void OrderedHashModelTests::testDataChanged()
+{
+    Model model(Hash({{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}}));
+    QSignalSpy spy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex)));
+
+    model.insert("c", 30);
+    model.insert("b", 20);
+    model.insert("b", 21);
+    model.flush();
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<QModelIndex>(), model.index(1, 0));
+    QCOMPARE(spy.at(0).at(1).value<QModelIndex>(), model.index(2, 1));
+    QCOMPARE(model.hash().value("b"), 21);
+}
+
+void OrderedHashModelTests::testClear()
+{
+    Model model(Hash({{"a", 1}, {"b", 2}}));
+    QSignalSpy removed(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+
+    model.clear();
+    model.insert("a", 3);
+    model.flush();
+
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(2).toInt(), 1);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(rowKeys(model), QList<QString>() << "a");
+}
+
+void OrderedHashModelTests::testDataBeforeFlush()
+{
+    // Rows views still see keep the value of their removed keys.
+    Model model(Hash({{"a", 1}, {"b", 2}, {"c", 3}}));
+    model.remove("b");
+    QCOMPARE(model.take("c"), 3);
+    model.insert("a", 4);
+    QCOMPARE(model.rowCount(), 3);
+    QCOMPARE(model.data(model.index(0, Model::ValueColumn)), QVariant(4));
+    QCOMPARE(model.data(model.index(1, Model::ValueColumn)), QVariant(2));
+    QCOMPARE(model.data(model.index(2, 0), Model::ValueRole), QVariant(3));
+
+    model.clear();
+    QCOMPARE(model.data(model.index(0, Model::ValueColumn)), QVariant(4));
+    QCOMPARE(model.data(model.index(1, Model::ValueColumn)), QVariant(2));
+
+    model.flush();
+    QCOMPARE(model.rowCount(), 0);
+    model.insert("b", 5);
+    model.flush();
+    QCOMPARE(model.data(model.index(0, Model::ValueColumn)), QVariant(5));
+}
+
+void OrderedHashModelTests::testSetHash()
+{
+    Model model;
+    QSignalSpy spy(&model, SIGNAL(modelReset()));
+    model.insert("x", 1);
+    model.setHash(Hash({{"a", 1}, {"b", 2}}));
+    model.flush();
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(rowKeys(model), QList<QString>() << "a" << "b");
+}
+
+void OrderedHashModelTests::testRowLookup()
+{
+    Model model;
+    for (int i = 0; i < 1000; i++)
+        model.insert(QString::number(i), i);
+    model.flush();
+    for (int i = 0; i < 1000; i += 3)
+        model.remove(QString::number(i));
+    model.flush();
+
+    QCOMPARE(model.rowCount(), 666);
+    for (int row = 0; row < model.rowCount(); row++)
+    {
+        int i = row / 2 * 3 + row % 2 + 1;
+        QCOMPARE(model.keyAt(row), QString::number(i));
+        QCOMPARE(model.row(QString::number(i)), row);
+    }
+}
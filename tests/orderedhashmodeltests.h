@@ -0,0 +1,28 @@
+#ifndef ORDEREDHASHMODELTESTS_H
+#define ORDEREDHASHMODELTESTS_H
+
+#include <QtTest>
+#include "orderedhashmodel.h"
+
+class OrderedHashModelTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRows();
+    void testData();
+    void testSetData();
+    void testRoleNames();
+
+    void testInsertIsCoalesced();
+    void testRemoveRuns();
+    void testMoveToEnd();
+    void testReinsertMovesRow();
+    void testDataChanged();
+    void testClear();
+    void testDataBeforeFlush();
+    void testSetHash();
+    void testRowLookup();
+};
+
+#endif  // ORDEREDHASHMODELTESTS_H
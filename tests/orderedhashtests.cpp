@@ -1,68 +1,144 @@
+#include <iterator>
+#include <limits>
 #include "orderedhashtests.h"
 
-OrderedHashTests::OrderedHashTests() : QObject()
+namespace
 {
-}
 
-void OrderedHashTests::init()
+typedef qtcollections::OrderedHash<int, QString> FlatHash;
+typedef qtcollections::OrderedHash<int, QString,
+                                   qtcollections::NodeEngine<> > NodeHash;
+
+// The cases that run against each engine, each on a fresh hash.
+template <typename Hash>
+struct OrderedHashCases
+{
+    // Implicitly tests the default constructor.
+    Hash hash;
+
+    void testCopyConstructor();
+    void testInitializerListConstructor();
+    void testAssignmentOperator();
+    void testEqualityOperator();
+    void testInequalityOperator();
+    void testSize();
+    void testIsEmpty();
+    void testClear();
+    void testRemove();
+    void testTake();
+    void testContains();
+    void testKey();
+    void testKeyDefault();
+    void testValue();
+    void testValueDefault();
+    void testBracketOperator();
+    void testKeys();
+    void testKeysForValue();
+    void testValues();
+    void testKeysView();
+    void testValuesView();
+    void testItemsView();
+    void testKeyValueIterator();
+    void testEmpty();
+    void testCount();
+    void testFind();
+    void testFindConst();
+    void testConstFind();
+    void testErase();
+    void testRemoveIf();
+    void testEraseRange();
+    void testRetainKeys();
+    void testRemoveKeys();
+    void testInsert();
+    void testToHash();
+    void testFirstKey();
+    void testLastKey();
+    void testTakeFirst();
+    void testTakeLast();
+    void testFirst();
+    void testLast();
+    void testRemoveFirst();
+    void testRemoveLast();
+    void testPopFront();
+    void testPopBack();
+    void testConstIteration();
+    void testForeach();
+    void testMaxKey();
+    void testCompaction();
+    void testValuesFor();
+    void testContainsMany();
+    void testExtract();
+    void testInsertNode();
+    void testSplice();
+    void testMergeWhileResizing();
+};
+
+}   // namespace
+
+OrderedHashTests::OrderedHashTests() : QObject()
 {
-    hash = qtcollections::OrderedHash<int, QString>();
 }
 
-void OrderedHashTests::testCopyConstructor()
+template <typename Hash>
+void OrderedHashCases<Hash>::testCopyConstructor()
 {
     hash.insert(1, "one");
-    auto copied = qtcollections::OrderedHash<int, QString>(hash);
+    auto copied = Hash(hash);
     hash.insert(2, "two");
 
     QCOMPARE(hash.size(), 2);
     QCOMPARE(copied.size(), 1);
 }
 
-void OrderedHashTests::testInitializerListConstructor()
+template <typename Hash>
+void OrderedHashCases<Hash>::testInitializerListConstructor()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
 
-    qtcollections::OrderedHash<int, QString> expected({
+    Hash expected({
         {1, "one"}, {2, "two"},
     });
     QCOMPARE(hash, expected);
 }
 
-void OrderedHashTests::testAssignmentOperator()
+template <typename Hash>
+void OrderedHashCases<Hash>::testAssignmentOperator()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
 
     auto copied = hash;
-    qtcollections::OrderedHash<int, QString> expected({
+    Hash expected({
         {1, "one"}, {2, "two"},
     });
     QCOMPARE(copied, expected);
 }
 
-void OrderedHashTests::testEqualityOperator()
+template <typename Hash>
+void OrderedHashCases<Hash>::testEqualityOperator()
 {
     hash.insert(1, "one");
-    auto other = qtcollections::OrderedHash<int, QString>();
+    auto other = Hash();
     QCOMPARE(hash == other, false);
 
     other.insert(1, "one");
     QVERIFY(hash == other);
 }
 
-void OrderedHashTests::testInequalityOperator()
+template <typename Hash>
+void OrderedHashCases<Hash>::testInequalityOperator()
 {
     hash.insert(1, "one");
-    auto other = qtcollections::OrderedHash<int, QString>();
+    auto other = Hash();
     QVERIFY(hash != other);
 
     other.insert(1, "one");
     QCOMPARE(hash != other, false);
 }
 
-void OrderedHashTests::testSize()
+template <typename Hash>
+void OrderedHashCases<Hash>::testSize()
 {
     QCOMPARE(hash.size(), 0);
 
@@ -70,7 +146,8 @@ void OrderedHashTests::testSize()
     QCOMPARE(hash.size(), 1);
 }
 
-void OrderedHashTests::testIsEmpty()
+template <typename Hash>
+void OrderedHashCases<Hash>::testIsEmpty()
 {
     QVERIFY(hash.isEmpty());
 
@@ -78,7 +155,8 @@ void OrderedHashTests::testIsEmpty()
     QVERIFY(!hash.isEmpty());
 }
 
-void OrderedHashTests::testClear()
+template <typename Hash>
+void OrderedHashCases<Hash>::testClear()
 {
     hash.insert(1, "one");
     QVERIFY(!hash.isEmpty());
@@ -87,7 +165,8 @@ void OrderedHashTests::testClear()
     QVERIFY(hash.isEmpty());
 }
 
-void OrderedHashTests::testRemove()
+template <typename Hash>
+void OrderedHashCases<Hash>::testRemove()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
@@ -103,7 +182,8 @@ void OrderedHashTests::testRemove()
     QVERIFY(hash.isEmpty());
 }
 
-void OrderedHashTests::testTake()
+template <typename Hash>
+void OrderedHashCases<Hash>::testTake()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
@@ -122,7 +202,8 @@ void OrderedHashTests::testTake()
     QVERIFY(hash.isEmpty());
 }
 
-void OrderedHashTests::testContains()
+template <typename Hash>
+void OrderedHashCases<Hash>::testContains()
 {
     QVERIFY(!hash.contains(1));
 
@@ -133,7 +214,8 @@ void OrderedHashTests::testContains()
     QVERIFY(!hash.contains(1));
 }
 
-void OrderedHashTests::testKey()
+template <typename Hash>
+void OrderedHashCases<Hash>::testKey()
 {
     hash.insert(1, "one");
     hash.insert(2, "one");
@@ -143,7 +225,8 @@ void OrderedHashTests::testKey()
     QCOMPARE(hash.key("two"), 0);
 }
 
-void OrderedHashTests::testKeyDefault()
+template <typename Hash>
+void OrderedHashCases<Hash>::testKeyDefault()
 {
     hash.insert(1, "one");
     hash.insert(2, "one");
@@ -153,7 +236,8 @@ void OrderedHashTests::testKeyDefault()
     QCOMPARE(hash.key("two", -1), -1);
 }
 
-void OrderedHashTests::testValue()
+template <typename Hash>
+void OrderedHashCases<Hash>::testValue()
 {
     hash.insert(1, "nil");
     hash.insert(1, "one");
@@ -162,7 +246,8 @@ void OrderedHashTests::testValue()
     QCOMPARE(hash.value(2), QString());
 }
 
-void OrderedHashTests::testValueDefault()
+template <typename Hash>
+void OrderedHashCases<Hash>::testValueDefault()
 {
     hash.insert(1, "non");
     hash.insert(1, "one");
@@ -171,7 +256,8 @@ void OrderedHashTests::testValueDefault()
     QCOMPARE(hash.value(2, "nil"), QString("nil"));
 }
 
-void OrderedHashTests::testBracketOperator()
+template <typename Hash>
+void OrderedHashCases<Hash>::testBracketOperator()
 {
     hash.insert(1, "non");
     hash.insert(1, "one");
@@ -180,7 +266,8 @@ void OrderedHashTests::testBracketOperator()
     QCOMPARE(hash[2], QString());
 }
 
-void OrderedHashTests::testKeys()
+template <typename Hash>
+void OrderedHashCases<Hash>::testKeys()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
@@ -189,7 +276,8 @@ void OrderedHashTests::testKeys()
     QCOMPARE(hash.keys(), QList<int>() << 1 << 2 << 3);
 }
 
-void OrderedHashTests::testKeysForValue()
+template <typename Hash>
+void OrderedHashCases<Hash>::testKeysForValue()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
@@ -198,7 +286,8 @@ void OrderedHashTests::testKeysForValue()
     QCOMPARE(hash.keys("one"), QList<int>() << 1 << 3);
 }
 
-void OrderedHashTests::testValues()
+template <typename Hash>
+void OrderedHashCases<Hash>::testValues()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
@@ -207,7 +296,86 @@ void OrderedHashTests::testValues()
     QCOMPARE(hash.values(), QList<QString>() << "one" << "two" << "one");
 }
 
-void OrderedHashTests::testEmpty()
+template <typename Hash>
+void OrderedHashCases<Hash>::testKeysView()
+{
+    hash.insert(1, "one");
+    hash.insert(3, "three");
+    auto keys = hash.keysView();
+    hash.insert(2, "two");
+
+    QCOMPARE(keys.size(), 3);
+    QVERIFY(keys.contains(2));
+    QVERIFY(!keys.contains(4));
+
+    QList<int> forward;
+    for (int key : keys)
+        forward.append(key);
+    QCOMPARE(forward, QList<int>() << 1 << 3 << 2);
+
+    QList<int> backward;
+    for (auto it = keys.rbegin(); it != keys.rend(); ++it)
+        backward.append(*it);
+    QCOMPARE(backward, QList<int>() << 2 << 3 << 1);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testValuesView()
+{
+    hash.insert(1, "one");
+    hash.insert(2, "two");
+    auto values = hash.valuesView();
+
+    QCOMPARE(values.size(), 2);
+    QVERIFY(values.contains("two"));
+    QVERIFY(!values.contains("three"));
+    QCOMPARE(*values.begin(), QString("one"));
+    QCOMPARE(*values.rbegin(), QString("two"));
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testItemsView()
+{
+    hash.insert(1, "one");
+    hash.insert(2, "two");
+    auto items = hash.itemsView();
+
+    QVERIFY(items.contains(1, "one"));
+    QVERIFY(!items.contains(1, "two"));
+    QVERIFY(!items.contains(3, "three"));
+
+    QList<int> keys;
+    QList<QString> values;
+    for (auto item : items)
+    {
+        keys.append(item.first);
+        values.append(item.second);
+    }
+    QCOMPARE(keys, QList<int>() << 1 << 2);
+    QCOMPARE(values, QList<QString>() << "one" << "two");
+    QCOMPARE((*items.rbegin()).first, 2);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testKeyValueIterator()
+{
+    hash.insert(1, "one");
+    hash.insert(2, "two");
+
+    for (auto it = hash.keyValueBegin(); it != hash.keyValueEnd(); ++it)
+        (*it).second += QString::number((*it).first);
+    QCOMPARE(hash.values(), QList<QString>() << "one1" << "two2");
+
+    auto it = hash.constKeyValueBegin();
+    QCOMPARE((*it).first, 1);
+    ++it;
+    QCOMPARE((*it).second, QString("two2"));
+    ++it;
+    QVERIFY(it == hash.constKeyValueEnd());
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testEmpty()
 {
     QVERIFY(hash.empty());
 
@@ -215,7 +383,8 @@ void OrderedHashTests::testEmpty()
     QVERIFY(!hash.empty());
 }
 
-void OrderedHashTests::testCount()
+template <typename Hash>
+void OrderedHashCases<Hash>::testCount()
 {
     QCOMPARE(hash.count(), 0);
 
@@ -223,7 +392,8 @@ void OrderedHashTests::testCount()
     QCOMPARE(hash.count(), 1);
 }
 
-void OrderedHashTests::testFind()
+template <typename Hash>
+void OrderedHashCases<Hash>::testFind()
 {
     QCOMPARE(hash.find(1), hash.end());
 
@@ -236,9 +406,10 @@ void OrderedHashTests::testFind()
     QCOMPARE(hash.find(3), hash.end());
 }
 
-void OrderedHashTests::testFindConst()
+template <typename Hash>
+void OrderedHashCases<Hash>::testFindConst()
 {
-    qtcollections::OrderedHash<int, QString>::const_iterator i;
+    typename Hash::const_iterator i;
 
     i = hash.find(1);
     QCOMPARE(i, hash.constEnd());
@@ -259,7 +430,8 @@ void OrderedHashTests::testFindConst()
     QCOMPARE(i, hash.constEnd());
 }
 
-void OrderedHashTests::testConstFind()
+template <typename Hash>
+void OrderedHashCases<Hash>::testConstFind()
 {
     QCOMPARE(hash.constFind(1), hash.constEnd());
 
@@ -272,7 +444,8 @@ void OrderedHashTests::testConstFind()
     QCOMPARE(hash.constFind(3), hash.constEnd());
 }
 
-void OrderedHashTests::testErase()
+template <typename Hash>
+void OrderedHashCases<Hash>::testErase()
 {
     hash.insert(1, "one");
     hash.insert(2, "one");
@@ -288,7 +461,84 @@ void OrderedHashTests::testErase()
     QCOMPARE(hash.find(2) - 1, hash.find(3));
 }
 
-void OrderedHashTests::testInsert()
+template <typename Hash>
+void OrderedHashCases<Hash>::testRemoveIf()
+{
+    for (int i = 0; i < 10; i++)
+        hash.insert(i, QString::number(i));
+
+    int removed = hash.removeIf([](int key, const QString &) {
+        return key % 3 == 0;
+    });
+    QCOMPARE(removed, 4);
+    QCOMPARE(hash.keys(), QList<int>() << 1 << 2 << 4 << 5 << 7 << 8);
+    QCOMPARE(hash.value(8), QString("8"));
+    QVERIFY(!hash.contains(9));
+
+    hash.insert(9, "nine");
+    QCOMPARE(hash.lastKey(), 9);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testEraseRange()
+{
+    for (int i = 0; i < 10; i++)
+        hash.insert(i, QString::number(i));
+
+    QCOMPARE(hash.erase(hash.find(2), hash.find(5)), 3);
+    QCOMPARE(hash.keys(), QList<int>() << 0 << 1 << 5 << 6 << 7 << 8 << 9);
+
+    QCOMPARE(hash.erase(hash.find(7), hash.end()), 3);
+    QCOMPARE(hash.keys(), QList<int>() << 0 << 1 << 5 << 6);
+    QCOMPARE(hash.lastKey(), 6);
+
+    QCOMPARE(hash.erase(hash.begin(), hash.end()), 4);
+    QVERIFY(hash.isEmpty());
+
+    // A range erased while a resize is in progress leaves both tables.
+    hash.setIncrementalResize(true);
+    for (int i = 0; i < 1000; i++)
+        hash.insert(i, QString::number(i));
+    QCOMPARE(hash.erase(hash.find(100), hash.find(900)), 800);
+    QCOMPARE(hash.size(), 200);
+    for (int i = 0; i < 1000; i++)
+        QCOMPARE(hash.contains(i), i < 100 || i >= 900);
+    QCOMPARE(hash.erase(hash.begin(), hash.find(900)), 100);
+    QCOMPARE(hash.firstKey(), 900);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testRetainKeys()
+{
+    hash.insert(1, "one");
+    hash.insert(2, "two");
+    hash.insert(3, "three");
+
+    QCOMPARE(hash.retainKeys(QSet<int>() << 3 << 1 << 4), 1);
+    QCOMPARE(hash, decltype(hash)({{1, "one"}, {3, "three"}}));
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testRemoveKeys()
+{
+    hash.insert(1, "one");
+    hash.insert(2, "two");
+    hash.insert(3, "three");
+
+    QCOMPARE(hash.removeKeys(QList<int>() << 3 << 4 << 1 << 3), 2);
+    QCOMPARE(hash, decltype(hash)({{2, "two"}}));
+
+    // Keys much fewer than the entries are looked up one by one.
+    for (int i = 10; i < 30; i++)
+        hash.insert(i, QString::number(i));
+    QCOMPARE(hash.removeKeys(QList<int>() << 12 << 40 << 2), 2);
+    QCOMPARE(hash.size(), 19);
+    QCOMPARE(hash.firstKey(), 10);
+    QVERIFY(!hash.contains(12));
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testInsert()
 {
     hash.insert(1, "one");
     QCOMPARE(hash.size(), 1);
@@ -300,7 +550,8 @@ void OrderedHashTests::testInsert()
     QCOMPARE(hash.size(), 2);
 }
 
-void OrderedHashTests::testToHash()
+template <typename Hash>
+void OrderedHashCases<Hash>::testToHash()
 {
     hash.insert(1, "one");
     hash.insert(3, "one");
@@ -317,7 +568,8 @@ void OrderedHashTests::testToHash()
     QCOMPARE(actual, expected);
 }
 
-void OrderedHashTests::testFirstKey()
+template <typename Hash>
+void OrderedHashCases<Hash>::testFirstKey()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
@@ -326,7 +578,8 @@ void OrderedHashTests::testFirstKey()
     QCOMPARE(hash.firstKey(), 1);
 }
 
-void OrderedHashTests::testLastKey()
+template <typename Hash>
+void OrderedHashCases<Hash>::testLastKey()
 {
     hash.insert(1, "one");
     hash.insert(3, "one");
@@ -338,7 +591,8 @@ void OrderedHashTests::testLastKey()
     QCOMPARE(hash.lastKey(), 2);
 }
 
-void OrderedHashTests::testTakeFirst()
+template <typename Hash>
+void OrderedHashCases<Hash>::testTakeFirst()
 {
     hash.insert(1, "one");
     hash.insert(3, "one");
@@ -350,7 +604,8 @@ void OrderedHashTests::testTakeFirst()
     QCOMPARE(hash.size(), 2);
 }
 
-void OrderedHashTests::testTakeLast()
+template <typename Hash>
+void OrderedHashCases<Hash>::testTakeLast()
 {
     hash.insert(1, "one");
     hash.insert(2, "two");
@@ -362,7 +617,8 @@ void OrderedHashTests::testTakeLast()
     QCOMPARE(hash.size(), 2);
 }
 
-void OrderedHashTests::testFirst()
+template <typename Hash>
+void OrderedHashCases<Hash>::testFirst()
 {
     hash.insert(1, "one");
     hash.insert(3, "three");
@@ -374,7 +630,8 @@ void OrderedHashTests::testFirst()
     QCOMPARE(hash.first(), QString("one"));
 }
 
-void OrderedHashTests::testLast()
+template <typename Hash>
+void OrderedHashCases<Hash>::testLast()
 {
     hash.insert(1, "one");
     hash.insert(3, "one");
@@ -386,7 +643,8 @@ void OrderedHashTests::testLast()
     QCOMPARE(hash.last(), QString("two"));
 }
 
-void OrderedHashTests::testRemoveFirst()
+template <typename Hash>
+void OrderedHashCases<Hash>::testRemoveFirst()
 {
     hash.insert(1, "one");
     hash.insert(3, "one");
@@ -399,7 +657,8 @@ void OrderedHashTests::testRemoveFirst()
     QCOMPARE(hash, decltype(hash)({{2, "two"}}));
 }
 
-void OrderedHashTests::testRemoveLast()
+template <typename Hash>
+void OrderedHashCases<Hash>::testRemoveLast()
 {
     hash.insert(1, "one");
     hash.insert(3, "one");
@@ -412,7 +671,8 @@ void OrderedHashTests::testRemoveLast()
     QCOMPARE(hash, decltype(hash)({{1, "one"}}));
 }
 
-void OrderedHashTests::testPopFront()
+template <typename Hash>
+void OrderedHashCases<Hash>::testPopFront()
 {
     hash.insert(1, "one");
     hash.insert(3, "one");
@@ -425,7 +685,8 @@ void OrderedHashTests::testPopFront()
     QCOMPARE(hash, decltype(hash)({{2, "two"}}));
 }
 
-void OrderedHashTests::testPopBack()
+template <typename Hash>
+void OrderedHashCases<Hash>::testPopBack()
 {
     hash.insert(1, "one");
     hash.insert(3, "one");
@@ -438,7 +699,8 @@ void OrderedHashTests::testPopBack()
     QCOMPARE(hash, decltype(hash)({{1, "one"}}));
 }
 
-void OrderedHashTests::testConstIteration()
+template <typename Hash>
+void OrderedHashCases<Hash>::testConstIteration()
 {
     hash.insert(1, "one");
     auto it = hash.constBegin();
@@ -451,7 +713,8 @@ void OrderedHashTests::testConstIteration()
     QCOMPARE(it, hash.constEnd());
 }
 
-void OrderedHashTests::testForeach()
+template <typename Hash>
+void OrderedHashCases<Hash>::testForeach()
 {
     auto keys = QList<int>() << 1 << 2 << 3 << 4;
     QHash<int, QString> comp;
@@ -470,6 +733,374 @@ void OrderedHashTests::testForeach()
     }
 }
 
+template <typename Hash>
+void OrderedHashCases<Hash>::testMaxKey()
+{
+    const int maxKey = std::numeric_limits<int>::max();
+    hash.insert(1, "one");
+    hash.insert(maxKey, "max");
+    hash.insert(2, "two");
+
+    QVERIFY(hash.contains(maxKey));
+    QCOMPARE(hash.keys(), QList<int>() << 1 << maxKey << 2);
+    QCOMPARE(hash.value(maxKey), QString("max"));
+
+    hash.remove(maxKey);
+    QVERIFY(!hash.contains(maxKey));
+    QCOMPARE(hash.keys(), QList<int>() << 1 << 2);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testCompaction()
+{
+    for (int i = 0; i < 100; i++)
+        hash.insert(i, QString::number(i));
+    for (int i = 0; i < 100; i += 3)
+        hash.remove(i);
+    for (int i = 100; i < 200; i++)
+        hash.insert(i, QString::number(i));
+
+    QList<int> expected;
+    for (int i = 0; i < 200; i++)
+    {
+        if (i >= 100 || i % 3)
+            expected.append(i);
+    }
+    QCOMPARE(hash.keys(), expected);
+    QCOMPARE(hash.value(98), QString("98"));
+    QCOMPARE(hash.value(99), QString());
+}
+
+void OrderedHashTests::testNodeEngine()
+{
+    NodeHash nodes;
+    QString &first = nodes[1];
+    first = "one";
+    for (int i = 2; i < 1000; i++)
+        nodes.insert(i, QString::number(i));
+    QCOMPARE(&first, &nodes[1]);
+    QCOMPARE(first, QString("one"));
+
+    const int maxKey = std::numeric_limits<int>::max();
+    nodes.insert(maxKey, "max");
+    QCOMPARE(nodes.lastKey(), maxKey);
+    QCOMPARE(nodes.value(maxKey), QString("max"));
+}
+
+void OrderedHashTests::testStringKeys()
+{
+    qtcollections::OrderedHash<QString, int> strings;
+    strings.insert("b", 2);
+    strings.insert("a", 1);
+    strings.insert("c", 3);
+    strings.remove("a");
+    strings.insert("a", 4);
+
+    QCOMPARE(strings.keys(), QList<QString>() << "b" << "c" << "a");
+    QCOMPARE(strings.values(), QList<int>() << 2 << 3 << 4);
+    QCOMPARE(strings.takeFirst(), qMakePair(QString("b"), 2));
+    QCOMPARE(strings.lastKey(), QString("a"));
+}
+
+void OrderedHashTests::testIncrementalResize()
+{
+    qtcollections::OrderedHash<int, int> ints;
+    ints.setIncrementalResize(true);
+    QVERIFY(ints.isIncrementalResize());
+
+    // Lookups and removals must work while resizes are in progress.
+    for (int i = 0; i < 10000; i++)
+    {
+        ints.insert(i, i * 2);
+        QCOMPARE(ints.value(i), i * 2);
+        if (i % 3 == 0)
+        {
+            ints.remove(i / 3);
+            QVERIFY(!ints.contains(i / 3));
+        }
+    }
+    for (int i = 0; i < 10000; i++)
+        QCOMPARE(ints.contains(i), i > 3333);
+    QCOMPARE(ints.size(), 10000 - 3334);
+    QCOMPARE(ints.firstKey(), 3334);
+    QCOMPARE(ints.value(9999), 19998);
+
+    ints.setIncrementalResize(false);
+    QVERIFY(!ints.isIncrementalResize());
+    QCOMPARE(ints.value(5000), 10000);
+}
+
+void OrderedHashTests::testIncrementalResizeStringKeys()
+{
+    qtcollections::OrderedHash<QString, int> strings;
+    strings.setIncrementalResize(true);
+
+    for (int i = 0; i < 10000; i++)
+    {
+        strings.insert(QString::number(i), i);
+        QCOMPARE(strings.value(QString::number(i)), i);
+        if (i % 3 == 0)
+            strings.remove(QString::number(i / 3));
+    }
+    for (int i = 0; i < 10000; i++)
+        QCOMPARE(strings.contains(QString::number(i)), i > 3333);
+    QCOMPARE(strings.size(), 10000 - 3334);
+    QCOMPARE(strings.firstKey(), QString("3334"));
+
+    qtcollections::OrderedHash<QString, int> copy = strings;
+    QCOMPARE(copy, strings);
+    QVERIFY(copy.isIncrementalResize());
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testValuesFor()
+{
+    for (int i = 0; i < 100; i++)
+        hash.insert(i * 3, QString::number(i));
+    QVector<int> keys;
+    keys << 0 << 4 << 297 << 30 << 300 << 30;
+
+    QStringList values;
+    hash.valuesFor(keys, std::back_inserter(values), "none");
+    QCOMPARE(values, QStringList() << "0" << "none" << "99" << "10"
+                                   << "none" << "10");
+
+    // Works on an empty hash too, and returns the advanced iterator.
+    QVector<QString> out(3);
+    QVector<QString>::iterator end =
+            Hash().valuesFor(
+                keys.mid(0, 2), out.begin());
+    QVERIFY(end == out.begin() + 2);
+    QCOMPARE(out.at(0), QString());
+}
+
+void OrderedHashTests::testValuesForStringKeys()
+{
+    qtcollections::OrderedHash<QString, int> strings;
+    strings.setIncrementalResize(true);
+    QStringList keys;
+    QList<int> expected;
+    for (int i = 0; i < 1000; i++)
+    {
+        strings.insert(QString::number(i), i);
+        keys << QString::number(i * 2);
+        expected << (i * 2 < 1000 ? i * 2 : -1);
+    }
+
+    QList<int> values;
+    strings.valuesFor(keys, std::back_inserter(values), -1);
+    QCOMPARE(values, expected);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testContainsMany()
+{
+    for (int i = 0; i < 1000; i++)
+        hash.insert(i, QString());
+    hash.remove(500);
+    QVector<int> keys;
+    keys << 1 << 500 << 999 << 1000 << -1;
+
+    QVector<bool> found;
+    hash.containsMany(keys, std::back_inserter(found));
+    QCOMPARE(found, QVector<bool>() << true << false << true << false
+                                    << false);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testExtract()
+{
+    hash.insert(1, "one");
+    hash.insert(2, "two");
+    hash.insert(3, "three");
+
+    typename Hash::Node node = hash.extract(2);
+    QVERIFY(!node.isEmpty());
+    QCOMPARE(node.key(), 2);
+    QCOMPARE(node.value(), QString("two"));
+    QCOMPARE(hash.keys(), QList<int>() << 1 << 3);
+
+    node = hash.extract(hash.begin());
+    QCOMPARE(node.key(), 1);
+    QCOMPARE(hash.keys(), QList<int>() << 3);
+
+    QVERIFY(hash.extract(4).isEmpty());
+    QCOMPARE(hash.size(), 1);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testInsertNode()
+{
+    for (int i = 0; i < 5; i++)
+        hash.insert(i, QString::number(i));
+    Hash other;
+    other.insert(7, "seven");
+    other.insert(2, "two");
+
+    typename Hash::Node node = other.extract(7);
+    auto it = hash.insert(node, hash.find(3));
+    QVERIFY(node.isEmpty());
+    QCOMPARE(it.key(), 7);
+    QCOMPARE(hash.keys(), QList<int>() << 0 << 1 << 2 << 7 << 3 << 4);
+    QCOMPARE(hash.value(7), QString("seven"));
+    QCOMPARE(hash.value(3), QString("3"));
+
+    // An entry already present wins, and the node keeps its own.
+    node = other.extract(2);
+    it = hash.insert(node);
+    QVERIFY(!node.isEmpty());
+    QCOMPARE(it.value(), QString("2"));
+    QCOMPARE(hash.size(), 6);
+
+    // Fills the hole the extracted entry left behind.
+    node = hash.extract(1);
+    hash.insert(node, hash.find(2));
+    QCOMPARE(hash.keys(), QList<int>() << 0 << 1 << 2 << 7 << 3 << 4);
+    node = hash.extract(4);
+    hash.insert(node, hash.begin());
+    QCOMPARE(hash.keys(), QList<int>() << 4 << 0 << 1 << 2 << 7 << 3);
+    QCOMPARE(hash.lastKey(), 3);
+    QCOMPARE(hash.value(4), QString("4"));
+}
+
+void OrderedHashTests::testInsertNodeStringKeys()
+{
+    qtcollections::OrderedHash<QString, int> strings;
+    strings.insert("a", 1);
+    strings.insert("b", 2);
+    strings.insert("c", 3);
+
+    qtcollections::OrderedHash<QString, int>::Node node = strings.extract("c");
+    strings.insert(node, strings.begin());
+    QCOMPARE(strings.keys(), QList<QString>() << "c" << "a" << "b");
+    QCOMPARE(strings.value("c"), 3);
+    QCOMPARE(strings.take("a"), 1);
+    QCOMPARE(strings.keys(), QList<QString>() << "c" << "b");
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testSplice()
+{
+    Hash pending;
+    for (int i = 0; i < 6; i++)
+        pending.insert(i, QString::number(i));
+    hash.insert(3, "three");
+
+    int moved = hash.splice(pending, pending.find(1), pending.find(5));
+    QCOMPARE(moved, 3);
+    QCOMPARE(hash.keys(), QList<int>() << 3 << 1 << 2 << 4);
+    QCOMPARE(hash.value(3), QString("three"));
+    QCOMPARE(pending.keys(), QList<int>() << 0 << 3 << 5);
+
+    moved = hash.splice(pending, pending.begin(), pending.end());
+    QCOMPARE(moved, 2);
+    QCOMPARE(hash.keys(), QList<int>() << 3 << 1 << 2 << 4 << 0 << 5);
+    QCOMPARE(pending.keys(), QList<int>() << 3);
+}
+
+template <typename Hash>
+void OrderedHashCases<Hash>::testMergeWhileResizing()
+{
+    hash.setIncrementalResize(true);
+    for (int i = 1000; i < 1006; i++)
+        hash.insert(i, QString::number(i));
+    Hash pending;
+    for (int i = 0; i < 1000; i++)
+        pending.insert(i, QString::number(i));
+
+    // Appended nodes grow the index incrementally, as insert() does.
+    QCOMPARE(hash.merge(pending), 1000);
+    QCOMPARE(hash.size(), 1006);
+    QCOMPARE(hash.firstKey(), 1000);
+    QCOMPARE(hash.lastKey(), 999);
+    for (int i = 0; i < 1006; i++)
+        QCOMPARE(hash.value(i), QString::number(i));
+    QVERIFY(pending.isEmpty());
+}
+
+void OrderedHashTests::testMerge()
+{
+    qtcollections::OrderedHash<QString, int> active;
+    qtcollections::OrderedHash<QString, int> pending;
+    active.insert("a", 1);
+    pending.insert("b", 2);
+    pending.insert("a", 3);
+    pending.insert("c", 4);
+
+    QCOMPARE(active.merge(pending), 2);
+    QCOMPARE(active.keys(), QList<QString>() << "a" << "b" << "c");
+    QCOMPARE(active.values(), QList<int>() << 1 << 2 << 4);
+    QCOMPARE(pending.keys(), QList<QString>() << "a");
+    QCOMPARE(pending.value("a"), 3);
+}
+
+// Runs a case against the flat engine, then against the node engine.
+#define ENGINE_CASE(name) \
+    void OrderedHashTests::name() \
+    { \
+        OrderedHashCases<FlatHash>().name(); \
+        if (!QTest::currentTestFailed()) \
+            OrderedHashCases<NodeHash>().name(); \
+    }
+
+ENGINE_CASE(testCopyConstructor)
+ENGINE_CASE(testInitializerListConstructor)
+ENGINE_CASE(testAssignmentOperator)
+ENGINE_CASE(testEqualityOperator)
+ENGINE_CASE(testInequalityOperator)
+ENGINE_CASE(testSize)
+ENGINE_CASE(testIsEmpty)
+ENGINE_CASE(testClear)
+ENGINE_CASE(testRemove)
+ENGINE_CASE(testTake)
+ENGINE_CASE(testContains)
+ENGINE_CASE(testKey)
+ENGINE_CASE(testKeyDefault)
+ENGINE_CASE(testValue)
+ENGINE_CASE(testValueDefault)
+ENGINE_CASE(testBracketOperator)
+ENGINE_CASE(testKeys)
+ENGINE_CASE(testKeysForValue)
+ENGINE_CASE(testValues)
+ENGINE_CASE(testKeysView)
+ENGINE_CASE(testValuesView)
+ENGINE_CASE(testItemsView)
+ENGINE_CASE(testKeyValueIterator)
+ENGINE_CASE(testEmpty)
+ENGINE_CASE(testCount)
+ENGINE_CASE(testFind)
+ENGINE_CASE(testFindConst)
+ENGINE_CASE(testConstFind)
+ENGINE_CASE(testErase)
+ENGINE_CASE(testRemoveIf)
+ENGINE_CASE(testEraseRange)
+ENGINE_CASE(testRetainKeys)
+ENGINE_CASE(testRemoveKeys)
+ENGINE_CASE(testInsert)
+ENGINE_CASE(testToHash)
+ENGINE_CASE(testFirstKey)
+ENGINE_CASE(testLastKey)
+ENGINE_CASE(testTakeFirst)
+ENGINE_CASE(testTakeLast)
+ENGINE_CASE(testFirst)
+ENGINE_CASE(testLast)
+ENGINE_CASE(testRemoveFirst)
+ENGINE_CASE(testRemoveLast)
+ENGINE_CASE(testPopFront)
+ENGINE_CASE(testPopBack)
+ENGINE_CASE(testConstIteration)
+ENGINE_CASE(testForeach)
+ENGINE_CASE(testMaxKey)
+ENGINE_CASE(testCompaction)
+ENGINE_CASE(testValuesFor)
+ENGINE_CASE(testContainsMany)
+ENGINE_CASE(testExtract)
+ENGINE_CASE(testInsertNode)
+ENGINE_CASE(testSplice)
+ENGINE_CASE(testMergeWhileResizing)
+
+#undef ENGINE_CASE
+
 void ContainedOrderedHashTests::init()
 {
     hash = qtcollections::OrderedHash<int, QString>({{1, "one"}, {2, "two"}});
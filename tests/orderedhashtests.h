@@ -12,8 +12,7 @@ public:
     OrderedHashTests();
 
 private slots:
-    // Implicitly tests the assignment operator.
-    void init();
+    // Unless noted, each runs against both the flat and the node engine.
     void testCopyConstructor();
     void testInitializerListConstructor();
     void testAssignmentOperator();
@@ -41,6 +40,11 @@ private slots:
     void testKeysForValue();
     void testValues();
 
+    void testKeysView();
+    void testValuesView();
+    void testItemsView();
+    void testKeyValueIterator();
+
     // Tests for iterator.
 
     // Tests for const_iterator.
@@ -52,6 +56,11 @@ private slots:
     void testConstFind();
     void testErase();
 
+    void testRemoveIf();
+    void testEraseRange();
+    void testRetainKeys();
+    void testRemoveKeys();
+
     void testInsert();
     void testToHash();
     void testFirstKey();
@@ -71,9 +80,27 @@ private slots:
     void testConstIteration();
     void testForeach();
 
-private:
-    // Implicitly tests the default constructor.
-    qtcollections::OrderedHash<int, QString> hash;
+    // Tests for the flat engine's key range and holes.
+    void testMaxKey();
+    void testCompaction();
+
+    // Tests for the node engine, used by other keys and NodeEngine<>.
+    void testNodeEngine();
+    void testStringKeys();
+
+    void testIncrementalResize();
+    void testIncrementalResizeStringKeys();
+
+    void testValuesFor();
+    void testValuesForStringKeys();
+    void testContainsMany();
+
+    void testExtract();
+    void testInsertNode();
+    void testInsertNodeStringKeys();
+    void testSplice();
+    void testMergeWhileResizing();
+    void testMerge();
 };
 
 
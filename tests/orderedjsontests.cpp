@@ -0,0 +1,253 @@
+#include "orderedjsontests.h"
+
+using qtcollections::OrderedJsonReader;
+using qtcollections::OrderedJsonWriter;
+using qtcollections::OrderedVariantHash;
+
+namespace
+{
+
+OrderedVariantHash object(const QVariant &value)
+{
+    return value.value<OrderedVariantHash>();
+}
+
+QJsonParseError::ParseError parseError(const QByteArray &json)
+{
+    QJsonParseError error;
+    OrderedJsonReader::parse(json, &error);
+    return error.error;
+}
+
+}   // namespace
+
+void OrderedJsonTests::testKeyOrder()
+{
+    QJsonParseError error;
+    QVariant value = OrderedJsonReader::parse(
+                "{\"zeta\": 1, \"alpha\": 2, \"mu\": 3}", &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+    QCOMPARE(object(value).keys(),
+             QList<QString>() << "zeta" << "alpha" << "mu");
+}
+
+void OrderedJsonTests::testNested()
+{
+    QVariant value = OrderedJsonReader::parse(
+                "{\"b\": {\"y\": [1, {\"q\": 2, \"p\": 3}], \"x\": {}}}");
+    OrderedVariantHash b = object(object(value).value("b"));
+    QCOMPARE(b.keys(), QList<QString>() << "y" << "x");
+
+    QVariantList y = b.value("y").toList();
+    QCOMPARE(y.size(), 2);
+    QCOMPARE(object(y.at(1)).keys(), QList<QString>() << "q" << "p");
+    QVERIFY(object(b.value("x")).isEmpty());
+}
+
+void OrderedJsonTests::testScalars()
+{
+    QVariantList list = OrderedJsonReader::parse(
+                "[true, false, null, 42, -7, 2.5, 1e3, 9223372036854775808]")
+            .toList();
+    QCOMPARE(list.size(), 8);
+    QCOMPARE(list.at(0), QVariant(true));
+    QCOMPARE(list.at(1), QVariant(false));
+    QVERIFY(!list.at(2).isValid());
+    QCOMPARE(list.at(3), QVariant(qlonglong(42)));
+    QCOMPARE(list.at(4), QVariant(qlonglong(-7)));
+    QCOMPARE(list.at(5), QVariant(2.5));
+    QCOMPARE(list.at(6), QVariant(1000.0));
+    QCOMPARE(list.at(7), QVariant(9223372036854775808.0));
+}
+
+void OrderedJsonTests::testStrings()
+{
+    QVariantList list = OrderedJsonReader::parse(
+                "[\"plain\", \"a\\\"b\\\\c\\/d\\n\", \"\\u00e9\", "
+                "\"\\ud83d\\ude00\", \"\xc3\xa9\"]").toList();
+    QCOMPARE(list.at(0), QVariant(QString("plain")));
+    QCOMPARE(list.at(1), QVariant(QString("a\"b\\c/d\n")));
+    QCOMPARE(list.at(2), QVariant(QString::fromUtf8("\xc3\xa9")));
+    QCOMPARE(list.at(3), QVariant(QString::fromUtf8("\xf0\x9f\x98\x80")));
+    QCOMPARE(list.at(4), QVariant(QString::fromUtf8("\xc3\xa9")));
+}
+
+void OrderedJsonTests::testDuplicateKeys()
+{
+    // The last value wins, at the position of the first occurrence.
+    QVariant value = OrderedJsonReader::parse(
+                "{\"a\": 1, \"b\": 2, \"a\": 3}");
+    QCOMPARE(object(value).keys(), QList<QString>() << "a" << "b");
+    QCOMPARE(object(value).value("a"), QVariant(qlonglong(3)));
+}
+
+void OrderedJsonTests::testReadObject()
+{
+    QBuffer device;
+    device.setData("{\"b\": 1, \"a\": 2}");
+    device.open(QIODevice::ReadOnly);
+
+    OrderedVariantHash hash;
+    QVERIFY(OrderedJsonReader(&device).read(&hash));
+    QCOMPARE(hash.keys(), QList<QString>() << "b" << "a");
+
+    device.close();
+    device.setData("[1, 2]");
+    device.open(QIODevice::ReadOnly);
+    QJsonParseError error;
+    QVERIFY(!OrderedJsonReader(&device).read(&hash, &error));
+    QCOMPARE(error.error, QJsonParseError::MissingObject);
+    QVERIFY(hash.isEmpty());
+}
+
+void OrderedJsonTests::testErrors()
+{
+    QCOMPARE(parseError("{\"a\" 1}"), QJsonParseError::MissingNameSeparator);
+    QCOMPARE(parseError("{\"a\": 1 \"b\": 2}"),
+             QJsonParseError::MissingValueSeparator);
+    QCOMPARE(parseError("{\"a\": 1"), QJsonParseError::UnterminatedObject);
+    QCOMPARE(parseError("[1, 2"), QJsonParseError::UnterminatedArray);
+    QCOMPARE(parseError("[\"abc"), QJsonParseError::UnterminatedString);
+    QCOMPARE(parseError("[\"\\x\"]"), QJsonParseError::IllegalEscapeSequence);
+    QCOMPARE(parseError("[\"\\ud83d\"]"),
+             QJsonParseError::IllegalEscapeSequence);
+    QCOMPARE(parseError("[1.2.3]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[\"a\tb\"]"), QJsonParseError::IllegalValue);
+    QCOMPARE(parseError("{\"a\nb\": 1}"), QJsonParseError::IllegalValue);
+    QCOMPARE(parseError("[tru]"), QJsonParseError::IllegalValue);
+    QCOMPARE(parseError("{} {}"), QJsonParseError::GarbageAtEnd);
+    QCOMPARE(parseError(QByteArray(2000, '[')), QJsonParseError::DeepNesting);
+
+    QJsonParseError error;
+    OrderedJsonReader::parse("{\"a\": [1, x]}", &error);
+    QCOMPARE(error.offset, 10);
+}
+
+void OrderedJsonTests::testIllegalUtf8()
+{
+    const char *valid = "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+    QCOMPARE(OrderedJsonReader::parse(QByteArray("[\"") + valid + "\"]")
+             .toList().first(), QVariant(QString::fromUtf8(valid)));
+
+    // A stray continuation byte, overlong forms, a surrogate, a code point
+    // past U+10FFFF, and sequences cut short by the end of the string or an
+    // escape.
+    QCOMPARE(parseError("[\"\x80\"]"), QJsonParseError::IllegalUTF8String);
+    QCOMPARE(parseError("[\"\xC0\xAF\"]"), QJsonParseError::IllegalUTF8String);
+    QCOMPARE(parseError("[\"\xE0\x80\xAF\"]"),
+             QJsonParseError::IllegalUTF8String);
+    QCOMPARE(parseError("[\"\xED\xA0\x80\"]"),
+             QJsonParseError::IllegalUTF8String);
+    QCOMPARE(parseError("[\"\xF4\x90\x80\x80\"]"),
+             QJsonParseError::IllegalUTF8String);
+    QCOMPARE(parseError("[\"\xE2\x82\"]"), QJsonParseError::IllegalUTF8String);
+    QCOMPARE(parseError("[\"\xC3\\n\"]"), QJsonParseError::IllegalUTF8String);
+    QCOMPARE(parseError("{\"\xFF\": 1}"), QJsonParseError::IllegalUTF8String);
+
+    QJsonParseError error;
+    OrderedJsonReader::parse("[\"ab\xE2\x82x\"]", &error);
+    QCOMPARE(error.error, QJsonParseError::IllegalUTF8String);
+    QCOMPARE(error.offset, 6);
+
+    // Sequences split across the reader's buffer refills.
+    QByteArray json = "[\"" + QByteArray(65532, 'a') + "\xF0\x9F\x98\x80\"]";
+    QCOMPARE(OrderedJsonReader::parse(json).toList().first(),
+             QVariant(QString(65532, QLatin1Char('a'))
+                      + QString::fromUtf8("\xF0\x9F\x98\x80")));
+    json = "[\"" + QByteArray(65532, 'a') + "\xF0\x9F\x98x\"]";
+    OrderedJsonReader::parse(json, &error);
+    QCOMPARE(error.error, QJsonParseError::IllegalUTF8String);
+    QCOMPARE(error.offset, 65537);
+}
+
+void OrderedJsonTests::testNumbers()
+{
+    QVariantList list = OrderedJsonReader::parse(
+                "[0, -0, -12, 0.5, -1.25e+2, 3E-1]").toList();
+    QCOMPARE(list.size(), 6);
+    QCOMPARE(list.at(0), QVariant(qlonglong(0)));
+    QCOMPARE(list.at(1), QVariant(qlonglong(0)));
+    QCOMPARE(list.at(2), QVariant(qlonglong(-12)));
+    QCOMPARE(list.at(3), QVariant(0.5));
+    QCOMPARE(list.at(4), QVariant(-125.0));
+    QCOMPARE(list.at(5), QVariant(0.3));
+
+    // Rejected by QJsonDocument too.
+    QCOMPARE(parseError("[01]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[-01]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[1.]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[1.e5]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[-]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[1e]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[1e+]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[1-2]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[1e5.0]"), QJsonParseError::IllegalNumber);
+    QCOMPARE(parseError("[.5]"), QJsonParseError::IllegalValue);
+    QCOMPARE(parseError("[+1]"), QJsonParseError::IllegalValue);
+}
+
+void OrderedJsonTests::testLongDocument()
+{
+    // Keys and strings longer than the reader's buffer.
+    QString longKey(100000, QLatin1Char('k'));
+    QString longValue = QString(70000, QLatin1Char('v')) + "\n";
+    OrderedVariantHash hash;
+    for (int i = 0; i < 1000; i++)
+        hash.insert(QString::number(1000 - i), i);
+    hash.insert(longKey, longValue);
+
+    QByteArray json = OrderedJsonWriter::toJson(QVariant::fromValue(hash));
+    QVariant value = OrderedJsonReader::parse(json);
+    QCOMPARE(object(value).size(), 1001);
+    QCOMPARE(object(value).firstKey(), QString("1000"));
+    QCOMPARE(object(value).lastKey(), longKey);
+    QCOMPARE(object(value).last(), QVariant(longValue));
+}
+
+void OrderedJsonTests::testWriteCompact()
+{
+    OrderedVariantHash inner;
+    inner.insert("y", QVariant());
+    inner.insert("x", QVariantList() << true << 1.5);
+    OrderedVariantHash hash;
+    hash.insert("b", 1);
+    hash.insert("a", QVariant::fromValue(inner));
+
+    QCOMPARE(OrderedJsonWriter::toJson(QVariant::fromValue(hash),
+                                       OrderedJsonWriter::Compact),
+             QByteArray("{\"b\":1,\"a\":{\"y\":null,\"x\":[true,1.5]}}"));
+}
+
+void OrderedJsonTests::testWriteIndented()
+{
+    OrderedVariantHash hash;
+    hash.insert("b", QVariantList() << 1);
+    hash.insert("a", QVariant::fromValue(OrderedVariantHash()));
+
+    QBuffer device;
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(OrderedJsonWriter(&device).write(hash));
+    QCOMPARE(device.data(), QByteArray("{\n"
+                                       "    \"b\": [\n"
+                                       "        1\n"
+                                       "    ],\n"
+                                       "    \"a\": {}\n"
+                                       "}\n"));
+}
+
+void OrderedJsonTests::testWriteEscapes()
+{
+    QCOMPARE(OrderedJsonWriter::toJson(QString("a\"b\\c\n\x01"),
+                                       OrderedJsonWriter::Compact),
+             QByteArray("\"a\\\"b\\\\c\\n\\u0001\""));
+}
+
+void OrderedJsonTests::testRoundTrip()
+{
+    QByteArray json = "{\"z\":[1,2.5,\"s\",null,false,{}],"
+                      "\"a\":{\"q\":[],\"b\":\"\\u00e9\"}}";
+    QVariant value = OrderedJsonReader::parse(json);
+    QCOMPARE(OrderedJsonWriter::toJson(value, OrderedJsonWriter::Compact),
+             QByteArray("{\"z\":[1,2.5,\"s\",null,false,{}],"
+                        "\"a\":{\"q\":[],\"b\":\"\xc3\xa9\"}}"));
+}
@@ -0,0 +1,29 @@
+#ifndef ORDEREDJSONTESTS_H
+#define ORDEREDJSONTESTS_H
+
+#include <QtTest>
+#include "orderedjson.h"
+
+class OrderedJsonTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testKeyOrder();
+    void testNested();
+    void testScalars();
+    void testStrings();
+    void testDuplicateKeys();
+    void testReadObject();
+    void testErrors();
+    void testIllegalUtf8();
+    void testNumbers();
+    void testLongDocument();
+
+    void testWriteCompact();
+    void testWriteIndented();
+    void testWriteEscapes();
+    void testRoundTrip();
+};
+
+#endif  // ORDEREDJSONTESTS_H
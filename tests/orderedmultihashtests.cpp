@@ -0,0 +1,157 @@
+#include "orderedmultihashtests.h"
+
+void OrderedMultiHashTests::init()
+{
+    hash = qtcollections::OrderedMultiHash<QString, int>();
+    hash.insert("b", 1);
+    hash.insert("a", 2);
+    hash.insert("b", 3);
+    hash.insert("c", 4);
+    hash.insert("b", 5);
+}
+
+void OrderedMultiHashTests::testInitializerListConstructor()
+{
+    qtcollections::OrderedMultiHash<QString, int> expected({
+        {"b", 1}, {"a", 2}, {"b", 3}, {"c", 4}, {"b", 5},
+    });
+    QCOMPARE(hash, expected);
+}
+
+void OrderedMultiHashTests::testEqualityOperator()
+{
+    qtcollections::OrderedMultiHash<QString, int> other({
+        {"b", 1}, {"b", 3}, {"a", 2}, {"c", 4}, {"b", 5},
+    });
+    QVERIFY(hash != other);
+
+    hash.clear();
+    other.clear();
+    QVERIFY(hash == other);
+}
+
+void OrderedMultiHashTests::testSize()
+{
+    QCOMPARE(hash.size(), 5);
+    QCOMPARE(hash.uniqueCount(), 3);
+    QVERIFY(!hash.isEmpty());
+}
+
+void OrderedMultiHashTests::testCount()
+{
+    QCOMPARE(hash.count(), 5);
+    QCOMPARE(hash.count("b"), 3);
+    QCOMPARE(hash.count("d"), 0);
+}
+
+void OrderedMultiHashTests::testCountForKey()
+{
+    hash.insert("b", 3);
+    QCOMPARE(hash.count("b", 3), 2);
+    QCOMPARE(hash.count("b", 2), 0);
+}
+
+void OrderedMultiHashTests::testContains()
+{
+    QVERIFY(hash.contains("a"));
+    QVERIFY(!hash.contains("d"));
+    QVERIFY(hash.contains("b", 5));
+    QVERIFY(!hash.contains("b", 4));
+}
+
+void OrderedMultiHashTests::testValue()
+{
+    QCOMPARE(hash.value("b"), 1);
+    QCOMPARE(hash.value("d"), 0);
+    QCOMPARE(hash.value("d", -1), -1);
+}
+
+void OrderedMultiHashTests::testValuesForKey()
+{
+    QCOMPARE(hash.values("b"), QList<int>() << 1 << 3 << 5);
+    QCOMPARE(hash.values("a"), QList<int>() << 2);
+    QCOMPARE(hash.values("d"), QList<int>());
+}
+
+void OrderedMultiHashTests::testKeysAndValues()
+{
+    QCOMPARE(hash.keys(),
+             QList<QString>() << "b" << "a" << "b" << "c" << "b");
+    QCOMPARE(hash.values(), QList<int>() << 1 << 2 << 3 << 4 << 5);
+}
+
+void OrderedMultiHashTests::testUniqueKeys()
+{
+    QCOMPARE(hash.uniqueKeys(), QList<QString>() << "b" << "a" << "c");
+
+    hash.remove("a");
+    hash.insert("a", 6);
+    QCOMPARE(hash.uniqueKeys(), QList<QString>() << "b" << "c" << "a");
+}
+
+void OrderedMultiHashTests::testFind()
+{
+    auto it = hash.find("b");
+    QCOMPARE(it.value(), 1);
+    QCOMPARE((++it).key(), QString("a"));
+    QVERIFY(hash.find("d") == hash.end());
+    QVERIFY(hash.constFind("d") == hash.constEnd());
+}
+
+void OrderedMultiHashTests::testFindValue()
+{
+    auto it = hash.find("b", 3);
+    QCOMPARE(it.value(), 3);
+    QCOMPARE((++it).key(), QString("c"));
+    QVERIFY(hash.find("b", 4) == hash.end());
+}
+
+void OrderedMultiHashTests::testErase()
+{
+    auto it = hash.erase(hash.find("b", 3));
+    QCOMPARE(it.key(), QString("c"));
+    QCOMPARE(hash.values("b"), QList<int>() << 1 << 5);
+
+    hash.erase(hash.find("b", 5));
+    hash.insert("b", 6);
+    QCOMPARE(hash.values("b"), QList<int>() << 1 << 6);
+
+    hash.erase(hash.find("a"));
+    QVERIFY(!hash.contains("a"));
+    QCOMPARE(hash.values(), QList<int>() << 1 << 4 << 6);
+}
+
+void OrderedMultiHashTests::testRemove()
+{
+    QCOMPARE(hash.remove("b"), 3);
+    QCOMPARE(hash.remove("b"), 0);
+    QCOMPARE(hash.keys(), QList<QString>() << "a" << "c");
+}
+
+void OrderedMultiHashTests::testRemoveValue()
+{
+    hash.insert("b", 1);
+    QCOMPARE(hash.remove("b", 1), 2);
+    QCOMPARE(hash.values("b"), QList<int>() << 3 << 5);
+    QCOMPARE(hash.remove("a", 1), 0);
+}
+
+void OrderedMultiHashTests::testClear()
+{
+    hash.clear();
+    QVERIFY(hash.isEmpty());
+    QVERIFY(hash.uniqueKeys().isEmpty());
+}
+
+void OrderedMultiHashTests::testIteration()
+{
+    QList<int> forward;
+    foreach (int value, hash)
+        forward.append(value);
+    QCOMPARE(forward, QList<int>() << 1 << 2 << 3 << 4 << 5);
+
+    auto it = hash.constEnd();
+    --it;
+    QCOMPARE(it.key(), QString("b"));
+    QCOMPARE(*it, 5);
+}
@@ -0,0 +1,39 @@
+#ifndef ORDEREDMULTIHASHTESTS_H
+#define ORDEREDMULTIHASHTESTS_H
+
+#include <QtTest>
+#include "orderedmultihash.h"
+
+class OrderedMultiHashTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void testInitializerListConstructor();
+    void testEqualityOperator();
+
+    void testSize();
+    void testCount();
+    void testCountForKey();
+    void testContains();
+
+    void testValue();
+    void testValuesForKey();
+    void testKeysAndValues();
+    void testUniqueKeys();
+
+    void testFind();
+    void testFindValue();
+    void testErase();
+    void testRemove();
+    void testRemoveValue();
+    void testClear();
+
+    void testIteration();
+
+private:
+    qtcollections::OrderedMultiHash<QString, int> hash;
+};
+
+#endif  // ORDEREDMULTIHASHTESTS_H
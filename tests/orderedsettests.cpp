@@ -0,0 +1,155 @@
+#include "orderedsettests.h"
+
+typedef qtcollections::OrderedSet<int> IntSet;
+
+void OrderedSetTests::init()
+{
+    set = IntSet();
+    set << 3 << 1 << 4 << 1 << 5;
+}
+
+void OrderedSetTests::testInitializerListConstructor()
+{
+    QCOMPARE(set, IntSet({3, 1, 4, 5}));
+}
+
+void OrderedSetTests::testEqualityOperator()
+{
+    QVERIFY(set == IntSet({3, 1, 4, 5}));
+    QVERIFY(set != IntSet({1, 3, 4, 5}));
+}
+
+void OrderedSetTests::testInsert()
+{
+    QCOMPARE(set.size(), 4);
+    QCOMPARE(*set.insert(9), 9);
+    QCOMPARE(*set.insert(3), 3);
+    QCOMPARE(set.values(), QList<int>() << 3 << 1 << 4 << 5 << 9);
+}
+
+void OrderedSetTests::testRemove()
+{
+    QVERIFY(set.remove(1));
+    QVERIFY(!set.remove(1));
+    QCOMPARE(set.toList(), QList<int>() << 3 << 4 << 5);
+
+    set.insert(1);
+    QCOMPARE(set.toList(), QList<int>() << 3 << 4 << 5 << 1);
+}
+
+void OrderedSetTests::testContains()
+{
+    QVERIFY(set.contains(4));
+    QVERIFY(!set.contains(2));
+}
+
+void OrderedSetTests::testContainsSet()
+{
+    QVERIFY(set.contains(IntSet({5, 3})));
+    QVERIFY(!set.contains(IntSet({5, 2})));
+    QVERIFY(set.contains(IntSet()));
+}
+
+void OrderedSetTests::testIntersects()
+{
+    QVERIFY(set.intersects(IntSet({2, 5})));
+    QVERIFY(!set.intersects(IntSet({2, 6})));
+}
+
+void OrderedSetTests::testErase()
+{
+    auto it = set.erase(set.find(1));
+    QCOMPARE(*it, 4);
+    QCOMPARE(set.toList(), QList<int>() << 3 << 4 << 5);
+}
+
+void OrderedSetTests::testUnite()
+{
+    set.unite(IntSet({6, 1, 2}));
+    QCOMPARE(set.toList(), QList<int>() << 3 << 1 << 4 << 5 << 6 << 2);
+}
+
+void OrderedSetTests::testIntersect()
+{
+    set.intersect(IntSet({5, 2, 3}));
+    QCOMPARE(set.toList(), QList<int>() << 3 << 5);
+}
+
+void OrderedSetTests::testSubtract()
+{
+    set.subtract(IntSet({4, 2}));
+    QCOMPARE(set.toList(), QList<int>() << 3 << 1 << 5);
+
+    set.subtract(IntSet({0, 1, 2, 6, 7, 8, 9}));
+    QCOMPARE(set.toList(), QList<int>() << 3 << 5);
+
+    set.subtract(set);
+    QVERIFY(set.isEmpty());
+}
+
+void OrderedSetTests::testOperators()
+{
+    IntSet other({5, 9, 3});
+    QCOMPARE((set | other).toList(), QList<int>() << 3 << 1 << 4 << 5 << 9);
+    QCOMPARE((set & other).toList(), QList<int>() << 3 << 5);
+    QCOMPARE((set - other).toList(), QList<int>() << 1 << 4);
+    QCOMPARE((other - set).toList(), QList<int>() << 9);
+}
+
+void OrderedSetTests::testFirstAndLast()
+{
+    QCOMPARE(set.first(), 3);
+    QCOMPARE(set.last(), 5);
+}
+
+void OrderedSetTests::testTakeFirstAndLast()
+{
+    QCOMPARE(set.takeFirst(), 3);
+    QCOMPARE(set.takeLast(), 5);
+    QCOMPARE(set.toList(), QList<int>() << 1 << 4);
+}
+
+void OrderedSetTests::testIteration()
+{
+    QList<int> items;
+    foreach (int item, set)
+        items.append(item);
+    QCOMPARE(items, QList<int>() << 3 << 1 << 4 << 5);
+
+    auto it = set.constEnd();
+    QCOMPARE(*--it, 5);
+}
+
+void OrderedSetTests::testStringItems()
+{
+    qtcollections::OrderedSet<QString> strings({"b", "a", "c"});
+    strings << "a" << "d";
+    strings.remove("c");
+    strings.intersect(qtcollections::OrderedSet<QString>({"d", "b", "a"}));
+
+    QCOMPARE(strings.toList(), QList<QString>() << "b" << "a" << "d");
+    QCOMPARE(strings.takeFirst(), QString("b"));
+    QVERIFY(!strings.contains("b"));
+}
+
+void OrderedSetTests::testNodes()
+{
+    qtcollections::OrderedSet<QString> strings({"a", "b", "c"});
+    qtcollections::OrderedSet<QString> others({"d", "b"});
+    qtcollections::OrderedSet<QString>::Node node = strings.extract("c");
+    QVERIFY(!node.isEmpty());
+    QCOMPARE(node.key(), QString("c"));
+    QVERIFY(strings.extract("x").isEmpty());
+    QCOMPARE(*others.insert(node, others.find("b")), QString("c"));
+    QVERIFY(node.isEmpty());
+    QCOMPARE(others.toList(), QList<QString>() << "d" << "c" << "b");
+
+    QCOMPARE(strings.merge(others), 2);
+    QCOMPARE(strings.toList(),
+             QList<QString>() << "a" << "b" << "d" << "c");
+    QCOMPARE(others.toList(), QList<QString>() << "b");
+
+    IntSet::Node item = set.extract(1);
+    set.insert(item, set.constBegin());
+    QCOMPARE(set.values(), QList<int>() << 1 << 3 << 4 << 5);
+}
@@ -0,0 +1,39 @@
+#ifndef ORDEREDSETTESTS_H
+#define ORDEREDSETTESTS_H
+
+#include <QtTest>
+#include "orderedset.h"
+
+class OrderedSetTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void testInitializerListConstructor();
+    void testEqualityOperator();
+
+    void testInsert();
+    void testRemove();
+    void testContains();
+    void testContainsSet();
+    void testIntersects();
+    void testErase();
+
+    void testUnite();
+    void testIntersect();
+    void testSubtract();
+    void testOperators();
+
+    void testFirstAndLast();
+    void testTakeFirstAndLast();
+    void testIteration();
+
+    void testStringItems();
+    void testNodes();
+
+private:
+    qtcollections::OrderedSet<int> set;
+};
+
+#endif  // ORDEREDSETTESTS_H
@@ -1,5 +1,17 @@
 #include <QCoreApplication>
+#include "groupprobingtests.h"
+#include "hashpolicytests.h"
+#include "immutableorderedhashtests.h"
+#include "internedstringtests.h"
+#include "journaledorderedhashtests.h"
 #include "orderedhashtests.h"
+#include "orderedmultihashtests.h"
+#include "orderedsettests.h"
+#include "ttlorderedhashtests.h"
+#if QT_VERSION >= 0x050000
+#include "orderedhashmodeltests.h"
+#include "orderedjsontests.h"
+#endif
 
 #define RUN(klass, argc, argv) \
     { \
@@ -15,6 +27,18 @@ int main(int argc, char *argv[])
 
     int status = 0;
     RUN(OrderedHashTests, argc, argv)
+    RUN(InternedStringTests, argc, argv)
+    RUN(OrderedMultiHashTests, argc, argv)
+    RUN(OrderedSetTests, argc, argv)
+    RUN(ImmutableOrderedHashTests, argc, argv)
+#if QT_VERSION >= 0x050000
+    RUN(OrderedHashModelTests, argc, argv)
+    RUN(OrderedJsonTests, argc, argv)
+#endif
+    RUN(HashPolicyTests, argc, argv)
+    RUN(GroupProbingTests, argc, argv)
+    RUN(TtlOrderedHashTests, argc, argv)
+    RUN(JournaledOrderedHashTests, argc, argv)
     return status;
 }
 
@@ -16,10 +16,41 @@ PRECOMPILED_HEADER += qtcollectionstest.h
 
 INCLUDEPATH += $$PWD/../src
 
+# Link to the instantiations built into the library instead of repeating
+# them.
+LIBS += -L$$OUT_PWD/$$DESTDIR -lqtcollections
+unix:QMAKE_RPATHDIR += $$OUT_PWD/$$DESTDIR
+DEFINES += QTCOLLECTIONS_EXTERN_TEMPLATES
+
 SOURCES += \
     test_main.cpp \
-    orderedhashtests.cpp
+    orderedhashtests.cpp \
+    internedstringtests.cpp \
+    orderedmultihashtests.cpp \
+    orderedsettests.cpp \
+    immutableorderedhashtests.cpp \
+    hashpolicytests.cpp \
+    groupprobingtests.cpp \
+    ttlorderedhashtests.cpp \
+    journaledorderedhashtests.cpp
 
 HEADERS += \
     orderedhashtests.h \
+    internedstringtests.h \
+    orderedmultihashtests.h \
+    orderedsettests.h \
+    immutableorderedhashtests.h \
+    hashpolicytests.h \
+    groupprobingtests.h \
+    ttlorderedhashtests.h \
+    journaledorderedhashtests.h \
     qtcollectionstest.h
+
+greaterThan(QT_MAJOR_VERSION, 4) {
+    SOURCES += \
+        orderedhashmodeltests.cpp \
+        orderedjsontests.cpp
+    HEADERS += \
+        orderedhashmodeltests.h \
+        orderedjsontests.h
+}
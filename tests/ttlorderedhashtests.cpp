@@ -0,0 +1,290 @@
+#include "ttlorderedhashtests.h"
+
+typedef qtcollections::TtlOrderedHash<QString, int> Cache;
+
+namespace
+{
+
+qint64 currentTime = 0;
+
+qint64 fakeClock()
+{
+    return currentTime;
+}
+
+Cache *newCache(qint64 ttl,
+                Cache::ExpiryPolicy policy = Cache::ExpireAfterWrite)
+{
+    Cache *cache = new Cache(ttl, policy);
+    cache->setClock(&fakeClock);
+    return cache;
+}
+
+struct Collector
+{
+    QStringList keys;
+    inline void operator()(const QString &key, int) { keys << key; }
+};
+
+}   // namespace
+
+void TtlOrderedHashTests::init()
+{
+    currentTime = 1000;
+}
+
+void TtlOrderedHashTests::testLazyExpiry()
+{
+    QScopedPointer<Cache> cache(newCache(100));
+    cache->insert("a", 1);
+    currentTime += 99;
+    QCOMPARE(cache->value("a"), 1);
+    QCOMPARE(cache->remainingTtl("a"), qint64(1));
+
+    currentTime += 1;
+    QCOMPARE(cache->remainingTtl("a"), qint64(-1));
+    QCOMPARE(cache->keys(), QStringList());
+    QCOMPARE(cache->size(), 1);
+    QVERIFY(!cache->contains("a"));
+    QCOMPARE(cache->size(), 0);
+    QCOMPARE(cache->value("a", -1), -1);
+}
+
+void TtlOrderedHashTests::testExpireAfterInsert()
+{
+    QScopedPointer<Cache> cache(newCache(100, Cache::ExpireAfterInsert));
+    cache->insert("a", 1);
+    cache->insert("b", 2);
+    currentTime += 50;
+    cache->insert("a", 3);
+    QCOMPARE(cache->keys(), QStringList() << "a" << "b");
+    QCOMPARE(cache->remainingTtl("a"), qint64(50));
+
+    currentTime += 50;
+    QCOMPARE(cache->expire(), 2);
+    QVERIFY(cache->isEmpty());
+}
+
+void TtlOrderedHashTests::testExpireAfterWrite()
+{
+    QScopedPointer<Cache> cache(newCache(100));
+    cache->insert("a", 1);
+    cache->insert("b", 2);
+    currentTime += 50;
+    cache->insert("a", 3);
+    QCOMPARE(cache->keys(), QStringList() << "b" << "a");
+
+    // Reads do not count as writes.
+    QCOMPARE(cache->value("b"), 2);
+    currentTime += 50;
+    QCOMPARE(cache->expire(), 1);
+    QCOMPARE(cache->keys(), QStringList() << "a");
+    QCOMPARE(cache->value("a"), 3);
+}
+
+void TtlOrderedHashTests::testExpireAfterAccess()
+{
+    QScopedPointer<Cache> cache(newCache(100, Cache::ExpireAfterAccess));
+    cache->insert("a", 1);
+    cache->insert("b", 2);
+    currentTime += 50;
+    QCOMPARE(cache->value("a"), 1);
+    QCOMPARE(cache->keys(), QStringList() << "b" << "a");
+
+    currentTime += 50;
+    QCOMPARE(cache->expire(), 1);
+    QCOMPARE(cache->remainingTtl("a"), qint64(50));
+}
+
+void TtlOrderedHashTests::testTouch()
+{
+    QScopedPointer<Cache> cache(newCache(100, Cache::ExpireAfterInsert));
+    cache->insert("a", 1);
+    cache->insert("b", 2);
+    currentTime += 60;
+    QVERIFY(cache->touch("a"));
+    QVERIFY(!cache->touch("c"));
+    QCOMPARE(cache->keys(), QStringList() << "b" << "a");
+
+    currentTime += 40;
+    QCOMPARE(cache->expire(), 1);
+    QCOMPARE(cache->keys(), QStringList() << "a");
+    currentTime += 60;
+    QVERIFY(!cache->touch("a"));
+    QVERIFY(cache->isEmpty());
+}
+
+void TtlOrderedHashTests::testSweep()
+{
+    QScopedPointer<Cache> cache(newCache(1000));
+    for (int i = 0; i < 100; i++)
+    {
+        cache->insert(QString::number(i), i);
+        currentTime += 10;
+    }
+    // Entries 0 to 49 were inserted 1000 ms ago or more.
+    currentTime += 490;
+    QCOMPARE(cache->expire(), 50);
+    QCOMPARE(cache->size(), 50);
+    QCOMPARE(cache->keys().first(), QString("50"));
+    QCOMPARE(cache->expire(), 0);
+
+    currentTime += 10000;
+    QCOMPARE(cache->expire(), 50);
+    QVERIFY(cache->isEmpty());
+}
+
+void TtlOrderedHashTests::testSweepSink()
+{
+    QScopedPointer<Cache> cache(newCache(100));
+    cache->insert("a", 1);
+    cache->insert("b", 2, 50);
+    cache->insert("c", 3);
+    cache->remove("c");
+    currentTime += 100;
+
+    Collector collector;
+    QCOMPARE(cache->expire(collector), 2);
+    collector.keys.sort();
+    QCOMPARE(collector.keys, QStringList() << "a" << "b");
+}
+
+void TtlOrderedHashTests::testCustomTtl()
+{
+    QScopedPointer<Cache> cache(newCache(1000));
+    cache->insert("long", 1, 5000);
+    cache->insert("default", 2);
+    cache->insert("short", 3, 10);
+    QCOMPARE(cache->keys(), QStringList() << "long" << "default" << "short");
+
+    currentTime += 10;
+    QCOMPARE(cache->expire(), 1);
+    QVERIFY(!cache->contains("short"));
+
+    currentTime += 990;
+    QCOMPARE(cache->expire(), 1);
+    QCOMPARE(cache->keys(), QStringList() << "long");
+    QCOMPARE(cache->remainingTtl("long"), qint64(4000));
+
+    // Writing with the default TTL puts the entry back in the queue.
+    cache->insert("long", 4);
+    currentTime += 999;
+    QCOMPARE(cache->expire(), 0);
+    currentTime += 1;
+    QCOMPARE(cache->expire(), 1);
+    QVERIFY(cache->isEmpty());
+}
+
+void TtlOrderedHashTests::testCustomTtlLongerThanWheel()
+{
+    // The wheel turns once per default TTL; these need several turns.
+    QScopedPointer<Cache> cache(newCache(256));
+    for (int i = 0; i < 20; i++)
+        cache->insert(QString::number(i), i, 1000 + i * 100);
+    int expired = 0;
+    for (int t = 1; t <= 3000; t++)
+    {
+        currentTime++;
+        expired += cache->expire();
+        QCOMPARE(cache->size(), 20 - expired);
+        for (int i = expired; i < 20; i++)
+            QVERIFY(cache->remainingTtl(QString::number(i)) > 0);
+    }
+    QCOMPARE(expired, 20);
+}
+
+void TtlOrderedHashTests::testCustomTtlAfterInsert()
+{
+    // Updates keep the deadline, whatever TTL they come with.
+    QScopedPointer<Cache> cache(newCache(100, Cache::ExpireAfterInsert));
+    cache->insert("a", 1);
+    cache->insert("b", 2, 300);
+    currentTime += 50;
+    cache->insert("a", 3, 500);
+    cache->insert("b", 4, 100);
+    cache->insert("b", 5);
+    QCOMPARE(cache->keys(), QStringList() << "a" << "b");
+    QCOMPARE(cache->remainingTtl("a"), qint64(50));
+    QCOMPARE(cache->remainingTtl("b"), qint64(250));
+    QCOMPARE(cache->value("b"), 5);
+
+    currentTime += 50;
+    QCOMPARE(cache->expire(), 1);
+    currentTime += 200;
+    QCOMPARE(cache->expire(), 1);
+    QVERIFY(cache->isEmpty());
+}
+
+void TtlOrderedHashTests::testExplicitDefaultTtl()
+{
+    // An explicit TTL equal to the default replaces an entry's own TTL.
+    QScopedPointer<Cache> cache(newCache(100));
+    cache->insert("a", 1, 5000);
+    cache->insert("b", 2, 100);
+    currentTime += 50;
+    cache->insert("a", 3, 100);
+    QCOMPARE(cache->keys(), QStringList() << "b" << "a");
+    QCOMPARE(cache->remainingTtl("a"), qint64(100));
+
+    currentTime += 50;
+    QCOMPARE(cache->expire(), 1);
+    currentTime += 50;
+    QCOMPARE(cache->expire(), 1);
+    QVERIFY(cache->isEmpty());
+}
+
+void TtlOrderedHashTests::testCustomTtlAfterAccess()
+{
+    // Reads reset each entry by its own TTL.
+    QScopedPointer<Cache> cache(newCache(100, Cache::ExpireAfterAccess));
+    cache->insert("a", 1, 500);
+    cache->insert("b", 2);
+    currentTime += 90;
+    QCOMPARE(cache->value("a"), 1);
+    QCOMPARE(cache->value("b"), 2);
+    QCOMPARE(cache->remainingTtl("a"), qint64(500));
+    QCOMPARE(cache->remainingTtl("b"), qint64(100));
+
+    currentTime += 100;
+    QCOMPARE(cache->expire(), 1);
+    QCOMPARE(cache->keys(), QStringList() << "a");
+    currentTime += 400;
+    QCOMPARE(cache->expire(), 1);
+    QVERIFY(cache->isEmpty());
+}
+
+void TtlOrderedHashTests::testNextExpiry()
+{
+    QScopedPointer<Cache> cache(newCache(1000));
+    QCOMPARE(cache->msecsToNextExpiry(), qint64(-1));
+
+    cache->insert("a", 1);
+    QCOMPARE(cache->msecsToNextExpiry(), qint64(1000));
+    cache->insert("b", 2, 300);
+    QVERIFY(cache->msecsToNextExpiry() <= 300);
+
+    // Driving the sweeps as a QTimer would.
+    int expired = 0;
+    while (cache->msecsToNextExpiry() >= 0)
+    {
+        currentTime += cache->msecsToNextExpiry();
+        expired += cache->expire();
+    }
+    QCOMPARE(expired, 2);
+    QCOMPARE(currentTime, qint64(2000));
+}
+
+void TtlOrderedHashTests::testStaleRecords()
+{
+    QScopedPointer<Cache> cache(newCache(1000));
+    for (int i = 0; i < 10000; i++)
+    {
+        cache->insert(QString::number(i % 10), i);
+        currentTime++;
+    }
+    QCOMPARE(cache->size(), 10);
+    QCOMPARE(cache->keys().first(), QString("0"));
+    currentTime += 998;
+    QCOMPARE(cache->expire(), 9);
+    QCOMPARE(cache->keys(), QStringList() << "9");
+}
@@ -0,0 +1,30 @@
+#ifndef TTLORDEREDHASHTESTS_H
+#define TTLORDEREDHASHTESTS_H
+
+#include <QtTest>
+#include "ttlorderedhash.h"
+
+class TtlOrderedHashTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void testLazyExpiry();
+    void testExpireAfterInsert();
+    void testExpireAfterWrite();
+    void testExpireAfterAccess();
+    void testTouch();
+    void testSweep();
+    void testSweepSink();
+    void testCustomTtl();
+    void testCustomTtlLongerThanWheel();
+    void testCustomTtlAfterInsert();
+    void testExplicitDefaultTtl();
+    void testCustomTtlAfterAccess();
+    void testNextExpiry();
+    void testStaleRecords();
+};
+
+#endif  // TTLORDEREDHASHTESTS_H